@@ -16,8 +16,12 @@ public class Main extends JFrame implements ActionListener, NetworkManager.Netwo
     private JTextField hostField, portField, usernameField;
     private JPasswordField passwordField;
     private JButton connectButton, disconnectButton, authButton;
+    private JCheckBox binaryCheckBox;
     private JButton speedUpButton, slowDownButton, turnLeftButton, turnRightButton;
-    private JButton getDataButton, listUsersButton;
+    private JButton getDataButton, listUsersButton, subscribeButton;
+    private JSpinner rateSpinner;
+    private JCheckBox deltaCheckBox;
+    private JSpinner vehicleSpinner;
     private JLabel speedLabel, batteryLabel, temperatureLabel, directionLabel;
     private JTextArea logArea;
     private JList<String> usersList;
@@ -96,6 +100,10 @@ public class Main extends JFrame implements ActionListener, NetworkManager.Netwo
         disconnectButton.setEnabled(false);
         panel.add(disconnectButton, gbc);
         
+        gbc.gridx = 6;
+        binaryCheckBox = new JCheckBox("Binary protocol");
+        panel.add(binaryCheckBox, gbc);
+        
         // Connection status
         gbc.gridx = 0; gbc.gridy = 1;
         panel.add(new JLabel("Estado:"), gbc);
@@ -158,7 +166,7 @@ public class Main extends JFrame implements ActionListener, NetworkManager.Netwo
         panel.add(dataPanel, BorderLayout.NORTH);
         
         // Control panel
-        JPanel controlPanel = new JPanel(new GridLayout(2, 3, 10, 10));
+        JPanel controlPanel = new JPanel(new GridLayout(4, 3, 10, 10));
         controlPanel.setBorder(BorderFactory.createTitledBorder("Controls"));
         
         getDataButton = new JButton("Request Data");
@@ -190,6 +198,25 @@ public class Main extends JFrame implements ActionListener, NetworkManager.Netwo
         listUsersButton.setEnabled(false);
         controlPanel.add(listUsersButton);
         
+        // Telemetry stream at the chosen rate (0 = only the periodic broadcast)
+        controlPanel.add(new JLabel("Rate (Hz):"));
+        rateSpinner = new JSpinner(new SpinnerNumberModel(10, 0, 100, 1));
+        controlPanel.add(rateSpinner);
+        
+        subscribeButton = new JButton("Subscribe");
+        subscribeButton.addActionListener(this);
+        subscribeButton.setEnabled(false);
+        controlPanel.add(subscribeButton);
+        
+        // Only changed fields, with a full frame every 10 s
+        deltaCheckBox = new JCheckBox("Delta");
+        controlPanel.add(deltaCheckBox);
+        
+        // Fleet vehicle that is queried and controlled (subscriptions follow vehicle 0)
+        controlPanel.add(new JLabel("Vehicle:"));
+        vehicleSpinner = new JSpinner(new SpinnerNumberModel(0, 0, 16777215, 1));
+        controlPanel.add(vehicleSpinner);
+        
         panel.add(controlPanel, BorderLayout.CENTER);
         
         return panel;
@@ -248,15 +275,17 @@ public class Main extends JFrame implements ActionListener, NetworkManager.Netwo
         } else if (source == authButton) {
             authenticate();
         } else if (source == getDataButton) {
-            networkManager.requestData();
+            networkManager.requestData(selectedVehicle());
+        } else if (source == subscribeButton) {
+            networkManager.subscribe((Integer) rateSpinner.getValue(), deltaCheckBox.isSelected());
         } else if (source == speedUpButton) {
-            networkManager.sendVehicleCommand("SPEED_UP");
+            networkManager.sendVehicleCommand("SPEED_UP", selectedVehicle());
         } else if (source == slowDownButton) {
-            networkManager.sendVehicleCommand("SLOW_DOWN");
+            networkManager.sendVehicleCommand("SLOW_DOWN", selectedVehicle());
         } else if (source == turnLeftButton) {
-            networkManager.sendVehicleCommand("TURN_LEFT");
+            networkManager.sendVehicleCommand("TURN_LEFT", selectedVehicle());
         } else if (source == turnRightButton) {
-            networkManager.sendVehicleCommand("TURN_RIGHT");
+            networkManager.sendVehicleCommand("TURN_RIGHT", selectedVehicle());
         } else if (source == listUsersButton) {
             networkManager.requestUsersList();
         }
@@ -273,7 +302,7 @@ public class Main extends JFrame implements ActionListener, NetworkManager.Netwo
         
         try {
             int port = Integer.parseInt(portText);
-            networkManager.connect(host, port);
+            networkManager.connect(host, port, binaryCheckBox.isSelected());
         } catch (NumberFormatException e) {
             showMessage("Error", "Puerto inválido", JOptionPane.ERROR_MESSAGE);
         }
@@ -329,7 +358,10 @@ public class Main extends JFrame implements ActionListener, NetworkManager.Netwo
     @Override
     public void onDataReceived(String message) {
         SwingUtilities.invokeLater(() -> {
-            logMessage("Recibido: " + message);
+            // A subscription can stream 100 frames per second; only the display shows them
+            if (!message.startsWith("DATA:") || networkManager.getSubscribedRate() == 0) {
+                logMessage("Recibido: " + message);
+            }
             processServerMessage(message);
         });
     }
@@ -342,9 +374,16 @@ public class Main extends JFrame implements ActionListener, NetworkManager.Netwo
         });
     }
     
+    private int selectedVehicle() {
+        return (Integer) vehicleSpinner.getValue();
+    }
+    
     private void processServerMessage(String message) {
         if (message.startsWith("DATA:")) {
-            // Procesar datos de telemetría
+            // Procesar datos de telemetría, solo del vehículo elegido
+            if (WireCodec.messageVehicle(message) != selectedVehicle()) {
+                return;
+            }
             String[] parts = message.split("\\s+");
             vehicleData.updateFromServerData(parts);
             updateVehicleDisplay();
@@ -375,12 +414,14 @@ public class Main extends JFrame implements ActionListener, NetworkManager.Netwo
             disconnectButton.setEnabled(true);
             authButton.setEnabled(true);
             getDataButton.setEnabled(true);
+            subscribeButton.setEnabled(true);
         } else {
             statusLabel.setText("Desconectado");
             connectButton.setEnabled(true);
             disconnectButton.setEnabled(false);
             authButton.setEnabled(false);
             getDataButton.setEnabled(false);
+            subscribeButton.setEnabled(false);
             updateAdminControls(false);
             authLabel.setText("No autenticado");
         }
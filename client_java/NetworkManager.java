@@ -10,13 +10,20 @@ import java.util.concurrent.atomic.AtomicBoolean;
 
 public class NetworkManager {
     private Socket socket;
-    private BufferedReader in;
+    private DataInputStream in;
+    private OutputStream rawOut;
     private PrintWriter out;
     private AtomicBoolean connected = new AtomicBoolean(false);
     private AtomicBoolean authenticated = new AtomicBoolean(false);
     private AtomicBoolean isAdmin = new AtomicBoolean(false);
     private String username = "";
     private Thread receiveThread;
+    private volatile boolean binary = false;         // commands are sent as frames
+    private volatile boolean binaryReceive = false;  // server confirmed the switch
+    private volatile int subscribedRate = 0;         // telemetry Hz confirmed by the server
+    private volatile boolean subscribedDelta = false; // server sends only changed fields
+    private WireCodec.Frame telemetry = null;        // last full frame, base for deltas
+    private WireCodec codec = new WireCodec();
     
     // Callbacks for network events
     public interface NetworkEventListener {
@@ -35,15 +42,34 @@ public class NetworkManager {
     }
     
     public boolean connect(String host, int port) {
+        return connect(host, port, false);
+    }
+    
+    // With binary set, negotiates the binary protocol right after connecting
+    public boolean connect(String host, int port, boolean useBinary) {
         try {
             socket = new Socket(host, port);
-            in = new BufferedReader(new InputStreamReader(socket.getInputStream()));
-            out = new PrintWriter(socket.getOutputStream(), true);
+            in = new DataInputStream(new BufferedInputStream(socket.getInputStream()));
+            rawOut = socket.getOutputStream();
+            out = new PrintWriter(rawOut, true);
             
             connected.set(true);
             username = "";
             authenticated.set(false);
             isAdmin.set(false);
+            binary = false;
+            binaryReceive = false;
+            subscribedRate = 0;
+            subscribedDelta = false;
+            telemetry = null;
+            codec = new WireCodec();
+            
+            if (useBinary) {
+                // The server switches right after this message, so everything
+                // sent from here on is framed; replies switch once it confirms
+                sendCommand("PROTOCOL: BINARY " + WireCodec.VERSION);
+                binary = true;
+            }
             
             // Start thread to receive messages
             receiveThread = new Thread(this::receiveMessages);
@@ -99,17 +125,30 @@ public class NetworkManager {
         sendCommand("AUTH: " + username + " " + password);
     }
     
-    public void requestData() {
+    // Telemetry of one vehicle of the fleet
+    public void requestData(int vehicle) {
         if (!connected.get()) {
             if (listener != null) {
                 listener.onError("No connection to server");
             }
             return;
         }
-        sendCommand("GET_DATA:");
+        sendCommand("GET_DATA: " + vehicle);
     }
     
-    public void sendVehicleCommand(String command) {
+    // Stream telemetry at hz frames per second; 0 goes back to the periodic broadcast.
+    // With delta the server only sends the fields that changed.
+    public void subscribe(int hz, boolean delta) {
+        if (!connected.get()) {
+            if (listener != null) {
+                listener.onError("No connection to server");
+            }
+            return;
+        }
+        sendCommand("SUBSCRIBE: " + hz + (delta ? " DELTA" : ""));
+    }
+    
+    public void sendVehicleCommand(String command, int vehicle) {
         if (!connected.get()) {
             if (listener != null) {
                 listener.onError("No connection to server");
@@ -124,7 +163,7 @@ public class NetworkManager {
             return;
         }
         
-        sendCommand("SEND_CMD: " + command);
+        sendCommand("SEND_CMD: " + vehicle + " " + command);
     }
     
     public void requestUsersList() {
@@ -145,12 +184,40 @@ public class NetworkManager {
         sendCommand("LIST_USERS:");
     }
     
-    private void sendCommand(String command) {
-        if (out != null) {
-            String timestamp = LocalDateTime.now().format(DateTimeFormatter.ofPattern("yyyy-MM-dd HH:mm:ss"));
-            String message = command + "\r\nUSER: " + username + "\r\nTIMESTAMP: " + timestamp + "\r\n\r\n";
-            out.println(message);
+    private synchronized void sendCommand(String command) {
+        if (out == null) return;
+        
+        if (binary) {
+            try {
+                rawOut.write(WireCodec.encodeCommand(command));
+                rawOut.flush();
+            } catch (IOException e) {
+                if (listener != null) {
+                    listener.onError("Error enviando comando: " + e.getMessage());
+                }
+            }
+            return;
+        }
+        
+        String timestamp = LocalDateTime.now().format(DateTimeFormatter.ofPattern("yyyy-MM-dd HH:mm:ss"));
+        String message = command + "\r\nUSER: " + username + "\r\nTIMESTAMP: " + timestamp + "\r\n\r\n";
+        // No trailing newline: after a PROTOCOL switch it would be read as a frame
+        out.print(message);
+        out.flush();
+    }
+    
+    // Reads one text line from the byte stream, without its line break
+    private String readLine() throws IOException {
+        ByteArrayOutputStream line = new ByteArrayOutputStream();
+        int b;
+        while ((b = in.read()) != -1 && b != '\n') {
+            line.write(b);
         }
+        if (b == -1 && line.size() == 0) return null;
+        
+        byte[] bytes = line.toByteArray();
+        int length = bytes.length > 0 && bytes[bytes.length - 1] == '\r' ? bytes.length - 1 : bytes.length;
+        return new String(bytes, 0, length, "UTF-8");
     }
     
     private void receiveMessages() {
@@ -158,15 +225,30 @@ public class NetworkManager {
             String line;
             StringBuilder message = new StringBuilder();
             
-            while (connected.get() && (line = in.readLine()) != null) {
+            while (connected.get() && !binaryReceive && (line = readLine()) != null) {
                 if (line.trim().isEmpty()) {
                     // Fin del mensaje
-                    processServerMessage(message.toString());
+                    if (message.length() > 0) {
+                        processServerMessage(message.toString());
+                    }
                     message = new StringBuilder();
                 } else {
                     message.append(line).append("\n");
                 }
             }
+            
+            // Lo que sigue a la confirmación ya son tramas binarias
+            while (connected.get() && binaryReceive) {
+                WireCodec.Frame frame = codec.readFrame(in);
+                if (frame.type == WireCodec.FRAME_DELTA) {
+                    applyDelta(frame);
+                } else {
+                    if (frame.type == WireCodec.FRAME_TELEMETRY && frame.vehicle == WireCodec.STREAM_VEHICLE) {
+                        telemetry = frame;
+                    }
+                    processServerMessage(frame.toMessage());
+                }
+            }
         } catch (IOException e) {
             if (connected.get() && listener != null) {
                 listener.onError("Error recibiendo mensajes: " + e.getMessage());
@@ -175,11 +257,43 @@ public class NetworkManager {
         }
     }
     
+    // Aplica los campos cambiados a la última trama completa; un heartbeat
+    // (sin campos) no genera mensaje
+    private void applyDelta(WireCodec.Frame delta) {
+        if (delta.tag == 0 || telemetry == null) {
+            return;
+        }
+        WireCodec.applyDelta(telemetry, delta);
+        processServerMessage(telemetry.toMessage());
+    }
+    
     private void processServerMessage(String message) {
+        if (message.startsWith("DELTA:")) {
+            // Solo campos cambiados: el listener recibe la trama completa
+            applyDelta(WireCodec.parseDelta(message));
+            return;
+        }
+        if (message.startsWith("DATA:") && WireCodec.messageVehicle(message) == WireCodec.STREAM_VEHICLE) {
+            // Los deltas son del vehículo del stream; GET_DATA de otro no los afecta
+            telemetry = WireCodec.parseData(message);
+        }
+        
         if (listener != null) {
             listener.onDataReceived(message);
         }
         
+        if (message.startsWith("OK: Protocol BINARY")) {
+            binaryReceive = true;
+        } else if (message.startsWith("ERROR: Unsupported protocol")) {
+            binary = false;
+        } else if (message.startsWith("OK: Subscribed at ")) {
+            subscribedRate = Integer.parseInt(message.split("\\s+")[3]);
+            subscribedDelta = message.trim().endsWith("(delta)");
+        } else if (message.startsWith("OK: Unsubscribed")) {
+            subscribedRate = 0;
+            subscribedDelta = message.trim().endsWith("(delta)");
+        }
+        
         if (message.startsWith("AUTH_SUCCESS")) {
             authenticated.set(true);
             isAdmin.set(true);
@@ -200,4 +314,8 @@ public class NetworkManager {
     public boolean isAuthenticated() { return authenticated.get(); }
     public boolean isAdmin() { return isAdmin.get(); }
     public String getUsername() { return username; }
+    public boolean isBinary() { return binaryReceive; }
+    public int getSubscribedRate() { return subscribedRate; }
+    public boolean isSubscribedDelta() { return subscribedDelta; }
+    public WireCodec getCodec() { return codec; }
 }
@@ -0,0 +1,175 @@
+/**
+ * Binary wire protocol (server/wire.h)
+ * Frame encoding and decoding for connections that sent "PROTOCOL: BINARY 1".
+ * All integers are little-endian.
+ */
+import java.io.DataInputStream;
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
+
+public class WireCodec {
+    public static final int VERSION = 1;
+    public static final int HEADER_SIZE = 4;
+    public static final int TELEMETRY_PAYLOAD = 16;
+
+    public static final int FRAME_COMMAND = 1;
+    public static final int FRAME_RESPONSE = 2;
+    public static final int FRAME_TELEMETRY = 3;
+    public static final int FRAME_DELTA = 4;
+
+    // Delta frame tag: which fields follow, in TELEMETRY order
+    public static final int DELTA_SPEED = 0x01;
+    public static final int DELTA_BATTERY = 0x02;
+    public static final int DELTA_TEMPERATURE = 0x04;
+    public static final int DELTA_DIRECTION = 0x08;
+
+    private static final String[] VERBS = {
+        "", "AUTH", "GET_DATA", "SEND_CMD", "LIST_USERS", "RECHARGE", "DISCONNECT", "PROTOCOL", "SUBSCRIBE"
+    };
+    private static final String[] DIRECTIONS = {"STRAIGHT", "LEFT", "RIGHT"};
+    public static final int STREAM_VEHICLE = 0;  // vehicle of the broadcast and subscriptions
+
+    // One received frame: telemetry fields, the changed fields of a delta
+    // (tag says which) or response text
+    public static class Frame {
+        public int type;
+        public int tag;
+        public String text;
+        public int speed, battery, temperature;
+        public String direction;
+        public int vehicle;
+        public long timestamp;
+
+        // Same text the server sends in text mode, for code that expects it
+        public String toMessage() {
+            if (text == null) {
+                return "DATA: " + speed + " " + battery + " " + temperature + " " + direction + "\nVEHICLE: " + vehicle;
+            }
+            return text;
+        }
+    }
+
+    // Counters for measuring the protocol
+    private long frames = 0;
+    private long bytes = 0;
+    private long decodeNanos = 0;
+
+    /** Turns a text command ("SEND_CMD: SPEED_UP") into a COMMAND frame */
+    public static byte[] encodeCommand(String command) {
+        int colon = command.indexOf(':');
+        String verb = colon >= 0 ? command.substring(0, colon).trim() : command.trim();
+        String args = colon >= 0 ? command.substring(colon + 1).trim() : "";
+
+        int opcode = 0;
+        for (int i = 1; i < VERBS.length; i++) {
+            if (VERBS[i].equals(verb)) {
+                opcode = i;
+                break;
+            }
+        }
+
+        byte[] payload = args.getBytes(StandardCharsets.UTF_8);
+        ByteBuffer frame = ByteBuffer.allocate(HEADER_SIZE + payload.length).order(ByteOrder.LITTLE_ENDIAN);
+        frame.put((byte) FRAME_COMMAND).put((byte) opcode).putShort((short) payload.length).put(payload);
+        return frame.array();
+    }
+
+    /** Reads one whole frame; blocks until it has arrived */
+    public Frame readFrame(DataInputStream in) throws IOException {
+        byte[] header = new byte[HEADER_SIZE];
+        in.readFully(header);
+        int length = (header[2] & 0xFF) | ((header[3] & 0xFF) << 8);
+        byte[] payload = new byte[length];
+        in.readFully(payload);
+
+        long start = System.nanoTime();
+        Frame frame = new Frame();
+        frame.type = header[0] & 0xFF;
+        frame.tag = header[1] & 0xFF;
+        if (frame.type == FRAME_TELEMETRY && length >= TELEMETRY_PAYLOAD) {
+            ByteBuffer fields = ByteBuffer.wrap(payload).order(ByteOrder.LITTLE_ENDIAN);
+            frame.speed = fields.getShort(0) & 0xFFFF;
+            frame.battery = fields.get(2) & 0xFF;
+            frame.temperature = fields.get(3);
+            int direction = fields.get(4) & 0xFF;
+            frame.direction = direction < DIRECTIONS.length ? DIRECTIONS[direction] : "STRAIGHT";
+            frame.vehicle = (fields.get(5) & 0xFF) | ((fields.get(6) & 0xFF) << 8) | ((fields.get(7) & 0xFF) << 16);
+            frame.timestamp = fields.getLong(8);
+        } else if (frame.type == FRAME_DELTA) {
+            ByteBuffer fields = ByteBuffer.wrap(payload).order(ByteOrder.LITTLE_ENDIAN);
+            int offset = 0;
+            if ((frame.tag & DELTA_SPEED) != 0) {
+                frame.speed = fields.getShort(offset) & 0xFFFF;
+                offset += 2;
+            }
+            if ((frame.tag & DELTA_BATTERY) != 0) frame.battery = fields.get(offset++) & 0xFF;
+            if ((frame.tag & DELTA_TEMPERATURE) != 0) frame.temperature = fields.get(offset++);
+            if ((frame.tag & DELTA_DIRECTION) != 0) {
+                int direction = fields.get(offset++) & 0xFF;
+                frame.direction = direction < DIRECTIONS.length ? DIRECTIONS[direction] : "STRAIGHT";
+            }
+        } else {
+            frame.text = new String(payload, StandardCharsets.UTF_8);
+        }
+        decodeNanos += System.nanoTime() - start;
+        frames++;
+        bytes += HEADER_SIZE + length;
+        return frame;
+    }
+
+    /** Vehicle id of a "DATA:" message; 0 if it names none */
+    public static int messageVehicle(String message) {
+        for (String line : message.split("\\r?\\n")) {
+            if (line.startsWith("VEHICLE:")) {
+                return Integer.parseInt(line.substring(8).trim());
+            }
+        }
+        return 0;
+    }
+
+    /** Telemetry from a text "DATA:" message */
+    public static Frame parseData(String message) {
+        String[] parts = message.split("\\r?\\n", 2)[0].trim().split("\\s+");
+        Frame frame = new Frame();
+        frame.type = FRAME_TELEMETRY;
+        frame.speed = Integer.parseInt(parts[1]);
+        frame.battery = Integer.parseInt(parts[2]);
+        frame.temperature = Integer.parseInt(parts[3]);
+        frame.direction = parts[4];
+        frame.vehicle = messageVehicle(message);
+        return frame;
+    }
+
+    /** Changed fields of a text "DELTA: speed=10 direction=LEFT" message; tag 0 is a heartbeat */
+    public static Frame parseDelta(String message) {
+        Frame frame = new Frame();
+        frame.type = FRAME_DELTA;
+        String[] parts = message.trim().split("\\s+");
+        for (int i = 1; i < parts.length; i++) {
+            String[] field = parts[i].split("=", 2);
+            if (field.length != 2) continue;
+            switch (field[0]) {
+                case "speed": frame.speed = Integer.parseInt(field[1]); frame.tag |= DELTA_SPEED; break;
+                case "battery": frame.battery = Integer.parseInt(field[1]); frame.tag |= DELTA_BATTERY; break;
+                case "temperature": frame.temperature = Integer.parseInt(field[1]); frame.tag |= DELTA_TEMPERATURE; break;
+                case "direction": frame.direction = field[1]; frame.tag |= DELTA_DIRECTION; break;
+                default: break;
+            }
+        }
+        return frame;
+    }
+
+    /** Copies the fields a delta carries onto the last full frame */
+    public static void applyDelta(Frame base, Frame delta) {
+        if ((delta.tag & DELTA_SPEED) != 0) base.speed = delta.speed;
+        if ((delta.tag & DELTA_BATTERY) != 0) base.battery = delta.battery;
+        if ((delta.tag & DELTA_TEMPERATURE) != 0) base.temperature = delta.temperature;
+        if ((delta.tag & DELTA_DIRECTION) != 0) base.direction = delta.direction;
+    }
+
+    public long getFrames() { return frames; }
+    public long getBytes() { return bytes; }
+    public long getDecodeNanos() { return decodeNanos; }
+}
@@ -10,6 +10,7 @@ import threading
 from datetime import datetime
 from vehicle_data import VehicleData
 from network_manager import NetworkManager
+import wire
 
 class TelemetryGUI:
     def __init__(self):
@@ -34,6 +35,10 @@ class TelemetryGUI:
         self.battery_var = tk.StringVar(value=self.vehicle_data.get_battery_display())
         self.temperature_var = tk.StringVar(value=self.vehicle_data.get_temperature_display())
         self.direction_var = tk.StringVar(value=self.vehicle_data.get_direction_display())
+        self.binary_var = tk.BooleanVar(value=False)
+        self.rate_var = tk.StringVar(value="10")
+        self.delta_var = tk.BooleanVar(value=False)
+        self.vehicle_var = tk.StringVar(value="0")
         
         # Crear interfaz
         self._create_widgets()
@@ -113,6 +118,17 @@ class TelemetryGUI:
         # Botón para solicitar datos
         ttk.Button(vehicle_frame, text="Solicitar Datos", command=self._request_data).grid(row=2, column=0, pady=(10, 0))
         
+        # Suscripción: el servidor envía la telemetría a esta frecuencia (0 = solo el envío periódico)
+        ttk.Label(vehicle_frame, text="Frecuencia (Hz):").grid(row=2, column=1, sticky=tk.E, pady=(10, 0))
+        ttk.Spinbox(vehicle_frame, from_=0, to=100, width=5, textvariable=self.rate_var).grid(row=2, column=2, sticky=tk.W, padx=(5, 0), pady=(10, 0))
+        ttk.Button(vehicle_frame, text="Suscribir", command=self._subscribe).grid(row=2, column=3, sticky=tk.W, pady=(10, 0))
+        # Delta: solo los campos que cambian, con una trama completa cada 10 s
+        ttk.Checkbutton(vehicle_frame, text="Delta", variable=self.delta_var).grid(row=2, column=4, sticky=tk.W, padx=(5, 0), pady=(10, 0))
+        
+        # Vehículo de la flota que se consulta y controla (la suscripción sigue al vehículo 0)
+        ttk.Label(vehicle_frame, text="Vehículo:").grid(row=3, column=0, sticky=tk.W, pady=(10, 0))
+        ttk.Spinbox(vehicle_frame, from_=0, to=16777215, width=8, textvariable=self.vehicle_var).grid(row=3, column=1, sticky=tk.W, pady=(10, 0))
+        
         # === SECCIÓN DE CONTROLES (solo para administradores) ===
         self.control_frame = ttk.LabelFrame(main_frame, text="Controles del Vehículo", padding="5")
         self.control_frame.grid(row=3, column=0, columnspan=2, sticky=(tk.W, tk.E), pady=(0, 10))
@@ -172,6 +188,9 @@ class TelemetryGUI:
         self.disconnect_button = ttk.Button(button_frame, text="Desconectar", command=self._disconnect)
         self.disconnect_button.pack(side=tk.LEFT)
         
+        # Protocolo binario (se negocia al conectar)
+        ttk.Checkbutton(button_frame, text="Protocolo binario", variable=self.binary_var).pack(side=tk.LEFT, padx=(10, 0))
+        
         # Estado inicial de botones
         self.disconnect_button.config(state=tk.DISABLED)
     
@@ -225,7 +244,27 @@ class TelemetryGUI:
             messagebox.showerror("Error", "No hay conexión con el servidor")
             return
         
-        threading.Thread(target=self.network_manager.request_data, daemon=True).start()
+        vehicle = self._selected_vehicle()
+        if vehicle is None:
+            return
+        
+        threading.Thread(target=self.network_manager.request_data, args=(vehicle,), daemon=True).start()
+    
+    def _subscribe(self):
+        """Suscribirse a la telemetría a la frecuencia elegida"""
+        if not self.network_manager.is_connected():
+            messagebox.showerror("Error", "No hay conexión con el servidor")
+            return
+        
+        try:
+            rate = int(self.rate_var.get())
+        except ValueError:
+            rate = -1
+        if rate < 0 or rate > 100:
+            messagebox.showerror("Error", "La frecuencia debe estar entre 0 y 100 Hz")
+            return
+        
+        threading.Thread(target=self.network_manager.subscribe, args=(rate, self.delta_var.get()), daemon=True).start()
     
     def _send_vehicle_command(self, command):
         """Enviar comando de control del vehículo"""
@@ -233,7 +272,22 @@ class TelemetryGUI:
             messagebox.showerror("Error", "No hay conexión con el servidor")
             return
         
-        threading.Thread(target=self.network_manager.send_vehicle_command, args=(command,), daemon=True).start()
+        vehicle = self._selected_vehicle()
+        if vehicle is None:
+            return
+        
+        threading.Thread(target=self.network_manager.send_vehicle_command, args=(command, vehicle), daemon=True).start()
+    
+    def _selected_vehicle(self):
+        """Id del vehículo elegido, o None si no es válido"""
+        try:
+            vehicle = int(self.vehicle_var.get())
+        except ValueError:
+            vehicle = -1
+        if vehicle < 0:
+            messagebox.showerror("Error", "El vehículo debe ser un número desde 0")
+            return None
+        return vehicle
     
     def _request_users_list(self):
         """Solicitar lista de usuarios conectados"""
@@ -271,11 +325,15 @@ class TelemetryGUI:
     
     def _connect(self):
         """Conectar al servidor"""
-        threading.Thread(target=self._connect_thread, daemon=True).start()
+        binary = self.binary_var.get()
+        threading.Thread(target=self._connect_thread, args=(binary,), daemon=True).start()
     
-    def _connect_thread(self):
+    def _connect_thread(self, binary=False):
         """Hilo para conectar al servidor"""
-        success = self.network_manager.connect()
+        success = self.network_manager.connect(binary=binary)
+        if success and self.network_manager.session_token:
+            # Tras un reinicio del servidor la sesión sigue valiendo: sin contraseña
+            self.network_manager.resume()
         self.root.after(0, self._on_connect_result, success)
     
     def _on_connect_result(self, success):
@@ -326,7 +384,9 @@ class TelemetryGUI:
     
     def _on_data_received(self, message):
         """Callback para datos recibidos"""
-        self._log_message(f"Received: {message}")
+        # Con suscripción llegan hasta 100 tramas por segundo; solo se muestran en los datos
+        if not message.startswith("DATA:") or self.network_manager.subscribed_rate == 0:
+            self._log_message(f"Received: {message}")
         self._process_server_message(message)
     
     def _on_error(self, error):
@@ -338,7 +398,13 @@ class TelemetryGUI:
         """Procesar mensaje recibido del servidor"""
         try:
             if message.startswith("DATA:"):
-                # Procesar datos de telemetría
+                # Procesar datos de telemetría, solo del vehículo elegido
+                try:
+                    selected = int(self.vehicle_var.get())
+                except ValueError:
+                    selected = 0
+                if wire.message_vehicle(message) != selected:
+                    return
                 parts = message.split()
                 self.vehicle_data.update_from_server_data(parts)
                 self._update_vehicle_data()
@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+"""
+Multicast telemetry observer
+Receives the server's UDP telemetry datagrams (./server ... --multicast
+<group>:<port>) without a TCP connection or an account, prints each frame
+and reports datagrams lost on the way from their sequence numbers.
+
+Usage: python3 multicast_listener.py <group|broadcast addr> <port> [interface_ip]
+Loopback: ./server 8080 server.log --multicast 239.255.0.1:9999 --multicast-if 127.0.0.1
+          python3 multicast_listener.py 239.255.0.1 9999 127.0.0.1
+"""
+
+import socket
+import sys
+
+import wire
+
+
+def open_socket(group, port, interface):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)  # several observers per host
+    sock.bind(('', port))
+    if socket.inet_aton(group)[0] >> 4 == 0xE:
+        membership = socket.inet_aton(group) + socket.inet_aton(interface)
+        sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    return sock
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(__doc__.strip())
+        sys.exit(1)
+    group, port = sys.argv[1], int(sys.argv[2])
+    interface = sys.argv[3] if len(sys.argv) > 3 else '0.0.0.0'
+
+    sock = open_socket(group, port, interface)
+    tracker = wire.SequenceTracker()
+    print(f"Listening on {group}:{port}")
+    try:
+        while True:
+            data, sender = sock.recvfrom(2048)
+            try:
+                stream_id, sequence, telemetry = wire.decode_datagram(data)
+            except ValueError:
+                continue
+            gap = tracker.update(stream_id, sequence)
+            if gap:
+                print(f"  ... {gap} datagram{'s' if gap > 1 else ''} missed")
+            print(f"#{sequence} from {sender[0]}: {telemetry.to_message().splitlines()[0]}")
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sock.close()
+    print(f"Received {tracker.received}, missed {tracker.missed}, out of order {tracker.late}")
+
+
+if __name__ == '__main__':
+    main()
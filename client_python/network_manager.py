@@ -9,6 +9,8 @@ import threading
 from datetime import datetime
 from typing import Callable, Optional
 
+import wire
+
 class NetworkManager:
     def __init__(self):
         self.host = 'localhost'
@@ -19,6 +21,13 @@ class NetworkManager:
         self.is_admin = False
         self.username = ""
         self.running = True
+        self.binary = False             # frames are sent in the binary protocol
+        self.binary_receive = False     # server confirmed the switch
+        self.subscribed_rate = 0        # telemetry Hz confirmed by the server
+        self.subscribed_delta = False   # server sends only changed fields
+        self.telemetry = None           # last full frame, base for deltas
+        self.session_token = ""         # from AUTH_SUCCESS; survives reconnects and server restarts
+        self.decoder = wire.FrameDecoder()
         
         # Callbacks para eventos
         self.on_connected: Optional[Callable] = None
@@ -32,8 +41,8 @@ class NetworkManager:
         # Hilo de recepción
         self.receive_thread = None
     
-    def connect(self, host: str = 'localhost', port: int = 8080) -> bool:
-        """Conectar al servidor"""
+    def connect(self, host: str = 'localhost', port: int = 8080, binary: bool = False) -> bool:
+        """Conectar al servidor; con binary=True negocia el protocolo binario"""
         try:
             self.host = host
             self.port = port
@@ -44,6 +53,12 @@ class NetworkManager:
             self.authenticated = False
             self.is_admin = False
             self.username = ""
+            self.binary = False
+            self.binary_receive = False
+            self.subscribed_rate = 0
+            self.subscribed_delta = False
+            self.telemetry = None
+            self.decoder = wire.FrameDecoder()
             
             # Iniciar hilo para recibir mensajes
             self.receive_thread = threading.Thread(target=self._receive_messages)
@@ -56,6 +71,12 @@ class NetworkManager:
             if self.on_log:
                 self.on_log(f"Connected to {host}:{port}")
             
+            if binary:
+                # The server switches right after this message, so everything
+                # sent from here on is framed; replies switch once it confirms
+                self._send_command(f"PROTOCOL: BINARY {wire.WIRE_VERSION}")
+                self.binary = True
+            
             return True
         except Exception as e:
             if self.on_error:
@@ -100,16 +121,40 @@ class NetworkManager:
                 self.on_error(f"Error en autenticación: {str(e)}")
             return False
     
-    def request_data(self) -> bool:
-        """Solicitar datos de telemetría"""
+    def resume(self) -> bool:
+        """Volver a autenticarse con el token de la última sesión, sin contraseña"""
+        if not self.connected or not self.session_token:
+            return False
+        
+        try:
+            self._send_command(f"RESUME: {self.session_token}")
+            if self.on_log:
+                self.on_log("Resuming session")
+            return True
+        except Exception as e:
+            if self.on_error:
+                self.on_error(f"Error reanudando sesión: {str(e)}")
+            return False
+    
+    def request_data(self, vehicle: int = 0) -> bool:
+        """Solicitar datos de telemetría de un vehículo de la flota"""
         if not self.connected:
             if self.on_error:
                 self.on_error("No connection to server")
             return False
-        return self._send_command("GET_DATA:")
+        return self._send_command(f"GET_DATA: {vehicle}")
     
-    def send_vehicle_command(self, cmd: str) -> bool:
-        """Enviar comando de control del vehículo"""
+    def subscribe(self, hz: int, delta: bool = False) -> bool:
+        """Recibir telemetría a hz tramas por segundo; 0 vuelve al envío periódico.
+        Con delta=True el servidor solo envía los campos que cambian."""
+        if not self.connected:
+            if self.on_error:
+                self.on_error("No connection to server")
+            return False
+        return self._send_command(f"SUBSCRIBE: {hz}" + (" DELTA" if delta else ""))
+    
+    def send_vehicle_command(self, cmd: str, vehicle: int = 0) -> bool:
+        """Enviar comando de control a un vehículo de la flota"""
         if not self.connected:
             if self.on_error:
                 self.on_error("No connection to server")
@@ -126,7 +171,7 @@ class NetworkManager:
                 self.on_error(f"Comando no válido: {cmd}")
             return False
         
-        return self._send_command(f"SEND_CMD: {cmd}")
+        return self._send_command(f"SEND_CMD: {vehicle} {cmd}")
     
     def request_users_list(self) -> bool:
         """Solicitar lista de usuarios conectados"""
@@ -148,11 +193,13 @@ class NetworkManager:
             return False
         
         try:
-            # Formatear mensaje según protocolo
-            timestamp = datetime.now().strftime("%Y-%m-%d %H:%M:%S")
-            message = f"{command}\r\nUSER: {self.username}\r\nTIMESTAMP: {timestamp}\r\n\r\n"
-            
-            self.socket.send(message.encode('utf-8'))
+            if self.binary:
+                self.socket.sendall(wire.encode_command(command))
+            else:
+                # Formatear mensaje según protocolo
+                timestamp = datetime.now().strftime("%Y-%m-%d %H:%M:%S")
+                message = f"{command}\r\nUSER: {self.username}\r\nTIMESTAMP: {timestamp}\r\n\r\n"
+                self.socket.send(message.encode('utf-8'))
             if self.on_log:
                 self.on_log(f"Command sent: {command}")
             return True
@@ -163,16 +210,28 @@ class NetworkManager:
     
     def _receive_messages(self):
         """Hilo para recibir mensajes del servidor"""
+        pending = b""
         while self.connected and self.running:
             try:
-                data = self.socket.recv(1024)
+                data = self.socket.recv(4096)
                 if not data:
                     if self.on_error:
                         self.on_error("Servidor cerró la conexión")
                     break
                 
-                message = data.decode('utf-8').strip()
-                self._process_server_message(message)
+                # Un recv puede traer varios mensajes o solo parte de uno
+                pending += data
+                while not self.binary_receive and b"\r\n\r\n" in pending:
+                    message, pending = pending.split(b"\r\n\r\n", 1)
+                    text = message.decode('utf-8', errors='replace').strip()
+                    if text:
+                        self._process_server_message(text)
+                
+                # Lo que sigue a la confirmación ya son tramas binarias
+                if self.binary_receive and pending:
+                    for frame in self.decoder.feed(pending):
+                        self._process_frame(frame)
+                    pending = b""
                 
             except socket.timeout:
                 continue
@@ -181,21 +240,63 @@ class NetworkManager:
                     self.on_error(f"Error recibiendo mensaje: {str(e)}")
                 break
     
+    def _process_frame(self, frame):
+        """Procesar una trama del protocolo binario"""
+        frame_type, _, value = frame
+        if frame_type == wire.FRAME_TELEMETRY:
+            # Same text the GUI gets in text mode
+            if value.vehicle == wire.STREAM_VEHICLE:
+                self.telemetry = value
+            self._process_server_message(value.to_message())
+        elif frame_type == wire.FRAME_DELTA:
+            self._apply_delta(value)
+        elif frame_type == wire.FRAME_RESPONSE:
+            self._process_server_message(value)
+    
+    def _apply_delta(self, fields: dict):
+        """Aplicar los campos cambiados a la última trama completa; un
+        heartbeat (sin campos) no genera mensaje"""
+        if not fields or self.telemetry is None:
+            return
+        self.telemetry = self.telemetry._replace(**fields)
+        self._process_server_message(self.telemetry.to_message())
+    
     def _process_server_message(self, message: str):
         """Procesar mensaje recibido del servidor"""
         try:
+            if message.startswith("DELTA:"):
+                # Solo campos cambiados: la GUI recibe la trama completa
+                self._apply_delta(wire.parse_delta(message))
+                return
+            if message.startswith("DATA:") and wire.message_vehicle(message) == wire.STREAM_VEHICLE:
+                # Los deltas son del vehículo del stream; GET_DATA de otro no los afecta
+                self.telemetry = wire.parse_data(message)
+            
             if self.on_data_received:
                 self.on_data_received(message)
             
+            if message.startswith("OK: Protocol BINARY"):
+                self.binary_receive = True
+            elif message.startswith("ERROR: Unsupported protocol"):
+                self.binary = False
+            elif message.startswith("OK: Subscribed at "):
+                self.subscribed_rate = int(message.split()[3])
+                self.subscribed_delta = message.endswith("(delta)")
+            elif message.startswith("OK: Unsubscribed"):
+                self.subscribed_rate = 0
+                self.subscribed_delta = message.endswith("(delta)")
+            
             if message.startswith("AUTH_SUCCESS"):
                 self.authenticated = True
                 self.is_admin = True
+                self.session_token = wire.parse_token(message) or self.session_token
                 if self.on_authentication_success:
                     self.on_authentication_success()
                     
             elif message.startswith("AUTH_FAILED"):
                 self.authenticated = False
                 self.is_admin = False
+                self.session_token = ""
                 if self.on_authentication_failed:
                     self.on_authentication_failed()
                     
@@ -215,3 +316,6 @@ class NetworkManager:
     
     def get_username(self) -> str:
         return self.username
+    
+    def is_binary(self) -> bool:
+        return self.binary_receive
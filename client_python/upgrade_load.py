@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+Hot upgrade under load
+Keeps short connections coming (connect, GET_DATA, close) and long sessions
+polling GET_DATA while a server started with --upgrade-socket hands over to
+a new binary, triggered with SIGUSR2 halfway through. No connection may be
+refused; long sessions cut by the old process must RESUME on the new one.
+
+Usage: python3 upgrade_load.py <server_pid> [host] [port] [seconds]
+"""
+
+import os
+import signal
+import socket
+import sys
+import threading
+import time
+
+import wire
+
+SHORT_WORKERS = 8
+LONG_SESSIONS = 4
+POLL_INTERVAL = 0.05
+GET_DATA = b"GET_DATA:\r\nUSER: load\r\nTIMESTAMP: 0\r\n\r\n"
+
+
+class Counters:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.values = {}
+        self.slowest = 0.0
+
+    def add(self, name, elapsed=None):
+        with self.lock:
+            self.values[name] = self.values.get(name, 0) + 1
+            if elapsed is not None:
+                self.slowest = max(self.slowest, elapsed)
+
+    def get(self, name):
+        with self.lock:
+            return self.values.get(name, 0)
+
+
+def request(sock, command):
+    """Sends one command and reads its response; ConnectionError if the
+    server closed the connection first"""
+    sock.sendall(command)
+    data = b''
+    while b"\r\n\r\n" not in data:
+        chunk = sock.recv(4096)
+        if not chunk:
+            raise ConnectionError("Server closed the connection")
+        data += chunk
+    return data.decode('utf-8', 'replace')
+
+
+def short_worker(host, port, deadline, counters):
+    while time.time() < deadline:
+        start = time.perf_counter()
+        try:
+            sock = socket.create_connection((host, port), timeout=10)
+        except ConnectionRefusedError:
+            counters.add('refused')
+            continue
+        try:
+            request(sock, GET_DATA)
+            counters.add('short', time.perf_counter() - start)
+        except (ConnectionError, OSError):
+            # Accepted by the old process as it stopped: closed, not refused
+            counters.add('cut')
+        finally:
+            sock.close()
+
+
+def open_session(host, port, token, counters):
+    """Connects and authenticates, with the token if there is one"""
+    try:
+        sock = socket.create_connection((host, port), timeout=10)
+    except ConnectionRefusedError:
+        counters.add('refused')
+        return None, token
+    command = f"RESUME: {token}\r\n\r\n" if token else "AUTH: admin admin123\r\n\r\n"
+    try:
+        response = request(sock, command.encode())
+    except (ConnectionError, OSError):
+        sock.close()
+        return None, token
+    if not response.startswith("AUTH_SUCCESS"):
+        counters.add('resume_failed' if token else 'auth_failed')
+        sock.close()
+        return None, ''
+    if token:
+        counters.add('resumed')
+    return sock, wire.parse_token(response) or token
+
+
+def long_session(host, port, deadline, counters):
+    sock, token = None, ''
+    while time.time() < deadline:
+        try:
+            if sock is None:
+                sock, token = open_session(host, port, token, counters)
+                continue
+            request(sock, GET_DATA)
+            counters.add('polls')
+            time.sleep(POLL_INTERVAL)
+        except (ConnectionError, OSError):
+            if sock:
+                sock.close()
+            sock = None
+    if sock:
+        sock.close()
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+    pid = int(sys.argv[1])
+    host = sys.argv[2] if len(sys.argv) > 2 else 'localhost'
+    port = int(sys.argv[3]) if len(sys.argv) > 3 else 8080
+    seconds = float(sys.argv[4]) if len(sys.argv) > 4 else 6.0
+
+    counters = Counters()
+    deadline = time.time() + seconds
+    workers = [threading.Thread(target=short_worker, args=(host, port, deadline, counters))
+               for _ in range(SHORT_WORKERS)]
+    workers += [threading.Thread(target=long_session, args=(host, port, deadline, counters))
+                for _ in range(LONG_SESSIONS)]
+    for worker in workers:
+        worker.start()
+
+    time.sleep(seconds / 2)
+    before = counters.get('short')
+    os.kill(pid, signal.SIGUSR2)
+    print(f"SIGUSR2 sent to {pid} after {before} short connections")
+
+    for worker in workers:
+        worker.join()
+
+    print(f"Short connections: {counters.get('short')} served, {counters.get('cut')} cut by the old process, "
+          f"slowest {counters.slowest * 1000:.0f} ms")
+    print(f"Long sessions: {counters.get('polls')} polls, {counters.get('resumed')} resumed, "
+          f"{counters.get('resume_failed')} failed to resume")
+    print(f"Refused connections: {counters.get('refused')}")
+    ok = counters.get('refused') == 0 and counters.get('resume_failed') == 0 and counters.get('auth_failed') == 0
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,246 @@
+#!/usr/bin/env python3
+"""
+Binary wire protocol (server/wire.h)
+Frame encoding and an incremental decoder for connections that sent
+"PROTOCOL: BINARY 1". All integers are little-endian.
+"""
+
+import struct
+import time
+from typing import List, NamedTuple, Tuple
+
+WIRE_VERSION = 1
+HEADER = struct.Struct('<BBH')              # type, tag, payload length
+TELEMETRY = struct.Struct('<HBbBHBq')       # speed, battery, temperature, direction, vehicle (u24), timestamp
+TELEMETRY_FRAME = struct.Struct('<4x' + TELEMETRY.format[1:])
+HISTORY = struct.Struct('<qIH')             # first point (unix ms), ms between points, count
+DATAGRAM = struct.Struct('<2sBBIQ')         # magic, version, flags, stream id, sequence (server/multicast.h)
+DATAGRAM_MAGIC = b'VT'
+DATAGRAM_VERSION = 1
+
+FRAME_COMMAND = 1
+FRAME_RESPONSE = 2
+FRAME_TELEMETRY = 3
+FRAME_DELTA = 4
+FRAME_HISTORY = 5
+
+# Delta frame tag: which fields follow, in TELEMETRY order
+DELTA_FIELDS = (
+    (0x01, 'speed', struct.Struct('<H')),
+    (0x02, 'battery', struct.Struct('<B')),
+    (0x04, 'temperature', struct.Struct('<b')),
+    (0x08, 'direction', struct.Struct('<B')),
+)
+
+OPCODES = {
+    'AUTH': 1,
+    'GET_DATA': 2,
+    'SEND_CMD': 3,
+    'LIST_USERS': 4,
+    'RECHARGE': 5,
+    'DISCONNECT': 6,
+    'PROTOCOL': 7,
+    'SUBSCRIBE': 8,
+    'GET_HISTORY': 9,
+    'RESUME': 10,
+}
+
+DIRECTIONS = ('STRAIGHT', 'LEFT', 'RIGHT')
+STREAM_VEHICLE = 0                          # vehicle of the broadcast and subscriptions
+
+
+class Telemetry(NamedTuple):
+    speed: int
+    battery: int
+    temperature: int
+    direction: str
+    timestamp: int
+    vehicle: int = 0
+
+    def to_message(self) -> str:
+        """Same text the server sends in text mode, for code that expects it"""
+        return f"DATA: {self.speed} {self.battery} {self.temperature} {self.direction}\r\nVEHICLE: {self.vehicle}"
+
+
+def message_vehicle(message: str) -> int:
+    """Vehicle id of a "DATA:" message; 0 if it names none"""
+    for line in message.split('\r\n')[1:]:
+        if line.startswith('VEHICLE:'):
+            return int(line[8:])
+    return 0
+
+
+def parse_data(message: str) -> Telemetry:
+    """Telemetry from a text "DATA:" message"""
+    speed, battery, temperature, direction = message.split('\r\n', 1)[0].split()[1:5]
+    return Telemetry(int(speed), int(battery), int(temperature), direction, 0, message_vehicle(message))
+
+
+def parse_token(message: str) -> str:
+    """Session token of an "AUTH_SUCCESS" response, for RESUME; empty if none"""
+    for line in message.split('\r\n')[1:]:
+        if line.startswith('TOKEN:'):
+            return line[6:].strip()
+    return ''
+
+
+def parse_delta(message: str) -> dict:
+    """Changed fields of a text "DELTA: speed=10 direction=LEFT" message;
+    empty for a heartbeat"""
+    fields = {}
+    for item in message.split()[1:]:
+        name, _, value = item.partition('=')
+        fields[name] = value if name == 'direction' else int(value)
+    return fields
+
+
+def encode_command(command: str) -> bytes:
+    """Turn a text command ("SEND_CMD: SPEED_UP") into a COMMAND frame"""
+    verb, _, args = command.partition(':')
+    payload = args.strip().encode('utf-8')
+    return HEADER.pack(FRAME_COMMAND, OPCODES.get(verb.strip(), 0), len(payload)) + payload
+
+
+def decode_telemetry(payload: bytes) -> Telemetry:
+    speed, battery, temperature, direction, vehicle_low, vehicle_high, timestamp = TELEMETRY.unpack(payload)
+    name = DIRECTIONS[direction] if direction < len(DIRECTIONS) else 'STRAIGHT'
+    return Telemetry(speed, battery, temperature, name, timestamp, vehicle_low | vehicle_high << 16)
+
+
+def decode_delta(tag: int, payload: bytes) -> dict:
+    fields = {}
+    offset = 0
+    for bit, name, layout in DELTA_FIELDS:
+        if tag & bit:
+            (value,) = layout.unpack_from(payload, offset)
+            offset += layout.size
+            if name == 'direction':
+                value = DIRECTIONS[value] if value < len(DIRECTIONS) else 'STRAIGHT'
+            fields[name] = value
+    return fields
+
+
+class History(NamedTuple):
+    from_ms: int                # Unix time of the first point
+    step_ms: int
+    points: List[Tuple[int, int, int, str]]    # speed, battery, temperature, direction
+
+
+def parse_history(message: str) -> History:
+    """Points of a text "HISTORY:" response"""
+    lines = message.split('\r\n')
+    _, count, step_ms = lines[0].split()
+    from_ms = int(lines[1].split()[1])
+    points = []
+    for line in lines[2:2 + int(count)]:
+        speed, battery, temperature, direction = line.split()
+        points.append((int(speed), int(battery), int(temperature), direction))
+    return History(from_ms, int(step_ms), points)
+
+
+def decode_history(payload: bytes) -> History:
+    """HISTORY frame payload: header, then one column per field"""
+    from_ms, step_ms, count = HISTORY.unpack_from(payload)
+    offset = HISTORY.size
+    speeds = struct.unpack_from(f'<{count}H', payload, offset)
+    offset += 2 * count
+    batteries = struct.unpack_from(f'<{count}B', payload, offset)
+    temperatures = struct.unpack_from(f'<{count}b', payload, offset + count)
+    directions = payload[offset + 2 * count:offset + 3 * count]
+    points = [(speeds[i], batteries[i], temperatures[i],
+               DIRECTIONS[directions[i]] if directions[i] < len(DIRECTIONS) else 'STRAIGHT')
+              for i in range(count)]
+    return History(from_ms, step_ms, points)
+
+
+class FrameDecoder:
+    """Splits a byte stream into frames; keeps counters for measurements"""
+
+    def __init__(self):
+        self.pending = b''
+        self.frames = 0
+        self.bytes = 0
+        self.decode_seconds = 0.0
+
+    def feed(self, data: bytes) -> List[Tuple[int, int, object]]:
+        """Returns (type, tag, value) for every complete frame; value is a
+        Telemetry for telemetry frames, a dict of the changed fields for delta
+        frames, a History for history frames and the response text otherwise"""
+        self.pending += data
+        frames = []
+        offset = 0
+        start = time.perf_counter()
+        pending = self.pending
+        available = len(pending)
+        while available - offset >= HEADER.size:
+            frame_type = pending[offset]
+            if (frame_type == FRAME_TELEMETRY and available - offset >= TELEMETRY_FRAME.size
+                    and pending[offset + 2] == TELEMETRY.size and pending[offset + 3] == 0):
+                # Fixed size: header and fields in one unpack
+                (speed, battery, temperature, direction,
+                 vehicle_low, vehicle_high, timestamp) = TELEMETRY_FRAME.unpack_from(pending, offset)
+                name = DIRECTIONS[direction] if direction < len(DIRECTIONS) else 'STRAIGHT'
+                frames.append((frame_type, 0, Telemetry(speed, battery, temperature, name, timestamp,
+                                                        vehicle_low | vehicle_high << 16)))
+                self.bytes += TELEMETRY_FRAME.size
+                offset += TELEMETRY_FRAME.size
+                continue
+            frame_type, tag, length = HEADER.unpack_from(pending, offset)
+            end = offset + HEADER.size + length
+            if available < end:
+                break
+            if frame_type == FRAME_TELEMETRY:
+                value = decode_telemetry(pending[offset + HEADER.size:end])
+            elif frame_type == FRAME_DELTA:
+                value = decode_delta(tag, pending[offset + HEADER.size:end])
+            elif frame_type == FRAME_HISTORY:
+                value = decode_history(pending[offset + HEADER.size:end])
+            else:
+                value = pending[offset + HEADER.size:end].decode('utf-8', errors='replace')
+            frames.append((frame_type, tag, value))
+            self.bytes += end - offset
+            offset = end
+        self.pending = pending[offset:]
+        self.decode_seconds += time.perf_counter() - start
+        self.frames += len(frames)
+        return frames
+
+
+def decode_datagram(data: bytes) -> Tuple[int, int, Telemetry]:
+    """(stream id, sequence, telemetry) of a multicast telemetry datagram;
+    raises ValueError for anything else"""
+    if len(data) < DATAGRAM.size + TELEMETRY_FRAME.size:
+        raise ValueError("Datagram too short")
+    magic, version, _, stream_id, sequence = DATAGRAM.unpack_from(data)
+    if magic != DATAGRAM_MAGIC or version != DATAGRAM_VERSION or data[DATAGRAM.size] != FRAME_TELEMETRY:
+        raise ValueError("Not a telemetry datagram")
+    payload = data[DATAGRAM.size + HEADER.size:DATAGRAM.size + TELEMETRY_FRAME.size]
+    return stream_id, sequence, decode_telemetry(payload)
+
+
+class SequenceTracker:
+    """Counts datagrams missed and out of order on one stream; a new stream
+    id (server restart) starts over"""
+
+    def __init__(self):
+        self.stream_id = None
+        self.expected = 0
+        self.received = 0
+        self.missed = 0
+        self.late = 0
+
+    def update(self, stream_id: int, sequence: int) -> int:
+        """Returns how many datagrams were skipped right before this one"""
+        self.received += 1
+        if stream_id != self.stream_id:
+            self.stream_id = stream_id
+            self.expected = sequence + 1
+            return 0
+        if sequence < self.expected:
+            self.late += 1
+            self.missed = max(self.missed - 1, 0)
+            return 0
+        gap = sequence - self.expected
+        self.missed += gap
+        self.expected = sequence + 1
+        return gap
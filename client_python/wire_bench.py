@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""
+Text vs binary protocol measurement
+Requests the same number of telemetry frames over a text connection and over
+a binary one, and reports bytes per frame and client parse time per frame.
+
+Usage: python3 wire_bench.py [host] [port] [frames]
+"""
+
+import socket
+import sys
+import threading
+import time
+
+import wire
+
+
+def send(sock, request):
+    """Sends from another thread so replies are read while requests go out
+    (the server drops replies to a client that stops reading)"""
+    sender = threading.Thread(target=sock.sendall, args=(request,), daemon=True)
+    sender.start()
+    return sender
+
+
+def receive(sock, done):
+    """Reads until done(buffer) is true"""
+    data = b''
+    while not done(data):
+        chunk = sock.recv(65536)
+        if not chunk:
+            raise ConnectionError("Server closed the connection")
+        data += chunk
+    return data
+
+
+def run_text(host, port, frames):
+    sock = socket.create_connection((host, port))
+    request = b"GET_DATA:\r\nUSER: bench\r\nTIMESTAMP: 0\r\n\r\n" * frames
+    send(sock, request)
+    data = receive(sock, lambda d: d.count(b"\r\n\r\n") >= frames)
+    sock.close()
+
+    # Produce the same values the binary decoder does
+    start = time.perf_counter()
+    parsed = 0
+    for message in data.split(b"\r\n\r\n")[:frames]:
+        lines = message.decode('utf-8').split("\r\n")
+        parts = lines[0].split()
+        wire.Telemetry(int(parts[1]), int(parts[2]), int(parts[3]), parts[4], int(lines[3].split()[1]),
+                       int(lines[1].split()[1]))
+        parsed += 1
+    elapsed = time.perf_counter() - start
+    return len(request) / frames, len(data) / frames, elapsed / parsed
+
+
+def run_binary(host, port, frames):
+    sock = socket.create_connection((host, port))
+    sock.sendall(f"PROTOCOL: BINARY {wire.WIRE_VERSION}\r\n\r\n".encode())
+    handshake = receive(sock, lambda d: b"\r\n\r\n" in d)
+    if not handshake.startswith(b"OK: Protocol BINARY"):
+        raise ConnectionError(handshake.decode(errors='replace').strip())
+    rest = handshake.split(b"\r\n\r\n", 1)[1]
+
+    request = wire.encode_command("GET_DATA:") * frames
+    send(sock, request)
+    size = wire.HEADER.size + wire.TELEMETRY.size
+    data = rest + receive(sock, lambda d: len(rest) + len(d) >= frames * size)
+    sock.close()
+
+    decoder = wire.FrameDecoder()
+    decoded = decoder.feed(data)
+    return len(request) / frames, decoder.bytes / len(decoded), decoder.decode_seconds / len(decoded)
+
+
+def main():
+    host = sys.argv[1] if len(sys.argv) > 1 else 'localhost'
+    port = int(sys.argv[2]) if len(sys.argv) > 2 else 8080
+    frames = int(sys.argv[3]) if len(sys.argv) > 3 else 10000
+
+    text = run_text(host, port, frames)
+    binary = run_binary(host, port, frames)
+
+    print(f"{'protocol':<10} {'request B':>10} {'frame B':>10} {'parse us':>10}")
+    print(f"{'text':<10} {text[0]:>10.1f} {text[1]:>10.1f} {text[2] * 1e6:>10.2f}")
+    print(f"{'binary':<10} {binary[0]:>10.1f} {binary[1]:>10.1f} {binary[2] * 1e6:>10.2f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,142 @@
+/*
+ * Command parser benchmark
+ * Parses and dispatches a mix of protocol messages with the single-pass
+ * tokenizer (protocol_parser.c) and with the previous parser, which copied
+ * the message, matched verbs with strncmp, extracted params with sscanf and
+ * compared vehicle sub-commands with strcmp.
+ *
+ * Compilation: make bench
+ * Usage: ./bench_parser [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "protocol_parser.h"
+
+#define LEGACY_BUFFER_SIZE 1024
+#define LEGACY_PARAM_LEN 100
+
+// Messages as they reach the parser: terminator already stripped
+static const char* messages[] = {
+    "GET_DATA:\r\nUSER: admin\r\nTIMESTAMP: 1760600000",
+    "SEND_CMD: SPEED_UP\r\nUSER: admin\r\nTIMESTAMP: 1760600000",
+    "SEND_CMD: SLOW_DOWN\r\nUSER: admin\r\nTIMESTAMP: 1760600000",
+    "SEND_CMD: TURN_LEFT\r\nUSER: admin\r\nTIMESTAMP: 1760600000",
+    "SEND_CMD: TURN_RIGHT\r\nUSER: admin\r\nTIMESTAMP: 1760600000",
+    "AUTH: admin admin123\r\nTIMESTAMP: 1760600000",
+    "LIST_USERS:\r\nUSER: admin\r\nTIMESTAMP: 1760600000",
+    "RECHARGE:\r\nUSER: admin\r\nTIMESTAMP: 1760600000",
+    "DISCONNECT:\r\nUSER: admin\r\nTIMESTAMP: 1760600000",
+    "PING:\r\nUSER: admin\r\nTIMESTAMP: 1760600000"
+};
+#define MESSAGE_COUNT (sizeof(messages) / sizeof(messages[0]))
+
+// ============================================================================
+// PREVIOUS PARSER (baseline)
+// ============================================================================
+
+typedef struct {
+    command_type_t type;
+    char param1[LEGACY_PARAM_LEN];
+    char param2[LEGACY_PARAM_LEN];
+    char param3[LEGACY_PARAM_LEN];
+} legacy_command_t;
+
+static command_type_t legacy_parse_command(const char* command, legacy_command_t* parsed) {
+    memset(parsed, 0, sizeof(legacy_command_t));
+
+    char cmd_copy[LEGACY_BUFFER_SIZE];
+    strncpy(cmd_copy, command, sizeof(cmd_copy) - 1);
+    cmd_copy[sizeof(cmd_copy) - 1] = '\0';
+
+    if (strncmp(cmd_copy, "AUTH:", 5) == 0) {
+        parsed->type = CMD_AUTH;
+        sscanf(cmd_copy, "AUTH: %99s %99s", parsed->param1, parsed->param2);
+        return CMD_AUTH;
+    }
+    if (strncmp(cmd_copy, "GET_DATA:", 9) == 0) return parsed->type = CMD_GET_DATA;
+    if (strncmp(cmd_copy, "SEND_CMD:", 9) == 0) {
+        parsed->type = CMD_SEND_CMD;
+        sscanf(cmd_copy, "SEND_CMD: %99s", parsed->param1);
+        return CMD_SEND_CMD;
+    }
+    if (strncmp(cmd_copy, "LIST_USERS:", 11) == 0) return parsed->type = CMD_LIST_USERS;
+    if (strncmp(cmd_copy, "RECHARGE:", 9) == 0) return parsed->type = CMD_RECHARGE;
+    if (strncmp(cmd_copy, "DISCONNECT:", 11) == 0) return parsed->type = CMD_DISCONNECT;
+    return CMD_UNKNOWN;
+}
+
+static vehicle_command_t legacy_dispatch(const legacy_command_t* cmd) {
+    if (cmd->type != CMD_SEND_CMD) return VEHICLE_CMD_NONE;
+    if (strcmp(cmd->param1, "SPEED_UP") == 0) return VEHICLE_CMD_SPEED_UP;
+    if (strcmp(cmd->param1, "SLOW_DOWN") == 0) return VEHICLE_CMD_SLOW_DOWN;
+    if (strcmp(cmd->param1, "TURN_LEFT") == 0) return VEHICLE_CMD_TURN_LEFT;
+    if (strcmp(cmd->param1, "TURN_RIGHT") == 0) return VEHICLE_CMD_TURN_RIGHT;
+    return VEHICLE_CMD_INVALID;
+}
+
+// ============================================================================
+// BENCHMARK
+// ============================================================================
+
+static double now_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Results are folded in here so the parsing cannot be optimized away
+static volatile unsigned long sink;
+
+// Returns nanoseconds per message
+static double run(int legacy, long iterations) {
+    unsigned long sum = 0;
+    double start = now_seconds();
+
+    for (long i = 0; i < iterations; i++) {
+        const char* message = messages[(size_t)i % MESSAGE_COUNT];
+        if (legacy) {
+            legacy_command_t cmd;
+            legacy_parse_command(message, &cmd);
+            sum += (unsigned long)cmd.type * 8 + (unsigned long)legacy_dispatch(&cmd) + (unsigned char)cmd.param2[0];
+        } else {
+            parsed_command_t cmd;
+            protocol_parse_command(message, &cmd);
+            sum += (unsigned long)cmd.type * 8 + (unsigned long)cmd.vehicle_cmd +
+                   (cmd.param_count > 1 ? (unsigned char)cmd.params[1].data[0] : 0);
+        }
+    }
+
+    double elapsed = now_seconds() - start;
+    sink = sum;
+    return elapsed * 1e9 / (double)iterations;
+}
+
+int main(int argc, char* argv[]) {
+    long iterations = argc > 1 ? atol(argv[1]) : 10000000;
+    if (iterations <= 0) iterations = 10000000;
+
+    // Both parsers must agree before their speed means anything
+    for (size_t i = 0; i < MESSAGE_COUNT; i++) {
+        legacy_command_t old_cmd;
+        parsed_command_t new_cmd;
+        command_type_t old_type = legacy_parse_command(messages[i], &old_cmd);
+        command_type_t new_type = protocol_parse_command(messages[i], &new_cmd);
+        if (old_type != new_type || legacy_dispatch(&old_cmd) != new_cmd.vehicle_cmd) {
+            fprintf(stderr, "Parsers disagree on: %s\n", messages[i]);
+            return 1;
+        }
+    }
+
+    double legacy = run(1, iterations);
+    double single = run(0, iterations);
+
+    printf("%-22s %12s\n", "parser", "ns/message");
+    printf("%-22s %12.1f\n", "strncmp + sscanf", legacy);
+    printf("%-22s %12.1f\n", "single-pass tokenizer", single);
+    printf("%-22s %11.1fx\n", "speedup", legacy / single);
+    return 0;
+}
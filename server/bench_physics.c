@@ -0,0 +1,154 @@
+/*
+ * Fleet physics benchmark
+ * Advances battery and temperature of a fleet stored as parallel arrays with
+ * every batch kernel this CPU runs (physics.c), one simulation timestep at a
+ * time. Runs on one thread, so vehicles/s is the rate of a single core.
+ *
+ * Compilation: make bench
+ * Usage: ./bench_physics [vehicles] [seconds_per_run]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "physics.h"
+
+#define BENCH_STEP_MS 10   // the server's default simulation timestep
+
+typedef struct {
+    int count;
+    int16_t* speed;
+    int32_t* battery;
+    int32_t* temperature;
+} bench_fleet_t;
+
+static volatile long sink;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// ============================================================================
+// FLEET SETUP
+// ============================================================================
+
+static void fleet_alloc(bench_fleet_t* fleet, int count) {
+    fleet->count = count;
+    fleet->speed = malloc((size_t)count * sizeof(int16_t));
+    fleet->battery = malloc((size_t)count * sizeof(int32_t));
+    fleet->temperature = malloc((size_t)count * sizeof(int32_t));
+    if (!fleet->speed || !fleet->battery || !fleet->temperature) {
+        perror("Error allocating fleet");
+        exit(1);
+    }
+}
+
+static void fleet_free(bench_fleet_t* fleet) {
+    free(fleet->speed);
+    free(fleet->battery);
+    free(fleet->temperature);
+}
+
+// Every speed step, and batteries and temperatures across their whole range
+static void fleet_fill(bench_fleet_t* fleet) {
+    for (int i = 0; i < fleet->count; i++) {
+        fleet->speed[i] = (int16_t)((i % 11) * 10);
+        fleet->battery[i] = (int32_t)((i / 11) % 101) * PHYSICS_BATTERY_UNIT + (int32_t)((long)i * 7919 % PHYSICS_BATTERY_UNIT);
+        fleet->temperature[i] = PHYSICS_TEMPERATURE_MIN + (int32_t)((i / 1111) % 31) * PHYSICS_TEMPERATURE_UNIT;
+    }
+}
+
+static void advance(physics_isa_t isa, bench_fleet_t* fleet, long elapsed_ms) {
+    physics_advance_isa(isa, fleet->speed, fleet->battery, fleet->temperature, fleet->count, elapsed_ms);
+}
+
+// ============================================================================
+// BENCHMARK
+// ============================================================================
+
+// Every kernel must match the scalar one, step after step, before its speed
+// means anything
+static int verify(physics_isa_t isa, int count) {
+    bench_fleet_t expected, actual;
+    fleet_alloc(&expected, count);
+    fleet_alloc(&actual, count);
+    fleet_fill(&expected);
+    fleet_fill(&actual);
+
+    int ok = 1;
+    for (long elapsed = 1; elapsed <= 700000 && ok; elapsed = elapsed < 20 ? elapsed + 1 : elapsed * 3) {
+        advance(PHYSICS_SCALAR, &expected, elapsed);
+        advance(isa, &actual, elapsed);
+        ok = memcmp(expected.battery, actual.battery, (size_t)count * sizeof(int32_t)) == 0 &&
+             memcmp(expected.temperature, actual.temperature, (size_t)count * sizeof(int32_t)) == 0;
+        if (!ok) fprintf(stderr, "Mismatch after a %ld ms step\n", elapsed);
+
+        // Keep batteries draining instead of parked at 0
+        if (elapsed % 5 == 0) {
+            fleet_fill(&expected);
+            fleet_fill(&actual);
+        }
+    }
+
+    fleet_free(&expected);
+    fleet_free(&actual);
+    return ok;
+}
+
+// Vehicles advanced per second
+static double run(physics_isa_t isa, int count, int seconds) {
+    bench_fleet_t fleet;
+    fleet_alloc(&fleet, count);
+    fleet_fill(&fleet);
+
+    long steps = 0;
+    double start = now_seconds();
+    double elapsed;
+    do {
+        for (int i = 0; i < 16; i++) {
+            if ((steps & 4095) == 0) fleet_fill(&fleet); // refill before batteries run flat
+            advance(isa, &fleet, BENCH_STEP_MS);
+            steps++;
+        }
+        elapsed = now_seconds() - start;
+    } while (elapsed < seconds);
+
+    sink = fleet.battery[count / 2] + fleet.temperature[count - 1];
+    fleet_free(&fleet);
+    return (double)steps * count / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    int vehicles = argc > 1 ? atoi(argv[1]) : 100000;
+    int seconds = argc > 2 ? atoi(argv[2]) : 1;
+    if (vehicles <= 0) vehicles = 100000;
+    if (seconds <= 0) seconds = 1;
+
+    printf("Fleet: %d vehicles, %d ms steps, one thread (dispatch picks %s)\n", vehicles, BENCH_STEP_MS,
+           physics_isa_name(physics_active_isa()));
+
+    double scalar = 0;
+    printf("%-10s %16s %12s %10s\n", "kernel", "vehicles/s/core", "ns/vehicle", "speedup");
+
+    for (int isa = PHYSICS_SCALAR; isa < PHYSICS_ISA_COUNT; isa++) {
+        if (!physics_isa_supported((physics_isa_t)isa)) {
+            printf("%-10s %16s\n", physics_isa_name((physics_isa_t)isa), "not supported");
+            continue;
+        }
+        if (isa != PHYSICS_SCALAR && !verify((physics_isa_t)isa, 11 * 101 * 31 + 7)) {
+            fprintf(stderr, "Kernel %s disagrees with the scalar kernel\n", physics_isa_name((physics_isa_t)isa));
+            return 1;
+        }
+
+        double rate = run((physics_isa_t)isa, vehicles, seconds);
+        if (isa == PHYSICS_SCALAR) scalar = rate;
+        printf("%-10s %16.0f %12.3f %9.1fx\n", physics_isa_name((physics_isa_t)isa), rate, 1e9 / rate,
+               rate / scalar);
+    }
+    return 0;
+}
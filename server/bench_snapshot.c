@@ -0,0 +1,113 @@
+/*
+ * Snapshot and warm restart benchmark
+ * For fleets of growing size, measures a snapshot taken while the simulation
+ * runs, and the restart that follows: a fresh fleet plus loading the
+ * snapshot, against the fresh fleet alone. The restored fleet is checked
+ * against the one saved.
+ *
+ * Compilation: make bench
+ * Usage: ./bench_snapshot [max_vehicles] [path]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "fleet.h"
+#include "snapshot.h"
+#include "token.h"
+
+#define BENCH_SESSIONS 10000
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+// Every vehicle in a different state, so a misplaced shard shows
+static void scramble(fleet_t* fleet) {
+    for (int id = 0; id < fleet->count; id++) {
+        fleet_set_speed(fleet, id, id % 101);
+        fleet_set_direction(fleet, id, (vehicle_direction_t)(id % 3));
+    }
+}
+
+static int same_state(fleet_t* a, fleet_t* b) {
+    for (int id = 0; id < a->count; id++) {
+        vehicle_snapshot_t x, y;
+        fleet_get_snapshot(a, id, &x);
+        fleet_get_snapshot(b, id, &y);
+        if (x.speed != y.speed || x.battery != y.battery || x.temperature != y.temperature ||
+            x.direction != y.direction) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    int max_vehicles = argc > 1 ? atoi(argv[1]) : 1000000;
+    const char* path = argc > 2 ? argv[2] : "bench_snapshot.snap";
+    if (max_vehicles <= 0 || max_vehicles > FLEET_MAX_VEHICLES) max_vehicles = 1000000;
+
+    token_table_t tokens;
+    if (token_table_init(&tokens, BENCH_SESSIONS, TOKEN_DEFAULT_TTL_SECONDS) != 0) return 1;
+    char text[TOKEN_TEXT_SIZE];
+    for (int i = 0; i < BENCH_SESSIONS; i++) {
+        token_issue(&tokens, "admin", 0, text);
+    }
+
+    printf("Snapshot of a running fleet, then restart from it (%d sessions, %s)\n", BENCH_SESSIONS, path);
+    printf("%10s %10s %10s %12s %12s %12s\n", "vehicles", "MB", "save ms", "cold ms", "warm ms", "load ms");
+
+    for (int vehicles = 1000; ; vehicles *= 10) {
+        if (vehicles > max_vehicles) vehicles = max_vehicles;
+
+        fleet_t running;
+        if (fleet_init(&running, vehicles) != 0) return 1;
+        scramble(&running);
+        fleet_start_simulation(&running, FLEET_DEFAULT_STEP_MS);
+        struct timespec settle = {0, 50000000L};
+        nanosleep(&settle, NULL);
+
+        snapshot_info_t saved;
+        if (snapshot_save(path, &running, &tokens, &saved) != 0) return 1;
+        fleet_stop_simulation(&running);
+
+        // Cold start: what every restart cost before, and the base of a warm one
+        double start = now_ms();
+        fleet_t cold;
+        if (fleet_init(&cold, vehicles) != 0) return 1;
+        double cold_ms = now_ms() - start;
+        fleet_cleanup(&cold);
+
+        token_table_t restored_tokens;
+        token_table_init(&restored_tokens, BENCH_SESSIONS, TOKEN_DEFAULT_TTL_SECONDS);
+        start = now_ms();
+        fleet_t warm;
+        snapshot_info_t loaded;
+        if (fleet_init(&warm, vehicles) != 0 || snapshot_load(path, &warm, &restored_tokens, &loaded) != 0) {
+            return 1;
+        }
+        double warm_ms = now_ms() - start;
+
+        if (!same_state(&running, &warm) || loaded.tokens != saved.tokens) {
+            fprintf(stderr, "Restored state differs from the snapshot at %d vehicles\n", vehicles);
+            return 1;
+        }
+        printf("%10d %10.1f %10.1f %12.2f %12.2f %12.2f\n", vehicles, (double)saved.bytes / (1024 * 1024),
+               saved.elapsed_ms, cold_ms, warm_ms, loaded.elapsed_ms);
+
+        fleet_cleanup(&warm);
+        fleet_cleanup(&running);
+        token_table_cleanup(&restored_tokens);
+        if (vehicles == max_vehicles) break;
+    }
+
+    unlink(path);
+    token_table_cleanup(&tokens);
+    return 0;
+}
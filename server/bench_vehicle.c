@@ -0,0 +1,136 @@
+/*
+ * Vehicle state read contention benchmark
+ * Measures snapshot reads per second with 1..N reader threads while one
+ * writer issues control commands, for the seqlock path and for a
+ * mutex-per-read baseline (the previous locking scheme). Readers and the
+ * writer walk the whole fleet, so with more vehicles they mostly touch
+ * different shards.
+ *
+ * Compilation: make bench
+ * Usage: ./bench_vehicle [max_threads] [seconds_per_run] [vehicles]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "fleet.h"
+#include "physics.h"
+
+typedef struct {
+    fleet_t* fleet;
+    int locked;
+    volatile int* running;
+    unsigned long long reads;
+    char pad[64]; // keep per-thread counters on separate cache lines
+} reader_arg_t;
+
+typedef struct {
+    fleet_t* fleet;
+    volatile int* running;
+    unsigned long long writes;
+} writer_arg_t;
+
+static void* reader_thread(void* arg) {
+    reader_arg_t* reader = (reader_arg_t*)arg;
+    vehicle_snapshot_t snapshot;
+    unsigned long long reads = 0;
+    long checksum = 0;
+
+    fleet_t* fleet = reader->fleet;
+    int id = 0;
+
+    while (*reader->running) {
+        if (reader->locked) {
+            fleet_shard_t* shard = &fleet->shards[id >> FLEET_SHARD_SHIFT];
+            pthread_mutex_lock(&shard->mutex);
+            snapshot.speed = fleet->speed[id];
+            snapshot.battery = (fleet->battery[id] + PHYSICS_BATTERY_UNIT - 1) / PHYSICS_BATTERY_UNIT;
+            snapshot.temperature = fleet->temperature[id] / PHYSICS_TEMPERATURE_UNIT;
+            snapshot.direction = (vehicle_direction_t)fleet->direction[id];
+            pthread_mutex_unlock(&shard->mutex);
+        } else {
+            fleet_get_snapshot(fleet, id, &snapshot);
+        }
+        id = (id + 7919) % fleet->count; // stride over shards
+        checksum += snapshot.speed;
+        reads++;
+    }
+
+    reader->reads = reads;
+    return (void*)checksum;
+}
+
+// One control command roughly every 100 microseconds
+static void* writer_thread(void* arg) {
+    writer_arg_t* writer = (writer_arg_t*)arg;
+    struct timespec pause = {0, 100000};
+
+    while (*writer->running) {
+        int id = (int)(writer->writes % (unsigned long long)writer->fleet->count);
+        if (fleet_speed_up(writer->fleet, id) < 0) {
+            fleet_set_speed(writer->fleet, id, 0);
+        }
+        fleet_set_direction(writer->fleet, id, (writer->writes & 1) ? DIRECTION_LEFT : DIRECTION_RIGHT);
+        writer->writes++;
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+static double run(int threads, int locked, int seconds, int vehicles) {
+    fleet_t fleet;
+    if (fleet_init(&fleet, vehicles) != 0) exit(1);
+
+    volatile int running = 1;
+    reader_arg_t* readers = calloc((size_t)threads, sizeof(reader_arg_t));
+    pthread_t* tids = calloc((size_t)threads, sizeof(pthread_t));
+    writer_arg_t writer = {&fleet, &running, 0};
+    pthread_t writer_tid;
+
+    pthread_create(&writer_tid, NULL, writer_thread, &writer);
+    for (int i = 0; i < threads; i++) {
+        readers[i].fleet = &fleet;
+        readers[i].locked = locked;
+        readers[i].running = &running;
+        pthread_create(&tids[i], NULL, reader_thread, &readers[i]);
+    }
+
+    sleep((unsigned)seconds);
+    running = 0;
+
+    unsigned long long total = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(tids[i], NULL);
+        total += readers[i].reads;
+    }
+    pthread_join(writer_tid, NULL);
+
+    free(readers);
+    free(tids);
+    fleet_cleanup(&fleet);
+    return (double)total / seconds;
+}
+
+int main(int argc, char* argv[]) {
+    int max_threads = argc > 1 ? atoi(argv[1]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int seconds = argc > 2 ? atoi(argv[2]) : 1;
+    int vehicles = argc > 3 ? atoi(argv[3]) : 1;
+    if (max_threads <= 0) max_threads = 1;
+    if (seconds <= 0) seconds = 1;
+    if (vehicles <= 0) vehicles = 1;
+
+    printf("Fleet: %d vehicle%s, %d per shard\n", vehicles, vehicles > 1 ? "s" : "", FLEET_SHARD_SIZE);
+
+    printf("%-8s %18s %18s %10s\n", "threads", "seqlock reads/s", "mutex reads/s", "speedup");
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        double seqlock = run(threads, 0, seconds, vehicles);
+        double mutex = run(threads, 1, seconds, vehicles);
+        printf("%-8d %18.0f %18.0f %9.1fx\n", threads, seqlock, mutex, seqlock / mutex);
+        if (threads < max_threads && threads * 2 > max_threads) threads = max_threads / 2;
+    }
+    return 0;
+}
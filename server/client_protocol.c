@@ -4,6 +4,9 @@
 #include <arpa/inet.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
+#include <sys/resource.h>
 
 // Authentication constants (defined here to avoid circular dependencies)
 #define DEFAULT_USERNAME "admin"
@@ -13,183 +16,491 @@
 // INITIALIZATION AND CLEANUP
 // ============================================================================
 
-void client_protocol_init(client_manager_t* manager, logger_t* logger, const char* log_filename) {
-    if (!manager || !logger) return;
+int client_protocol_init(client_manager_t* manager, int capacity, logger_t* logger, const char* log_filename) {
+    if (!manager || !logger) return -1;
     
     // Initialize client manager
-    manager->client_count = 0;
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        manager->clients[i].socket = -1;
-        manager->clients[i].authenticated = 0;
-        manager->clients[i].is_admin = 0;
-        manager->clients[i].username[0] = '\0';
+    if (client_manager_init(manager, capacity) != 0) return -1;
+    
+    // Initialize logger (starts the background writer)
+    logger_init(logger, log_filename);
+    return 0;
+}
+
+void client_protocol_cleanup(client_manager_t* manager, logger_t* logger) {
+    client_manager_cleanup(manager);
+    
+    logger_cleanup(logger);
+}
+
+// ============================================================================
+// CLIENT MANAGEMENT FUNCTIONS
+// ============================================================================
+
+// Slot fields read without the registry lock
+#define CLIENT_STORE(field, value) __atomic_store_n(&(field), (value), __ATOMIC_RELEASE)
+#define CLIENT_LOAD(field) __atomic_load_n(&(field), __ATOMIC_ACQUIRE)
+
+// Seconds on the monotonic clock: idle deadlines ignore wall clock jumps
+static time_t client_clock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec;
+}
+
+// First whole second by which a client idle since last_activity has been
+// idle for more than CLIENT_TIMEOUT_SECONDS
+static unsigned long long client_idle_deadline(time_t last_activity) {
+    return (unsigned long long)last_activity + CLIENT_TIMEOUT_SECONDS + 1;
+}
+
+// One entry per descriptor the process may open
+static int client_fd_capacity(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0 || limit.rlim_cur == RLIM_INFINITY ||
+        limit.rlim_cur > CLIENT_FD_TABLE_MAX) {
+        return CLIENT_FD_TABLE_MAX;
     }
+    return (int)limit.rlim_cur;
+}
+
+int client_manager_init(client_manager_t* manager, int capacity) {
+    if (!manager) return -1;
+    
+    memset(manager, 0, sizeof(*manager));
+    if (capacity < 1) capacity = 1;
+    if (capacity > CLIENT_MAX_CAPACITY) capacity = CLIENT_MAX_CAPACITY;
+    manager->capacity = capacity;
+    
+    // A standalone manager is its own single shard
+    manager->shard_base = manager;
+    manager->shard_count = 1;
     
     if (pthread_mutex_init(&manager->mutex, NULL) != 0) {
         perror("Error initializing client manager mutex");
+        return -1;
     }
     
-    // Initialize logger
-    logger->log_file = fopen(log_filename, "a");
-    if (!logger->log_file) {
-        perror("Error opening log file");
-        return;
+    slab_init(&manager->client_slab, sizeof(client_t), SLAB_CACHE_LINE, CLIENT_SLAB_OBJECTS);
+    slab_init(&manager->info_slab, sizeof(client_info_t), sizeof(void*), CLIENT_SLAB_OBJECTS);
+    manager->slots = calloc((size_t)capacity, sizeof(client_t*));
+    manager->free_slots = malloc((size_t)capacity * sizeof(int));
+    manager->pending = malloc((size_t)capacity * sizeof(outbound_queue_t*));
+    timer_wheel_init(&manager->idle_wheel, (unsigned long long)client_clock());
+    manager->fd_capacity = client_fd_capacity();
+    manager->slot_by_fd = calloc((size_t)manager->fd_capacity, sizeof(uint32_t));
+    if (!manager->slots || !manager->free_slots || !manager->pending || !manager->slot_by_fd) {
+        perror("Error allocating client registry");
+        client_manager_cleanup(manager);
+        return -1;
     }
     
-    // Duplicate filename
-    logger->filename = malloc(strlen(log_filename) + 1);
-    if (logger->filename) {
-        strcpy(logger->filename, log_filename);
+    // Slot 0 on top
+    for (int i = 0; i < capacity; i++) {
+        manager->free_slots[i] = capacity - 1 - i;
     }
+    manager->free_count = capacity;
+    return 0;
 }
 
-void client_protocol_cleanup(client_manager_t* manager, logger_t* logger) {
+void client_manager_cleanup(client_manager_t* manager) {
     if (manager) {
+        for (int i = 0; manager->slots && i < manager->high_water; i++) {
+            if (manager->slots[i]) outbound_queue_cleanup(&manager->slots[i]->outbound);
+        }
+        slab_cleanup(&manager->client_slab);
+        slab_cleanup(&manager->info_slab);
+        free(manager->slots);
+        free(manager->free_slots);
+        free(manager->pending);
+        free(manager->slot_by_fd);
+        manager->slots = NULL;
+        manager->free_slots = NULL;
+        manager->pending = NULL;
+        manager->slot_by_fd = NULL;
+        manager->capacity = 0;
+        manager->high_water = 0;
+        manager->free_count = 0;
+        manager->fd_capacity = 0;
         pthread_mutex_destroy(&manager->mutex);
     }
+}
+
+void client_manager_link_shards(client_manager_t* shards, int shard_count) {
+    if (!shards || shard_count <= 0) return;
     
-    if (logger) {
-        if (logger->log_file) {
-            fclose(logger->log_file);
-        }
-        if (logger->filename) {
-            free(logger->filename);
-        }
+    for (int i = 0; i < shard_count; i++) {
+        shards[i].shard_base = shards;
+        shards[i].shard_count = shard_count;
     }
 }
 
-// ============================================================================
-// CLIENT MANAGEMENT FUNCTIONS
-// ============================================================================
+// The client bound to a slot, or NULL for a slot never used. Lock-free.
+static client_t* client_manager_slot(client_manager_t* manager, uint32_t client_index) {
+    if (client_index >= (uint32_t)manager->capacity) return NULL;
+    return CLIENT_LOAD(manager->slots[client_index]);
+}
+
+// Gives a slot used for the first time its client and identity, both from
+// the slabs; caller holds the mutex
+static client_t* client_manager_bind_slot(client_manager_t* manager, int client_index) {
+    client_t* client = slab_alloc(&manager->client_slab);
+    client_info_t* info = slab_alloc(&manager->info_slab);
+    if (!client || !info) {
+        slab_free(&manager->client_slab, client);
+        slab_free(&manager->info_slab, info);
+        return NULL;
+    }
+    
+    client->socket = -1;
+    client->info = info;
+    client->slot = client_index;
+    outbound_queue_init(&client->outbound);
+    CLIENT_STORE(manager->slots[client_index], client);
+    if (client_index >= manager->high_water) manager->high_water = client_index + 1;
+    return client;
+}
 
-int client_manager_add_client(client_manager_t* manager, int socket, const char* ip, int port) {
-    if (!manager || socket < 0 || !ip) return -1;
+// Frees a slot; caller holds the mutex. The generation moves on first, so a
+// lookup racing with this sees either the old client or no client.
+// Rate group lists; caller holds the mutex and the client's telemetry_hz
+// names the group it is listed in
+static void client_group_link(client_manager_t* manager, client_t* client) {
+    client_t** head = &manager->groups[client->telemetry_hz];
+    client->group_prev = NULL;
+    client->group_next = *head;
+    if (*head) (*head)->group_prev = client;
+    *head = client;
+}
+
+static void client_group_unlink(client_manager_t* manager, client_t* client) {
+    if (client->group_prev) client->group_prev->group_next = client->group_next;
+    else manager->groups[client->telemetry_hz] = client->group_next;
+    if (client->group_next) client->group_next->group_prev = client->group_prev;
+    client->group_prev = NULL;
+    client->group_next = NULL;
+}
+
+static void client_manager_release_slot(client_manager_t* manager, int client_index) {
+    client_t* client = manager->slots[client_index];
+    client_group_unlink(manager, client);
+    CLIENT_STORE(client->generation, client->generation + 1);
+    CLIENT_STORE(manager->slot_by_fd[client->socket], 0);
+    outbound_queue_detach(&client->outbound);
+    timer_wheel_cancel(&manager->idle_wheel, &client->idle_timer);
+    CLIENT_STORE(client->socket, -1);
+    client->flags = 0;
+    client->info->username[0] = '\0';
+    manager->free_slots[manager->free_count++] = client_index;
+    manager->client_count--;
+}
+
+client_handle_t client_manager_add_client(client_manager_t* manager, int socket, const char* ip, int port) {
+    if (!manager || socket < 0 || !ip) return CLIENT_HANDLE_INVALID;
+    if (socket >= manager->fd_capacity) return CLIENT_HANDLE_INVALID; // no table entry for it
     
     pthread_mutex_lock(&manager->mutex);
     
-    if (manager->client_count >= MAX_CLIENTS) {
+    if (manager->free_count == 0) {
         pthread_mutex_unlock(&manager->mutex);
-        return -1; // No space available
+        return CLIENT_HANDLE_INVALID; // No space available
     }
     
-    // Find empty slot
-    int client_index = -1;
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (manager->clients[i].socket == -1) {
-            client_index = i;
-            break;
-        }
-    }
-    
-    if (client_index == -1) {
+    // Most recently freed slot: its client is already allocated and warm
+    int client_index = manager->free_slots[manager->free_count - 1];
+    client_t* client = manager->slots[client_index];
+    if (!client && !(client = client_manager_bind_slot(manager, client_index))) {
         pthread_mutex_unlock(&manager->mutex);
-        return -1; // No slots available
+        return CLIENT_HANDLE_INVALID; // Out of memory
     }
+    manager->free_count--;
     
     // Configure new client
-    manager->clients[client_index].socket = socket;
-    strncpy(manager->clients[client_index].ip, ip, INET_ADDRSTRLEN - 1);
-    manager->clients[client_index].ip[INET_ADDRSTRLEN - 1] = '\0';
-    manager->clients[client_index].port = port;
-    manager->clients[client_index].authenticated = 0;
-    manager->clients[client_index].is_admin = 0;
-    manager->clients[client_index].username[0] = '\0';
-    manager->clients[client_index].last_activity = time(NULL);
+    strncpy(client->info->ip, ip, INET_ADDRSTRLEN - 1);
+    client->info->ip[INET_ADDRSTRLEN - 1] = '\0';
+    client->info->port = port;
+    client->info->username[0] = '\0';
+    client->flags = 0;
+    client->last_activity = client_clock();
+    client->protocol = STREAM_TEXT;
+    client->telemetry_hz = 0;
+    client->telemetry_delta = 0;
+    client->delta_resync = 0;
+    client_group_link(manager, client);
+    outbound_queue_attach(&client->outbound, socket);
+    timer_wheel_schedule(&manager->idle_wheel, &client->idle_timer, client_idle_deadline(client->last_activity));
+    
+    // Publish: the slot is complete before a lookup can reach it
+    CLIENT_STORE(client->socket, socket);
+    CLIENT_STORE(client->generation, client->generation + 1);
+    CLIENT_STORE(manager->slot_by_fd[socket], (uint32_t)client_index + 1);
+    client_handle_t handle = ((client_handle_t)client->generation << 32) | (uint32_t)client_index;
     
     manager->client_count++;
     pthread_mutex_unlock(&manager->mutex);
     
-    return client_index;
+    return handle;
+}
+
+// Removes the client and closes its socket. Returns -1 if the handle is stale
+// (the slot was already freed), in which case the socket is left to the caller.
+// Why client_manager_add_client refused socket, for the rejection log line
+const char* client_manager_add_error(client_manager_t* manager, int socket) {
+    if (!manager || socket < 0) return "Error adding client";
+    if (socket >= manager->fd_capacity) return "Descriptor beyond the client table";
+    if (__atomic_load_n(&manager->client_count, __ATOMIC_RELAXED) >= manager->capacity) {
+        return "Maximum clients reached";
+    }
+    return "Error adding client";
 }
 
-void client_manager_remove_client(client_manager_t* manager, int client_index) {
-    if (!manager || client_index < 0 || client_index >= MAX_CLIENTS) return;
+int client_manager_remove_client(client_manager_t* manager, client_handle_t handle) {
+    if (!manager || handle == CLIENT_HANDLE_INVALID) return -1;
     
+    int removed = -1;
     pthread_mutex_lock(&manager->mutex);
     
-    if (manager->clients[client_index].socket != -1) {
-        socket_close_connection(manager->clients[client_index].socket);
-        manager->clients[client_index].socket = -1;
-        manager->clients[client_index].authenticated = 0;
-        manager->clients[client_index].is_admin = 0;
-        manager->clients[client_index].username[0] = '\0';
-        manager->client_count--;
+    client_t* client = client_manager_resolve(manager, handle);
+    if (client) {
+        int socket = client->socket;
+        client_manager_release_slot(manager, (int)(handle & 0xFFFFFFFFu));
+        socket_close_connection(socket);
+        removed = 0;
     }
     
     pthread_mutex_unlock(&manager->mutex);
+    return removed;
 }
 
+// O(1) and lock-free: the fd table names the slot, and the slot must still
+// hold this socket
 int client_manager_find_by_socket(client_manager_t* manager, int socket) {
-    if (!manager || socket < 0) return -1;
+    if (!manager || socket < 0 || socket >= manager->fd_capacity) return -1;
     
-    pthread_mutex_lock(&manager->mutex);
+    uint32_t entry = CLIENT_LOAD(manager->slot_by_fd[socket]);
+    if (entry == 0) return -1;
     
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (manager->clients[i].socket == socket) {
-            pthread_mutex_unlock(&manager->mutex);
-            return i;
-        }
-    }
+    client_t* client = client_manager_slot(manager, entry - 1);
+    if (!client || CLIENT_LOAD(client->socket) != socket) return -1;
+    return (int)entry - 1;
+}
+
+client_handle_t client_manager_handle(client_manager_t* manager, int client_index) {
+    if (!manager || client_index < 0) return CLIENT_HANDLE_INVALID;
+    
+    client_t* client = client_manager_slot(manager, (uint32_t)client_index);
+    if (!client) return CLIENT_HANDLE_INVALID;
+    uint32_t generation = CLIENT_LOAD(client->generation);
+    if ((generation & 1) == 0) return CLIENT_HANDLE_INVALID; // free slot
+    return ((client_handle_t)generation << 32) | (uint32_t)client_index;
+}
+
+// The client a handle names, or NULL once that client has been removed.
+// Lock-free; the pointer stays valid, but a holder without the lock must
+// resolve again to learn whether the client is still there.
+client_t* client_manager_resolve(client_manager_t* manager, client_handle_t handle) {
+    if (!manager || handle == CLIENT_HANDLE_INVALID) return NULL;
     
-    pthread_mutex_unlock(&manager->mutex);
-    return -1;
+    uint32_t generation = (uint32_t)(handle >> 32);
+    if ((generation & 1) == 0) return NULL;
+    
+    client_t* client = client_manager_slot(manager, (uint32_t)(handle & 0xFFFFFFFFu));
+    return client && CLIENT_LOAD(client->generation) == generation ? client : NULL;
 }
 
+// O(1) and lock-free: only the timestamp moves. The wheel entry keeps the
+// deadline it was scheduled with and is pushed back when it fires early.
 void client_manager_update_activity(client_manager_t* manager, int client_index) {
-    if (!manager || client_index < 0 || client_index >= MAX_CLIENTS) return;
+    if (!manager || client_index < 0) return;
     
-    pthread_mutex_lock(&manager->mutex);
-    if (manager->clients[client_index].socket != -1) {
-        manager->clients[client_index].last_activity = time(NULL);
-    }
-    pthread_mutex_unlock(&manager->mutex);
+    client_t* client = client_manager_slot(manager, (uint32_t)client_index);
+    if (client) __atomic_store_n(&client->last_activity, client_clock(), __ATOMIC_RELAXED);
 }
 
-void client_manager_cleanup_inactive(client_manager_t* manager) {
-    if (!manager) return;
-    
-    time_t current_time = time(NULL);
+// Advances the idle wheel to the current second. A client whose deadline
+// came up without activity since has its slot freed and its connection shut
+// down, which wakes the owner (thread or event loop) to see its handle stale
+// and close the socket; the others are rescheduled from their last activity.
+// Costs the deadlines due, not the number of clients. Returns the number of
+// clients disconnected.
+int client_manager_cleanup_inactive(client_manager_t* manager) {
+    if (!manager) return 0;
+    
+    int expired = 0;
     pthread_mutex_lock(&manager->mutex);
     
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (manager->clients[i].socket != -1) {
-            if (current_time - manager->clients[i].last_activity > CLIENT_TIMEOUT_SECONDS) {
-                // Mark as inactive but don't close here (handled in main thread)
-                manager->clients[i].socket = -1;
-                manager->client_count--;
-            }
+    unsigned long long now = (unsigned long long)client_clock();
+    timer_entry_t* entry = timer_wheel_advance(&manager->idle_wheel, now);
+    while (entry) {
+        timer_entry_t* next = entry->next;
+        client_t* client = (client_t*)((char*)entry - offsetof(client_t, idle_timer));
+        unsigned long long deadline = client_idle_deadline(__atomic_load_n(&client->last_activity, __ATOMIC_RELAXED));
+        if (deadline > now) {
+            timer_wheel_schedule(&manager->idle_wheel, entry, deadline);
+        } else {
+            // The owner still holds the descriptor, so it cannot be reused yet
+            shutdown(client->socket, SHUT_RDWR);
+            client_manager_release_slot(manager, client->slot);
+            expired++;
         }
+        entry = next;
     }
     
     pthread_mutex_unlock(&manager->mutex);
+    return expired;
+}
+
+// Shared buffers for one tick, each created the first time a client needs it
+typedef struct {
+    const telemetry_tick_t* tick;
+    shared_buffer_t* keyframes[STREAM_PROTOCOL_COUNT];
+    shared_buffer_t* deltas[SUBSCRIBE_GROUP_COUNT][STREAM_PROTOCOL_COUNT];
+} tick_buffers_t;
+
+static shared_buffer_t* tick_buffer(shared_buffer_t** slot, const char* data, size_t length) {
+    if (!*slot) *slot = shared_buffer_create(data, length);
+    return *slot;
 }
 
-void client_manager_send_to_all(client_manager_t* manager, const char* data) {
-    if (!manager || !data) return;
+// Queues this tick's frame for one client, under the registry lock.
+// Returns 1 if something was queued.
+static int client_queue_tick(client_t* client, tick_buffers_t* buffers) {
+    const char* data;
+    size_t length;
+    stream_protocol_t protocol = client->protocol;
+    telemetry_kind_t kind = telemetry_tick_select(buffers->tick, client->telemetry_hz, protocol,
+                                                  client->telemetry_delta, client->delta_resync, &data, &length);
+    if (kind == TELEMETRY_SKIP) return 0;
+    
+    shared_buffer_t* keyframe = tick_buffer(&buffers->keyframes[protocol], buffers->tick->keyframe[protocol],
+                                            buffers->tick->keyframe_length[protocol]);
+    if (!keyframe) return 0;
+    
+    int result;
+    if (kind == TELEMETRY_DELTA) {
+        shared_buffer_t* delta = tick_buffer(&buffers->deltas[client->telemetry_hz][protocol], data, length);
+        if (!delta) return 0;
+        result = outbound_queue_push_delta(&client->outbound, delta, keyframe);
+    } else {
+        result = outbound_queue_push(&client->outbound, keyframe, OUTBOUND_TELEMETRY);
+        if (result == 0) client->delta_resync = 0;
+    }
+    
+    // A refused frame leaves the client behind its group's deltas
+    if (result > 0) client->delta_resync = 1;
+    return result >= 0;
+}
+
+// Queues the tick's frame for every client whose rate group is due, in the
+// encoding and delta mode it asked for, under the registry lock, then
+// flushes each queue without it; a slow socket only keeps its own bytes
+// queued. Only the lists of the due groups are walked, so a tick costs its
+// recipients, not the registry size. Each frame is copied into one shared
+// buffer at most.
+void client_manager_send_to_all(client_manager_t* manager, const telemetry_tick_t* tick) {
+    if (!manager || !tick) return;
+    
+    outbound_queue_t** queued = manager->pending;
+    int queued_count = 0;
+    tick_buffers_t buffers;
+    memset(&buffers, 0, sizeof(buffers));
+    buffers.tick = tick;
     
     pthread_mutex_lock(&manager->mutex);
     
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (manager->clients[i].socket != -1) {
-            socket_send_data(manager->clients[i].socket, data, strlen(data));
+    for (int group = 0; group < SUBSCRIBE_GROUP_COUNT; group++) {
+        if (!tick->groups[group]) continue;
+        for (client_t* client = manager->groups[group]; client; client = client->group_next) {
+            if (client_queue_tick(client, &buffers)) queued[queued_count++] = &client->outbound;
         }
     }
     
     pthread_mutex_unlock(&manager->mutex);
+    
+    // Clients stay bound to their slots, so queues stay valid after the unlock;
+    // a client detached in between simply has nothing left to flush
+    for (int i = 0; i < queued_count; i++) {
+        outbound_queue_flush(queued[i]);
+    }
+    
+    for (int p = 0; p < STREAM_PROTOCOL_COUNT; p++) {
+        shared_buffer_release(buffers.keyframes[p]);
+        for (int group = 0; group < SUBSCRIBE_GROUP_COUNT; group++) {
+            shared_buffer_release(buffers.deltas[group][p]);
+        }
+    }
 }
 
-client_t* client_manager_get_client(client_manager_t* manager, int client_index) {
-    if (!manager || client_index < 0 || client_index >= MAX_CLIENTS) return NULL;
+// Queues data behind anything already pending for the client a handle names
+// and flushes without blocking. The handle is checked under the registry
+// lock, so a slot freed and reused meanwhile never gets another connection's
+// response. Returns -1 on socket error, for a stale handle, and when the
+// client is over its outbound limit and the response is refused, so the
+// caller closes it.
+int client_send(client_manager_t* manager, client_handle_t handle, const char* data, size_t length) {
+    if (!manager || !data) return -1;
+    
+    shared_buffer_t* buffer = shared_buffer_create(data, length);
+    if (!buffer) return -1;
+    pthread_mutex_lock(&manager->mutex);
+    client_t* client = client_manager_resolve(manager, handle);
+    int result = client ? outbound_queue_push(&client->outbound, buffer, OUTBOUND_RESPONSE) : -1;
+    pthread_mutex_unlock(&manager->mutex);
+    shared_buffer_release(buffer);
+    if (result != 0) return -1;
     
+    // A queue only ever writes to the socket attached to it, so flushing after
+    // a reuse sends the new connection its own output
+    return outbound_queue_flush(&client->outbound) < 0 ? -1 : 0;
+}
+
+// Like client_send, for output that changes the client's protocol or rate:
+// queueing it and switching the broadcast encoding and group happen under the
+// registry lock, so no telemetry frame lands on the wrong side of the response.
+// A client too far behind to take the response is not switched and gets -1:
+// its parser already moved on, so it cannot be served either way.
+int client_send_switch(client_manager_t* manager, client_handle_t handle, const char* data, size_t length,
+                       const stream_input_t* input) {
+    if (!manager || !data || !input) return -1;
+    
+    shared_buffer_t* buffer = shared_buffer_create(data, length);
+    if (!buffer) return -1;
     pthread_mutex_lock(&manager->mutex);
-    client_t* client = &manager->clients[client_index];
+    client_t* client = client_manager_resolve(manager, handle);
+    int result = client ? outbound_queue_push(&client->outbound, buffer, OUTBOUND_RESPONSE) : -1;
+    if (result == 0) {
+        client_group_unlink(manager, client);
+        client->protocol = input->protocol;
+        client->telemetry_hz = input->telemetry_hz;
+        client_group_link(manager, client);
+        client->telemetry_delta = input->telemetry_delta;
+        client->delta_resync = 1; // a new group or encoding shares no deltas with the old one
+    }
     pthread_mutex_unlock(&manager->mutex);
+    shared_buffer_release(buffer);
+    if (result != 0) return -1;
     
-    return client;
+    return outbound_queue_flush(&client->outbound) < 0 ? -1 : 0;
+}
+
+client_t* client_manager_get_client(client_manager_t* manager, int client_index) {
+    if (!manager || client_index < 0) return NULL;
+    
+    return client_manager_slot(manager, (uint32_t)client_index);
+}
+
+// Heap held by the registry: tables sized by the capacity and the fd limit,
+// plus the slab chunks of every slot used so far
+size_t client_manager_memory_bytes(client_manager_t* manager) {
+    if (!manager) return 0;
+    
+    return (size_t)manager->capacity * (sizeof(client_t*) + sizeof(int) + sizeof(outbound_queue_t*)) +
+           (size_t)manager->fd_capacity * sizeof(uint32_t) +
+           slab_memory_bytes(&manager->client_slab) + slab_memory_bytes(&manager->info_slab);
 }
 
 int client_manager_authenticate_client(client_manager_t* manager, int client_index, const char* username, const char* password) {
-    if (!manager || client_index < 0 || client_index >= MAX_CLIENTS || !username || !password) {
+    if (!manager || client_index < 0 || !username || !password) {
         return 0;
     }
     
@@ -197,11 +508,11 @@ int client_manager_authenticate_client(client_manager_t* manager, int client_ind
     if (strcmp(username, DEFAULT_USERNAME) == 0 && strcmp(password, DEFAULT_PASSWORD) == 0) {
         pthread_mutex_lock(&manager->mutex);
         
-        if (manager->clients[client_index].socket != -1) {
-            manager->clients[client_index].authenticated = 1;
-            manager->clients[client_index].is_admin = 1;
-            strncpy(manager->clients[client_index].username, username, MAX_USERNAME - 1);
-            manager->clients[client_index].username[MAX_USERNAME - 1] = '\0';
+        client_t* client = client_manager_slot(manager, (uint32_t)client_index);
+        if (client && client->socket != -1) {
+            client->flags |= CLIENT_AUTHENTICATED | CLIENT_ADMIN;
+            strncpy(client->info->username, username, MAX_USERNAME - 1);
+            client->info->username[MAX_USERNAME - 1] = '\0';
         }
         
         pthread_mutex_unlock(&manager->mutex);
@@ -211,67 +522,51 @@ int client_manager_authenticate_client(client_manager_t* manager, int client_ind
     return 0; // Authentication failed
 }
 
-// ============================================================================
-// PROTOCOL FUNCTIONS
-// ============================================================================
-
-command_type_t protocol_parse_command(const char* command, parsed_command_t* parsed) {
-    if (!command || !parsed) return CMD_UNKNOWN;
-    
-    // Clear structure
-    memset(parsed, 0, sizeof(parsed_command_t));
-    
-    char cmd_copy[BUFFER_SIZE];
-    strncpy(cmd_copy, command, sizeof(cmd_copy) - 1);
-    cmd_copy[sizeof(cmd_copy) - 1] = '\0';
-    
-    // Parse authentication command
-    if (strncmp(cmd_copy, "AUTH:", 5) == 0) {
-        parsed->type = CMD_AUTH;
-        sscanf(cmd_copy, "AUTH: %s %s", parsed->param1, parsed->param2);
-        return CMD_AUTH;
-    }
-    
-    // Parse data request
-    if (strncmp(cmd_copy, "GET_DATA:", 9) == 0) {
-        parsed->type = CMD_GET_DATA;
-        return CMD_GET_DATA;
-    }
-    
-    // Parse vehicle control command
-    if (strncmp(cmd_copy, "SEND_CMD:", 9) == 0) {
-        parsed->type = CMD_SEND_CMD;
-        sscanf(cmd_copy, "SEND_CMD: %s", parsed->param1);
-        return CMD_SEND_CMD;
-    }
-    
-    // Parse user list request
-    if (strncmp(cmd_copy, "LIST_USERS:", 11) == 0) {
-        parsed->type = CMD_LIST_USERS;
-        return CMD_LIST_USERS;
+// Authenticates with a token from an earlier AUTH, possibly made before the
+// last restart, and gives the client the identity it was issued to
+int client_manager_resume_client(client_manager_t* manager, int client_index, string_view_t token,
+                                 char* username, size_t username_size) {
+    if (!manager || !manager->tokens || client_index < 0 || !username || username_size == 0) {
+        return 0;
     }
     
-    // Parse recharge request
-    if (strncmp(cmd_copy, "RECHARGE:", 9) == 0) {
-        parsed->type = CMD_RECHARGE;
-        return CMD_RECHARGE;
+    unsigned flags;
+    if (token_resume(manager->tokens, token.data, token.length, username, username_size, &flags) != 0) {
+        return 0;
     }
     
-    // Parse disconnect request
-    if (strncmp(cmd_copy, "DISCONNECT:", 11) == 0) {
-        parsed->type = CMD_DISCONNECT;
-        return CMD_DISCONNECT;
+    pthread_mutex_lock(&manager->mutex);
+    client_t* client = client_manager_slot(manager, (uint32_t)client_index);
+    if (client && client->socket != -1) {
+        client->flags |= flags & (CLIENT_AUTHENTICATED | CLIENT_ADMIN);
+        strncpy(client->info->username, username, MAX_USERNAME - 1);
+        client->info->username[MAX_USERNAME - 1] = '\0';
     }
-    
-    return CMD_UNKNOWN;
+    pthread_mutex_unlock(&manager->mutex);
+    return 1;
 }
 
+// ============================================================================
+// PROTOCOL FUNCTIONS
+// ============================================================================
+
 void protocol_handle_command(parsed_command_t* cmd, int client_socket, 
-                            client_manager_t* client_mgr, vehicle_state_t* vehicle, 
+                            client_manager_t* client_mgr, fleet_t* fleet, 
                             logger_t* logger) {
-    if (!cmd || !client_mgr || !vehicle || !logger) return;
+    if (!cmd || !client_mgr || !fleet || !logger) return;
     
     char response[BUFFER_SIZE];
+    protocol_build_response(cmd, client_socket, client_mgr, fleet, logger, response, sizeof(response));
+    protocol_send_response(client_socket, response, logger);
+}
+
+void protocol_build_response(parsed_command_t* cmd, int client_socket, 
+                             client_manager_t* client_mgr, fleet_t* fleet, 
+                             logger_t* logger, char* response, size_t response_size) {
+    if (!response || response_size < BUFFER_SIZE) return;
+    response[0] = '\0';
+    if (!cmd || !client_mgr || !fleet || !logger) return;
+    
     int client_index = client_manager_find_by_socket(client_mgr, client_socket);
     
     switch (cmd->type) {
@@ -281,18 +576,57 @@ void protocol_handle_command(parsed_command_t* cmd, int client_socket,
                 break;
             }
             
-            if (client_manager_authenticate_client(client_mgr, client_index, cmd->param1, cmd->param2)) {
-                strcpy(response, "AUTH_SUCCESS\r\n\r\n");
-                logger_log(logger, LOG_AUTH_SUCCESS, "", 0, cmd->param1);
+            // Credentials longer than the fields can never match
+            char username[MAX_USERNAME] = "";
+            char password[MAX_PASSWORD] = "";
+            int fits = 1;
+            if (cmd->param_count > 0 &&
+                string_view_copy(cmd->params[0], username, sizeof(username)) >= sizeof(username)) fits = 0;
+            if (cmd->param_count > 1 &&
+                string_view_copy(cmd->params[1], password, sizeof(password)) >= sizeof(password)) fits = 0;
+            
+            if (fits && client_manager_authenticate_client(client_mgr, client_index, username, password)) {
+                // The token lets a reconnecting client skip the password
+                char token[TOKEN_TEXT_SIZE];
+                if (client_mgr->tokens &&
+                    token_issue(client_mgr->tokens, username, CLIENT_AUTHENTICATED | CLIENT_ADMIN, token) == 0) {
+                    snprintf(response, response_size, "AUTH_SUCCESS\r\nTOKEN: %s\r\n\r\n", token);
+                } else {
+                    strcpy(response, "AUTH_SUCCESS\r\n\r\n");
+                }
+                logger_log(logger, LOG_AUTH_SUCCESS, "", 0, username);
+            } else {
+                strcpy(response, "AUTH_FAILED\r\n\r\n");
+                logger_log(logger, LOG_AUTH_FAILED, "", 0, username);
+            }
+            break;
+        }
+        
+        case CMD_RESUME: {
+            if (client_index == -1) {
+                strcpy(response, "ERROR: Client not found\r\n\r\n");
+                break;
+            }
+            
+            char username[MAX_USERNAME];
+            if (cmd->param_count == 1 &&
+                client_manager_resume_client(client_mgr, client_index, cmd->params[0], username, sizeof(username))) {
+                snprintf(response, response_size, "AUTH_SUCCESS\r\nTOKEN: %.*s\r\n\r\n",
+                         (int)cmd->params[0].length, cmd->params[0].data);
+                logger_log(logger, LOG_AUTH_SUCCESS, "", 0, username);
             } else {
                 strcpy(response, "AUTH_FAILED\r\n\r\n");
-                logger_log(logger, LOG_AUTH_FAILED, "", 0, cmd->param1);
+                logger_log(logger, LOG_AUTH_FAILED, "", 0, "session token");
             }
             break;
         }
         
         case CMD_GET_DATA: {
-            vehicle_format_telemetry(vehicle, response, sizeof(response));
+            if (!fleet_contains(fleet, cmd->vehicle_id)) {
+                strcpy(response, "ERROR: Unknown vehicle\r\n\r\n");
+                break;
+            }
+            fleet_format_telemetry(fleet, (int)cmd->vehicle_id, response, response_size);
             logger_log_simple(logger, LOG_DATA_SENT, "Telemetry data sent");
             break;
         }
@@ -304,34 +638,48 @@ void protocol_handle_command(parsed_command_t* cmd, int client_socket,
             }
             
             client_t* client = client_manager_get_client(client_mgr, client_index);
-            if (!client || !client->is_admin) {
+            if (!client || !(client->flags & CLIENT_ADMIN)) {
                 strcpy(response, "ERROR: Not authorized\r\n\r\n");
                 break;
             }
             
-            // Process vehicle control command
-            if (strcmp(cmd->param1, "SPEED_UP") == 0) {
-                int new_speed = vehicle_speed_up(vehicle);
-                if (new_speed >= 0) {
-                    snprintf(response, sizeof(response), "OK: Speed increased to %d km/h\r\n\r\n", new_speed);
-                } else {
-                    strcpy(response, "ERROR: Maximum speed reached\r\n\r\n");
+            if (!fleet_contains(fleet, cmd->vehicle_id)) {
+                strcpy(response, "ERROR: Unknown vehicle\r\n\r\n");
+                break;
+            }
+            
+            // Process vehicle control command (decoded by the parser)
+            int id = (int)cmd->vehicle_id;
+            switch (cmd->vehicle_cmd) {
+                case VEHICLE_CMD_SPEED_UP: {
+                    int new_speed = fleet_speed_up(fleet, id);
+                    if (new_speed >= 0) {
+                        snprintf(response, response_size, "OK: Speed increased to %d km/h\r\n\r\n", new_speed);
+                    } else {
+                        strcpy(response, "ERROR: Maximum speed reached\r\n\r\n");
+                    }
+                    break;
                 }
-            } else if (strcmp(cmd->param1, "SLOW_DOWN") == 0) {
-                int new_speed = vehicle_slow_down(vehicle);
-                if (new_speed >= 0) {
-                    snprintf(response, sizeof(response), "OK: Speed reduced to %d km/h\r\n\r\n", new_speed);
-                } else {
-                    strcpy(response, "ERROR: Minimum speed reached\r\n\r\n");
+                case VEHICLE_CMD_SLOW_DOWN: {
+                    int new_speed = fleet_slow_down(fleet, id);
+                    if (new_speed >= 0) {
+                        snprintf(response, response_size, "OK: Speed reduced to %d km/h\r\n\r\n", new_speed);
+                    } else {
+                        strcpy(response, "ERROR: Minimum speed reached\r\n\r\n");
+                    }
+                    break;
                 }
-            } else if (strcmp(cmd->param1, "TURN_LEFT") == 0) {
-                vehicle_set_direction(vehicle, "LEFT");
-                strcpy(response, "OK: Turning left\r\n\r\n");
-            } else if (strcmp(cmd->param1, "TURN_RIGHT") == 0) {
-                vehicle_set_direction(vehicle, "RIGHT");
-                strcpy(response, "OK: Turning right\r\n\r\n");
-            } else {
-                strcpy(response, "ERROR: Invalid command\r\n\r\n");
+                case VEHICLE_CMD_TURN_LEFT:
+                    fleet_set_direction(fleet, id, DIRECTION_LEFT);
+                    strcpy(response, "OK: Turning left\r\n\r\n");
+                    break;
+                case VEHICLE_CMD_TURN_RIGHT:
+                    fleet_set_direction(fleet, id, DIRECTION_RIGHT);
+                    strcpy(response, "OK: Turning right\r\n\r\n");
+                    break;
+                default:
+                    strcpy(response, "ERROR: Invalid command\r\n\r\n");
+                    break;
             }
             break;
         }
@@ -343,25 +691,36 @@ void protocol_handle_command(parsed_command_t* cmd, int client_socket,
             }
             
             client_t* client = client_manager_get_client(client_mgr, client_index);
-            if (!client || !client->is_admin) {
+            if (!client || !(client->flags & CLIENT_ADMIN)) {
                 strcpy(response, "ERROR: Not authorized\r\n\r\n");
                 break;
             }
             
-            // Build list of connected users
-            strcpy(response, "USERS: ");
-            pthread_mutex_lock(&client_mgr->mutex);
-            for (int i = 0; i < MAX_CLIENTS; i++) {
-                if (client_mgr->clients[i].socket != -1) {
-                    char user_info[200];
-                    snprintf(user_info, sizeof(user_info), "%s(%s:%d) ", 
-                            client_mgr->clients[i].username, 
-                            client_mgr->clients[i].ip, 
-                            client_mgr->clients[i].port);
-                    strcat(response, user_info);
+            // Build list of connected users (truncated to fit one message)
+            const size_t terminator_len = strlen("\r\n\r\n");
+            size_t used = (size_t)snprintf(response, response_size, "USERS: ");
+            int full = 0;
+            for (int shard = 0; shard < client_mgr->shard_count && !full; shard++) {
+                client_manager_t* mgr = &client_mgr->shard_base[shard];
+                pthread_mutex_lock(&mgr->mutex);
+                for (int i = 0; i < mgr->high_water; i++) {
+                    if (mgr->slots[i]->socket != -1) {
+                        const client_info_t* info = mgr->slots[i]->info;
+                        char user_info[200];
+                        int len = snprintf(user_info, sizeof(user_info), "%s(%s:%d) ", 
+                                info->username, 
+                                info->ip, 
+                                info->port);
+                        if (len < 0 || used + (size_t)len + terminator_len >= response_size) {
+                            full = 1;
+                            break;
+                        }
+                        memcpy(response + used, user_info, (size_t)len + 1);
+                        used += (size_t)len;
+                    }
                 }
+                pthread_mutex_unlock(&mgr->mutex);
             }
-            pthread_mutex_unlock(&client_mgr->mutex);
             strcat(response, "\r\n\r\n");
             logger_log_simple(logger, LOG_USERS_LIST, "User list sent");
             break;
@@ -374,12 +733,17 @@ void protocol_handle_command(parsed_command_t* cmd, int client_socket,
             }
             
             client_t* client = client_manager_get_client(client_mgr, client_index);
-            if (!client || !client->is_admin) {
+            if (!client || !(client->flags & CLIENT_ADMIN)) {
                 strcpy(response, "ERROR: Not authorized\r\n\r\n");
                 break;
             }
             
-            vehicle_recharge_battery(vehicle);
+            if (!fleet_contains(fleet, cmd->vehicle_id)) {
+                strcpy(response, "ERROR: Unknown vehicle\r\n\r\n");
+                break;
+            }
+            
+            fleet_recharge_battery(fleet, (int)cmd->vehicle_id);
             strcpy(response, "OK: Battery recharged to 100%\r\n\r\n");
             logger_log_simple(logger, LOG_COMMAND_EXECUTED, "Battery recharged");
             break;
@@ -398,112 +762,235 @@ void protocol_handle_command(parsed_command_t* cmd, int client_socket,
             break;
         }
     }
-    
-    protocol_send_response(client_socket, response, logger);
 }
 
-void protocol_send_response(int socket, const char* response, logger_t* logger) {
-    if (socket < 0 || !response) return;
+// Answers PROTOCOL: TEXT | BINARY [version]. Returns the protocol for the
+// messages that follow; the response itself goes out in the current one.
+static stream_protocol_t protocol_negotiate(parsed_command_t* cmd, stream_protocol_t current,
+                                            char* response, size_t response_size) {
+    if (cmd->param_count > 0 && string_view_equals(cmd->params[0], "TEXT")) {
+        snprintf(response, response_size, "OK: Protocol TEXT\r\n\r\n");
+        return STREAM_TEXT;
+    }
     
-    if (socket_send_data(socket, response, strlen(response)) < 0) {
-        perror("Error sending response");
+    if (cmd->param_count > 0 && string_view_equals(cmd->params[0], "BINARY")) {
+        char version[16] = "";
+        if (cmd->param_count > 1) string_view_copy(cmd->params[1], version, sizeof(version));
+        if (cmd->param_count < 2 || atoi(version) == WIRE_VERSION) {
+            snprintf(response, response_size, "OK: Protocol BINARY %d\r\n\r\n", WIRE_VERSION);
+            return STREAM_BINARY;
+        }
     }
     
-    logger_log(logger, LOG_RESPONSE, "", 0, response);
+    snprintf(response, response_size, "ERROR: Unsupported protocol\r\n\r\n");
+    return current;
 }
 
-void protocol_send_telemetry_to_all(client_manager_t* client_mgr, vehicle_state_t* vehicle, logger_t* logger) {
-    if (!client_mgr || !vehicle || !logger) return;
-    
-    char telemetry_data[BUFFER_SIZE];
-    vehicle_format_telemetry(vehicle, telemetry_data, sizeof(telemetry_data));
+// Answers SUBSCRIBE: <hz> [DELTA], hz 0 to go back to the periodic broadcast.
+// Updates the rate group and delta mode for the telemetry that follows.
+static void protocol_subscribe(parsed_command_t* cmd, stream_input_t* input, char* response, size_t response_size) {
+    char rate[16] = "";
+    int hz;
+    int delta = cmd->param_count == 2 && string_view_equals(cmd->params[1], "DELTA");
+    if (cmd->param_count < 1 || (cmd->param_count > 1 && !delta) ||
+        string_view_copy(cmd->params[0], rate, sizeof(rate)) >= sizeof(rate) ||
+        subscription_parse_rate(rate, &hz) != 0) {
+        snprintf(response, response_size,
+                 "ERROR: Usage SUBSCRIBE: <hz> [DELTA], rate %d-%d Hz or 0 to unsubscribe\r\n\r\n",
+                 SUBSCRIBE_MIN_HZ, SUBSCRIBE_MAX_HZ);
+        return;
+    }
     
-    client_manager_send_to_all(client_mgr, telemetry_data);
-    logger_log_simple(logger, LOG_DATA_SENT, "Telemetry sent to all clients");
+    const char* mode = delta ? " (delta)" : "";
+    if (hz == 0) {
+        snprintf(response, response_size, "OK: Unsubscribed%s\r\n\r\n", mode);
+    } else {
+        snprintf(response, response_size, "OK: Subscribed at %d Hz%s\r\n\r\n", hz, mode);
+    }
+    subscription_move(input->telemetry_hz, hz);
+    input->telemetry_hz = hz;
+    input->telemetry_delta = delta;
 }
 
-// ============================================================================
-// LOGGING FUNCTIONS
-// ============================================================================
-
-void logger_print_timestamp(FILE* file) {
-    time_t now = time(NULL);
-    struct tm* tm_info = localtime(&now);
-    char timestamp[64];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
-    fprintf(file, "[%s] ", timestamp);
+// GET_HISTORY time: Unix seconds, or seconds before now when <= 0
+static int protocol_history_time(string_view_t view, long long now_ms, long long* time_ms) {
+    char text[24];
+    if (string_view_copy(view, text, sizeof(text)) >= sizeof(text) || text[0] == '\0') return -1;
+    
+    char* end;
+    long long seconds = strtoll(text, &end, 10);
+    if (*end != '\0' || seconds < -HISTORY_MAX_SECONDS || seconds > LLONG_MAX / 1000) return -1;
+    
+    *time_ms = seconds <= 0 ? now_ms + seconds * 1000 : seconds * 1000;
+    return 0;
 }
 
-void logger_log(logger_t* logger, log_type_t type, const char* ip, int port, const char* message) {
-    if (!logger || !logger->log_file) return;
+// Answers GET_HISTORY: <from> <to> [step_ms] straight into output, since a
+// range can be far larger than a response buffer. Returns 1 once answered,
+// 0 if response holds an error to send instead, -1 if output cannot grow.
+static int protocol_history(parsed_command_t* cmd, stream_protocol_t protocol, fleet_t* fleet,
+                            stream_output_t* output, char* response, size_t response_size) {
+    if (!fleet->history) {
+        snprintf(response, response_size, "ERROR: History disabled\r\n\r\n");
+        return 0;
+    }
+    
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    long long now_ms = (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    long long from_ms, to_ms;
+    long step_ms = 0;
+    int valid = cmd->param_count >= 2 &&
+                protocol_history_time(cmd->params[0], now_ms, &from_ms) == 0 &&
+                protocol_history_time(cmd->params[1], now_ms, &to_ms) == 0;
+    if (valid && cmd->param_count > 2) {
+        char step[16];
+        char* end;
+        valid = string_view_copy(cmd->params[2], step, sizeof(step)) < sizeof(step);
+        step_ms = strtol(step, &end, 10);
+        valid = valid && *end == '\0' && step_ms >= 0 && step_ms <= HISTORY_MAX_SECONDS * 1000L;
+    }
+    if (!valid) {
+        snprintf(response, response_size,
+                 "ERROR: Usage GET_HISTORY: <from> <to> [step_ms], Unix seconds or <= 0 for seconds ago\r\n\r\n");
+        return 0;
+    }
     
-    // Print timestamp
-    logger_print_timestamp(logger->log_file);
+    history_point_t points[HISTORY_MAX_POINTS];
+    history_range_t range;
+    history_query(fleet->history, from_ms, to_ms, (int)step_ms, points, HISTORY_MAX_POINTS, &range);
     
-    // Print log type and message
-    fprintf(logger->log_file, "[%s] ", logger_type_to_string(type));
-    if (ip && strlen(ip) > 0) {
-        fprintf(logger->log_file, "%s:%d - ", ip, port);
+    if (protocol == STREAM_BINARY) {
+        unsigned char frame[WIRE_HEADER_SIZE + WIRE_HISTORY_HEADER + HISTORY_MAX_POINTS * WIRE_HISTORY_POINT_SIZE];
+        size_t size = wire_encode_history(&range, points, frame, sizeof(frame));
+        return stream_output_append(output, (const char*)frame, size) == 0 ? 1 : -1;
     }
-    fprintf(logger->log_file, "%s\n", message);
-    fflush(logger->log_file);
     
-    // Also print to console
-    printf("[%s] ", logger_type_to_string(type));
-    if (ip && strlen(ip) > 0) {
-        printf("%s:%d - ", ip, port);
+    // One line per point after the header; the blank line ends the message
+    char text[64 + HISTORY_MAX_POINTS * 32];
+    size_t used = (size_t)snprintf(text, sizeof(text), "HISTORY: %d %d\r\nFROM: %lld\r\n",
+                                   range.count, range.step_ms, range.from_ms);
+    for (int i = 0; i < range.count; i++) {
+        used += (size_t)snprintf(text + used, sizeof(text) - used, "%d %d %d %s\r\n",
+                                 points[i].speed, points[i].battery, points[i].temperature,
+                                 vehicle_direction_to_string(points[i].direction));
     }
-    printf("%s\n", message);
+    used += (size_t)snprintf(text + used, sizeof(text) - used, "\r\n");
+    return stream_output_append(output, text, used) == 0 ? 1 : -1;
 }
 
-void logger_log_simple(logger_t* logger, log_type_t type, const char* message) {
-    logger_log(logger, type, "", 0, message);
+// Text responses go out as built; binary ones as a RESPONSE frame, which
+// carries the length instead of the terminator
+static int protocol_append_response(stream_output_t* output, stream_protocol_t protocol,
+                                    command_type_t type, const char* response) {
+    size_t length = strlen(response);
+    if (protocol == STREAM_TEXT) return stream_output_append(output, response, length);
+    
+    if (length >= STREAM_TERMINATOR_LEN &&
+        memcmp(response + length - STREAM_TERMINATOR_LEN, STREAM_TERMINATOR, STREAM_TERMINATOR_LEN) == 0) {
+        length -= STREAM_TERMINATOR_LEN;
+    }
+    unsigned char frame[WIRE_HEADER_SIZE + BUFFER_SIZE];
+    size_t size = wire_encode_response(wire_command_to_opcode(type), response, length, frame, sizeof(frame));
+    return stream_output_append(output, (const char*)frame, size);
 }
 
-// ============================================================================
-// HELPER FUNCTIONS
-// ============================================================================
+// Runs every complete message buffered in input through the protocol, in
+// order, and collects the responses in output so they go out in one write.
+// Each response uses the protocol its command arrived in.
+// Returns 1 if the client asked to disconnect, 0 otherwise, -1 on error
+// (including a malformed binary frame, after which the connection is closed).
+int protocol_handle_stream(stream_input_t* input, stream_output_t* output, int client_socket,
+                           const char* ip, int port, client_manager_t* client_mgr,
+                           fleet_t* fleet, logger_t* logger) {
+    if (!input || !output || !client_mgr || !fleet || !logger) return -1;
+    
+    char* message;
+    size_t length;
+    int processed = 0;
+    while ((message = stream_input_next(input, &length)) != NULL) {
+        if (processed++ == 0) {
+            int client_index = client_manager_find_by_socket(client_mgr, client_socket);
+            if (client_index != -1) {
+                client_manager_update_activity(client_mgr, client_index);
+            }
+        }
+        
+        stream_protocol_t protocol = input->protocol;
+        parsed_command_t parsed_cmd;
+        char response[BUFFER_SIZE];
+        
+        if (protocol == STREAM_BINARY) {
+            if (wire_decode_command((const unsigned char*)message, length, &parsed_cmd) != 0) {
+                // Framing is lost: nothing after this frame can be trusted
+                logger_log(logger, LOG_ERROR, ip, port, "Malformed binary frame");
+                return -1;
+            }
+            char line[BUFFER_SIZE];
+            snprintf(line, sizeof(line), "%s: %.*s", protocol_command_type_to_string(parsed_cmd.type),
+                     (int)(length - WIRE_HEADER_SIZE), message + WIRE_HEADER_SIZE);
+            logger_log(logger, LOG_COMMAND, ip, port, line);
+        } else {
+            logger_log(logger, LOG_COMMAND, ip, port, message);
+            protocol_parse_command(message, &parsed_cmd);
+        }
+        
+        if (parsed_cmd.type == CMD_PROTOCOL) {
+            input->protocol = protocol_negotiate(&parsed_cmd, protocol, response, sizeof(response));
+        } else if (parsed_cmd.type == CMD_SUBSCRIBE) {
+            protocol_subscribe(&parsed_cmd, input, response, sizeof(response));
+        } else if (parsed_cmd.type == CMD_GET_HISTORY) {
+            int answered = protocol_history(&parsed_cmd, protocol, fleet, output, response, sizeof(response));
+            if (answered < 0) return -1;
+            if (answered > 0) {
+                logger_log_simple(logger, LOG_DATA_SENT, "History sent");
+                continue;
+            }
+        } else if (protocol == STREAM_BINARY && parsed_cmd.type == CMD_GET_DATA &&
+                   fleet_contains(fleet, parsed_cmd.vehicle_id)) {
+            vehicle_snapshot_t snapshot;
+            time_t now = fleet_sample_telemetry(fleet, (int)parsed_cmd.vehicle_id, &snapshot);
+            unsigned char frame[WIRE_TELEMETRY_FRAME_SIZE];
+            wire_encode_telemetry(&snapshot, now, frame);
+            if (stream_output_append(output, (const char*)frame, sizeof(frame)) != 0) return -1;
+            logger_log_simple(logger, LOG_DATA_SENT, "Telemetry data sent");
+            continue;
+        } else {
+            protocol_build_response(&parsed_cmd, client_socket, client_mgr, fleet,
+                                    logger, response, sizeof(response));
+        }
+        
+        if (protocol_append_response(output, protocol, parsed_cmd.type, response) != 0) return -1;
+        logger_log(logger, LOG_RESPONSE, "", 0, response);
+        
+        // Anything pipelined after DISCONNECT is ignored
+        if (parsed_cmd.type == CMD_DISCONNECT) return 1;
+    }
+    
+    return 0;
+}
+
+void protocol_send_response(int socket, const char* response, logger_t* logger) {
+    if (socket < 0 || !response) return;
+    
+    if (socket_send_data(socket, response, strlen(response)) < 0) {
+        perror("Error sending response");
+    }
+    
+    logger_log(logger, LOG_RESPONSE, "", 0, response);
+}
 
-const char* logger_type_to_string(log_type_t type) {
-    switch (type) {
-        case LOG_SERVER_START: return "SERVER_START";
-        case LOG_CONNECT: return "CONNECT";
-        case LOG_DISCONNECT: return "DISCONNECT";
-        case LOG_AUTH_SUCCESS: return "AUTH_SUCCESS";
-        case LOG_AUTH_FAILED: return "AUTH_FAILED";
-        case LOG_COMMAND: return "COMMAND";
-        case LOG_RESPONSE: return "RESPONSE";
-        case LOG_ERROR: return "ERROR";
-        case LOG_DATA_SENT: return "DATA_SENT";
-        case LOG_COMMAND_EXECUTED: return "COMMAND_EXECUTED";
-        case LOG_USERS_LIST: return "USERS_LIST";
-        case LOG_TIMEOUT: return "TIMEOUT";
-        case LOG_CONNECTION_REJECTED: return "CONNECTION_REJECTED";
-        case LOG_UNKNOWN_COMMAND: return "UNKNOWN_COMMAND";
-        case LOG_UNAUTHORIZED: return "UNAUTHORIZED";
-        case LOG_DISCONNECT_REQUEST: return "DISCONNECT_REQUEST";
-        default: return "UNKNOWN";
-    }
-}
-
-const char* protocol_command_type_to_string(command_type_t type) {
-    switch (type) {
-        case CMD_AUTH: return "AUTH";
-        case CMD_GET_DATA: return "GET_DATA";
-        case CMD_SEND_CMD: return "SEND_CMD";
-        case CMD_LIST_USERS: return "LIST_USERS";
-        case CMD_RECHARGE: return "RECHARGE";
-        case CMD_DISCONNECT: return "DISCONNECT";
-        case CMD_UNKNOWN: return "UNKNOWN";
-        default: return "UNKNOWN";
-    }
-}
-
-int protocol_validate_vehicle_command(const char* command) {
-    if (!command) return 0;
-    
-    return (strcmp(command, "SPEED_UP") == 0 ||
-            strcmp(command, "SLOW_DOWN") == 0 ||
-            strcmp(command, "TURN_LEFT") == 0 ||
-            strcmp(command, "TURN_RIGHT") == 0);
+// Sends one tick's record (see telemetry.h) to the rate groups due on it
+void protocol_send_telemetry_to_all(client_manager_t* client_mgr, const char* record, size_t length,
+                                    logger_t* logger) {
+    if (!client_mgr || !record || !logger) return;
+    
+    telemetry_tick_t tick;
+    if (telemetry_tick_read(record, length, &tick) == 0) return;
+    client_manager_send_to_all(client_mgr, &tick);
+    
+    // Subscription ticks are too frequent to log one by one
+    if (tick.groups[SUBSCRIBE_BROADCAST_GROUP]) {
+        logger_log_simple(logger, LOG_DATA_SENT, "Telemetry sent to all clients");
+    }
 }
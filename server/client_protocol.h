@@ -5,110 +5,134 @@
 #include <pthread.h>
 #include <netinet/in.h>
 #include <stdio.h>
+#include <stdint.h>
 #include "socket_manager.h"
-#include "vehicle.h"
+#include "fleet.h"
+#include "logger.h"
+#include "outbound.h"
+#include "stream.h"
+#include "protocol_parser.h"
+#include "wire.h"
+#include "subscription.h"
+#include "telemetry.h"
+#include "slab.h"
+#include "timer_wheel.h"
+#include "token.h"
 
 // Client constants
 #define MAX_USERNAME 50
 #define MAX_PASSWORD 50
-#define CLIENT_TIMEOUT_SECONDS 300
+#ifndef CLIENT_TIMEOUT_SECONDS
+#define CLIENT_TIMEOUT_SECONDS 300      // idle time before a client is disconnected
+#endif
 #define TELEMETRY_INTERVAL 10
 #define BUFFER_SIZE 1024
 #define MAX_CMD_LEN 100
-#define MAX_PARAM_LEN 100
+#define CLIENT_POLL_INTERVAL_MS 100     // thread mode: recheck pending output and shutdown
+#define CLIENT_FD_TABLE_MAX (1 << 20)   // fds past this are refused (RLIMIT_NOFILE caps it lower)
+#define CLIENT_MAX_CAPACITY 100000      // upper bound for --max-clients
+#define CLIENT_SLAB_OBJECTS 64          // clients allocated together as the registry grows
 
-// Log types
-typedef enum {
-    LOG_SERVER_START,
-    LOG_CONNECT,
-    LOG_DISCONNECT,
-    LOG_AUTH_SUCCESS,
-    LOG_AUTH_FAILED,
-    LOG_COMMAND,
-    LOG_RESPONSE,
-    LOG_ERROR,
-    LOG_DATA_SENT,
-    LOG_COMMAND_EXECUTED,
-    LOG_USERS_LIST,
-    LOG_TIMEOUT,
-    LOG_CONNECTION_REJECTED,
-    LOG_UNKNOWN_COMMAND,
-    LOG_UNAUTHORIZED,
-    LOG_DISCONNECT_REQUEST
-} log_type_t;
+// Client flags
+#define CLIENT_AUTHENTICATED 0x1
+#define CLIENT_ADMIN 0x2
 
-// Command types
-typedef enum {
-    CMD_AUTH,
-    CMD_GET_DATA,
-    CMD_SEND_CMD,
-    CMD_LIST_USERS,
-    CMD_RECHARGE,
-    CMD_DISCONNECT,
-    CMD_UNKNOWN
-} command_type_t;
+// Names one connection in one slot: generation << 32 | slot index. A slot's
+// generation is odd while it holds a client and moves on when the client is
+// removed, so a handle kept past that never resolves to the next client.
+typedef uint64_t client_handle_t;
+#define CLIENT_HANDLE_INVALID 0
 
-// Structure to represent a connected client
+// Identity of a connection, read by LIST_USERS and log lines only
 typedef struct {
-    int socket;
     char ip[INET_ADDRSTRLEN];
     int port;
     char username[MAX_USERNAME];
-    int is_admin;
-    int authenticated;
-    time_t last_activity;
-} client_t;
+} client_info_t;
 
-// Structure for parsed command
-typedef struct {
-    command_type_t type;
-    char param1[MAX_PARAM_LEN];
-    char param2[MAX_PARAM_LEN];
-    char param3[MAX_PARAM_LEN];
-} parsed_command_t;
+// Structure to represent a connected client. The fields every command and
+// broadcast reads share the first cache line; the identity lives in a
+// separate slab and the outbound queue starts on a line of its own.
+typedef struct client {
+    int socket;
+    uint32_t generation;        // odd while in use; read without the lock
+    time_t last_activity;       // monotonic seconds; stored without the lock
+    unsigned flags;             // CLIENT_AUTHENTICATED, CLIENT_ADMIN
+    stream_protocol_t protocol; // encoding of the telemetry broadcasts it gets
+    int telemetry_hz;           // rate group of those broadcasts, 0 = periodic only
+    int telemetry_delta;        // changed fields only, after a keyframe
+    int delta_resync;           // next telemetry must be a keyframe
+    client_info_t* info;
+    outbound_queue_t outbound __attribute__((aligned(SLAB_CACHE_LINE))); // responses and broadcasts, in order
+    timer_entry_t idle_timer;   // on the registry's wheel while in use
+    int slot;                   // index this client is bound to
+    struct client* group_prev;  // neighbours in its telemetry_hz group, while in use
+    struct client* group_next;
+} client_t;
 
-// Structure for client manager
-typedef struct {
-    client_t clients[MAX_CLIENTS];
+// Structure for client manager (one per reactor shard in multi-reactor mode).
+// Slots are handed out lowest index first and reuse the most recently freed
+// one; a slot gets its client from the slab the first time it is used and
+// keeps it, so memory follows the peak number of connections rather than the
+// capacity, and a client pointer always belongs to the same slot.
+typedef struct client_manager {
+    client_t** slots;           // capacity entries, NULL until first used
+    int capacity;
+    int high_water;             // slots ever used; every client index is below it
+    int* free_slots;            // stack of slot indices, next one on top
+    int free_count;
     int client_count;
-    pthread_mutex_t mutex;
+    slab_t client_slab;
+    slab_t info_slab;
+    outbound_queue_t** pending; // queues with a frame to flush, telemetry thread only
+    client_t* groups[SUBSCRIBE_GROUP_COUNT]; // clients by telemetry_hz, so a tick visits only its due groups
+    timer_wheel_t idle_wheel;   // idle deadlines, one tick per second
+    pthread_mutex_t mutex;      // serializes writers; lookups never take it
+    uint32_t* slot_by_fd;       // fd -> slot index + 1, 0 if none
+    int fd_capacity;
+    struct client_manager* shard_base; // all shards, for server-wide queries
+    int shard_count;
+    token_table_t* tokens;      // resumable sessions, shared by the shards; NULL = none
 } client_manager_t;
 
-// Logger structure
-typedef struct {
-    FILE* log_file;
-    char* filename;
-} logger_t;
-
 // Combined client, protocol and logging functions
-void client_protocol_init(client_manager_t* manager, logger_t* logger, const char* log_filename);
+int client_protocol_init(client_manager_t* manager, int capacity, logger_t* logger, const char* log_filename);
 void client_protocol_cleanup(client_manager_t* manager, logger_t* logger);
 
 // Client management functions
-int client_manager_add_client(client_manager_t* manager, int socket, const char* ip, int port);
-void client_manager_remove_client(client_manager_t* manager, int client_index);
+int client_manager_init(client_manager_t* manager, int capacity);
+void client_manager_cleanup(client_manager_t* manager);
+void client_manager_link_shards(client_manager_t* shards, int shard_count);
+client_handle_t client_manager_add_client(client_manager_t* manager, int socket, const char* ip, int port);
+const char* client_manager_add_error(client_manager_t* manager, int socket);
+int client_manager_remove_client(client_manager_t* manager, client_handle_t handle);
 int client_manager_find_by_socket(client_manager_t* manager, int socket);
+client_handle_t client_manager_handle(client_manager_t* manager, int client_index);
+client_t* client_manager_resolve(client_manager_t* manager, client_handle_t handle);
 void client_manager_update_activity(client_manager_t* manager, int client_index);
-void client_manager_cleanup_inactive(client_manager_t* manager);
-void client_manager_send_to_all(client_manager_t* manager, const char* data);
+int client_manager_cleanup_inactive(client_manager_t* manager);
+void client_manager_send_to_all(client_manager_t* manager, const telemetry_tick_t* tick);
+int client_send(client_manager_t* manager, client_handle_t handle, const char* data, size_t length);
+int client_send_switch(client_manager_t* manager, client_handle_t handle, const char* data, size_t length,
+                       const stream_input_t* input);
 client_t* client_manager_get_client(client_manager_t* manager, int client_index);
+size_t client_manager_memory_bytes(client_manager_t* manager);
 int client_manager_authenticate_client(client_manager_t* manager, int client_index, const char* username, const char* password);
+int client_manager_resume_client(client_manager_t* manager, int client_index, string_view_t token,
+                                 char* username, size_t username_size);
 
-// Protocol functions
-command_type_t protocol_parse_command(const char* command, parsed_command_t* parsed);
+// Protocol functions (parsing lives in protocol_parser.c)
 void protocol_handle_command(parsed_command_t* cmd, int client_socket, 
-                            client_manager_t* client_mgr, vehicle_state_t* vehicle, 
+                            client_manager_t* client_mgr, fleet_t* fleet, 
                             logger_t* logger);
+void protocol_build_response(parsed_command_t* cmd, int client_socket, 
+                             client_manager_t* client_mgr, fleet_t* fleet, 
+                             logger_t* logger, char* response, size_t response_size);
+int protocol_handle_stream(stream_input_t* input, stream_output_t* output, int client_socket,
+                           const char* ip, int port, client_manager_t* client_mgr,
+                           fleet_t* fleet, logger_t* logger);
 void protocol_send_response(int socket, const char* response, logger_t* logger);
-void protocol_send_telemetry_to_all(client_manager_t* client_mgr, vehicle_state_t* vehicle, logger_t* logger);
-
-// Logging functions
-void logger_log(logger_t* logger, log_type_t type, const char* ip, int port, const char* message);
-void logger_log_simple(logger_t* logger, log_type_t type, const char* message);
-
-// Helper functions
-const char* logger_type_to_string(log_type_t type);
-const char* protocol_command_type_to_string(command_type_t type);
-int protocol_validate_vehicle_command(const char* command);
+void protocol_send_telemetry_to_all(client_manager_t* client_mgr, const char* record, size_t length,
+                                    logger_t* logger);
 
 #endif // CLIENT_PROTOCOL_H
@@ -0,0 +1,389 @@
+#include "fleet.h"
+#include "physics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <errno.h>
+
+// ============================================================================
+// SEQLOCK HELPERS
+// ============================================================================
+
+// Published fields are accessed with relaxed atomics so readers can copy them
+// while a writer is active; the shard's sequence counter decides whether the
+// copy is kept
+#define FLEET_STORE(field, value) __atomic_store_n(&(field), (value), __ATOMIC_RELAXED)
+#define FLEET_LOAD(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
+static fleet_shard_t* fleet_shard_of(fleet_t* fleet, int id) {
+    return &fleet->shards[id >> FLEET_SHARD_SHIFT];
+}
+
+// Caller holds shard->mutex
+static void fleet_publish_begin(fleet_shard_t* shard) {
+    __atomic_store_n(&shard->seq, shard->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void fleet_publish_end(fleet_shard_t* shard) {
+    __atomic_store_n(&shard->seq, shard->seq + 1, __ATOMIC_RELEASE);
+}
+
+static void fleet_write_lock(fleet_shard_t* shard) {
+    pthread_mutex_lock(&shard->mutex);
+    fleet_publish_begin(shard);
+}
+
+static void fleet_write_unlock(fleet_shard_t* shard) {
+    fleet_publish_end(shard);
+    pthread_mutex_unlock(&shard->mutex);
+}
+
+// ============================================================================
+// SIMULATION
+// ============================================================================
+
+// Advances every shard by elapsed_ms, as simulation step number step. Runs of
+// FLEET_ADVANCE_RUN shards are locked together, in ascending order, and
+// advanced in one kernel call; commands lock a single shard, so this cannot
+// deadlock with them. The kernel writes with plain stores, which the shards'
+// seqlocks cover like any other write.
+static void fleet_step(fleet_t* fleet, long elapsed_ms, unsigned long long step) {
+    for (int first = 0; first < fleet->shard_count; first += FLEET_ADVANCE_RUN) {
+        int end = first + FLEET_ADVANCE_RUN < fleet->shard_count ? first + FLEET_ADVANCE_RUN : fleet->shard_count;
+        for (int i = first; i < end; i++) {
+            fleet_write_lock(&fleet->shards[i]);
+        }
+
+        // Arrays cover whole shards, so the padding past fleet->count is advanced too
+        size_t offset = (size_t)first << FLEET_SHARD_SHIFT;
+        physics_advance(fleet->speed + offset, fleet->battery + offset, fleet->temperature + offset,
+                        (end - first) << FLEET_SHARD_SHIFT, elapsed_ms);
+
+        for (int i = first; i < end; i++) {
+            FLEET_STORE(fleet->shards[i].step, step);
+            fleet_write_unlock(&fleet->shards[i]);
+        }
+    }
+}
+
+static long long fleet_elapsed_ms(const struct timespec* from, const struct timespec* to) {
+    return (long long)(to->tv_sec - from->tv_sec) * 1000 + (to->tv_nsec - from->tv_nsec) / 1000000;
+}
+
+// Fixed timestep on the monotonic clock: step n is due step_ms * n after
+// start. If the thread was held up, the missed steps are advanced in one
+// call, so the simulation never drifts from real time.
+static void* fleet_simulation_thread(void* arg) {
+    fleet_t* fleet = (fleet_t*)arg;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned long long done = 0;
+    vehicle_snapshot_t snapshot;
+    if (fleet->history) {
+        history_start(fleet->history);
+        fleet_get_snapshot(fleet, FLEET_STREAM_VEHICLE, &snapshot);
+        history_record(fleet->history, 0, 0, &snapshot);
+    }
+
+    while (__atomic_load_n(&fleet->running, __ATOMIC_ACQUIRE)) {
+        long long next_ms = (long long)(done + 1) * fleet->step_ms;
+        struct timespec deadline = start;
+        deadline.tv_sec += (time_t)(next_ms / 1000);
+        deadline.tv_nsec += (long)(next_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        int result;
+        do {
+            result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+        } while (result == EINTR);
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        unsigned long long due = (unsigned long long)(fleet_elapsed_ms(&start, &now) / fleet->step_ms);
+        if (due <= done) continue;
+
+        fleet_step(fleet, (long)(due - done) * fleet->step_ms, due);
+        if (fleet->history) {
+            fleet_get_snapshot(fleet, FLEET_STREAM_VEHICLE, &snapshot);
+            history_record(fleet->history, done + 1, due, &snapshot);
+        }
+        done = due;
+    }
+    return NULL;
+}
+
+// ============================================================================
+// FLEET LIFECYCLE
+// ============================================================================
+
+// Cache-line aligned and zeroed
+static void* fleet_alloc(size_t size) {
+    void* memory = NULL;
+    if (posix_memalign(&memory, 64, size) != 0) return NULL;
+    memset(memory, 0, size);
+    return memory;
+}
+
+int fleet_init(fleet_t* fleet, int count) {
+    if (!fleet) return -1;
+
+    memset(fleet, 0, sizeof(fleet_t));
+    if (count <= 0 || count > FLEET_MAX_VEHICLES) {
+        fprintf(stderr, "Invalid fleet size: %d\n", count);
+        return -1;
+    }
+
+    // Arrays cover whole shards, so a pass over a shard never needs a tail case
+    fleet->count = count;
+    fleet->shard_count = (count + FLEET_SHARD_SIZE - 1) >> FLEET_SHARD_SHIFT;
+    size_t slots = (size_t)fleet->shard_count << FLEET_SHARD_SHIFT;
+    fleet->speed = fleet_alloc(slots * sizeof(int16_t));
+    fleet->battery = fleet_alloc(slots * sizeof(int32_t));
+    fleet->temperature = fleet_alloc(slots * sizeof(int32_t));
+    fleet->direction = fleet_alloc(slots * sizeof(uint8_t));
+    fleet->shards = fleet_alloc((size_t)fleet->shard_count * sizeof(fleet_shard_t));
+    if (!fleet->speed || !fleet->battery || !fleet->temperature || !fleet->direction || !fleet->shards) {
+        perror("Error allocating fleet");
+        fleet_cleanup(fleet);
+        return -1;
+    }
+
+    for (size_t id = 0; id < slots; id++) {
+        fleet->battery[id] = PHYSICS_BATTERY_MAX;
+        fleet->temperature[id] = PHYSICS_TEMPERATURE_MIN;
+        fleet->direction[id] = DIRECTION_STRAIGHT;
+    }
+
+    for (int i = 0; i < fleet->shard_count; i++) {
+        if (pthread_mutex_init(&fleet->shards[i].mutex, NULL) != 0) {
+            perror("Error initializing fleet mutex");
+            fleet->shard_count = i;
+            fleet_cleanup(fleet);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int fleet_start_simulation(fleet_t* fleet, int step_ms) {
+    if (!fleet || !fleet->shards || fleet->running) return -1;
+    if (step_ms <= 0 || step_ms > FLEET_MAX_STEP_MS) {
+        fprintf(stderr, "Invalid simulation step: %d ms\n", step_ms);
+        return -1;
+    }
+
+    fleet->step_ms = step_ms;
+    fleet->running = 1;
+    if (pthread_create(&fleet->simulation, NULL, fleet_simulation_thread, fleet) != 0) {
+        perror("Error creating simulation thread");
+        fleet->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+void fleet_stop_simulation(fleet_t* fleet) {
+    if (!fleet || !fleet->running) return;
+
+    __atomic_store_n(&fleet->running, 0, __ATOMIC_RELEASE);
+    pthread_join(fleet->simulation, NULL);
+}
+
+void fleet_cleanup(fleet_t* fleet) {
+    if (!fleet) return;
+
+    fleet_stop_simulation(fleet);
+
+    if (fleet->shards) {
+        for (int i = 0; i < fleet->shard_count; i++) {
+            pthread_mutex_destroy(&fleet->shards[i].mutex);
+        }
+    }
+    free(fleet->speed);
+    free(fleet->battery);
+    free(fleet->temperature);
+    free(fleet->direction);
+    free(fleet->shards);
+    memset(fleet, 0, sizeof(fleet_t));
+}
+
+int fleet_contains(const fleet_t* fleet, long id) {
+    return fleet && id >= 0 && id < fleet->count;
+}
+
+size_t fleet_memory_bytes(const fleet_t* fleet) {
+    if (!fleet) return 0;
+
+    size_t slots = (size_t)fleet->shard_count << FLEET_SHARD_SHIFT;
+    return slots * (sizeof(int16_t) + 2 * sizeof(int32_t) + sizeof(uint8_t)) +
+           (size_t)fleet->shard_count * sizeof(fleet_shard_t);
+}
+
+// ============================================================================
+// READERS
+// ============================================================================
+
+// Lock-free read: retry until no writer of the shard overlapped the copy
+void fleet_get_snapshot(fleet_t* fleet, int id, vehicle_snapshot_t* snapshot) {
+    if (!snapshot || !fleet_contains(fleet, id)) return;
+
+    fleet_shard_t* shard = fleet_shard_of(fleet, id);
+    unsigned start;
+    for (;;) {
+        start = __atomic_load_n(&shard->seq, __ATOMIC_ACQUIRE);
+        if (start & 1) {
+            sched_yield(); // writer mid-update
+            continue;
+        }
+
+        snapshot->speed = FLEET_LOAD(fleet->speed[id]);
+        // Battery rounds up: 0% only once it is empty, 100% until it drains a unit
+        snapshot->battery = (FLEET_LOAD(fleet->battery[id]) + PHYSICS_BATTERY_UNIT - 1) / PHYSICS_BATTERY_UNIT;
+        snapshot->temperature = FLEET_LOAD(fleet->temperature[id]) / PHYSICS_TEMPERATURE_UNIT;
+        snapshot->direction = (vehicle_direction_t)FLEET_LOAD(fleet->direction[id]);
+        snapshot->step = FLEET_LOAD(shard->step);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shard->seq, __ATOMIC_RELAXED) == start) break;
+    }
+    snapshot->id = id;
+}
+
+// The state to report with its timestamp, shared by every telemetry
+// encoding. A pure read: the simulation thread keeps the fleet current.
+time_t fleet_sample_telemetry(fleet_t* fleet, int id, vehicle_snapshot_t* snapshot) {
+    if (!snapshot || !fleet_contains(fleet, id)) return 0;
+
+    fleet_get_snapshot(fleet, id, snapshot);
+    return time(NULL);
+}
+
+void fleet_format_telemetry(fleet_t* fleet, int id, char* buffer, size_t buffer_size) {
+    if (!buffer || buffer_size == 0 || !fleet_contains(fleet, id)) return;
+
+    vehicle_snapshot_t snapshot;
+    time_t now = fleet_sample_telemetry(fleet, id, &snapshot);
+    vehicle_format_snapshot(&snapshot, now, buffer, buffer_size);
+}
+
+// A whole shard as of one instant, copied under its seqlock like a single
+// vehicle; shards are independent, so a fleet copied shard by shard is
+// consistent vehicle by vehicle
+void fleet_export_shard(fleet_t* fleet, int shard, fleet_shard_image_t* image) {
+    if (!fleet || !image || shard < 0 || shard >= fleet->shard_count) return;
+
+    fleet_shard_t* lock = &fleet->shards[shard];
+    size_t first = (size_t)shard << FLEET_SHARD_SHIFT;
+    for (;;) {
+        unsigned start = __atomic_load_n(&lock->seq, __ATOMIC_ACQUIRE);
+        if (start & 1) {
+            sched_yield();
+            continue;
+        }
+
+        for (int i = 0; i < FLEET_SHARD_SIZE; i++) {
+            image->speed[i] = FLEET_LOAD(fleet->speed[first + i]);
+            image->battery[i] = FLEET_LOAD(fleet->battery[first + i]);
+            image->temperature[i] = FLEET_LOAD(fleet->temperature[first + i]);
+            image->direction[i] = FLEET_LOAD(fleet->direction[first + i]);
+        }
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&lock->seq, __ATOMIC_RELAXED) == start) break;
+    }
+}
+
+// ============================================================================
+// WRITERS
+// ============================================================================
+
+void fleet_set_speed(fleet_t* fleet, int id, int speed) {
+    if (!fleet_contains(fleet, id)) return;
+
+    if (speed >= 0 && speed <= 100) {
+        fleet_shard_t* shard = fleet_shard_of(fleet, id);
+        fleet_write_lock(shard);
+        FLEET_STORE(fleet->speed[id], (int16_t)speed);
+        fleet_write_unlock(shard);
+    }
+}
+
+void fleet_set_direction(fleet_t* fleet, int id, vehicle_direction_t direction) {
+    if (!fleet_contains(fleet, id)) return;
+
+    fleet_shard_t* shard = fleet_shard_of(fleet, id);
+    fleet_write_lock(shard);
+    FLEET_STORE(fleet->direction[id], (uint8_t)direction);
+    fleet_write_unlock(shard);
+}
+
+int fleet_speed_up(fleet_t* fleet, int id) {
+    if (!fleet_contains(fleet, id)) return -1;
+
+    int new_speed = -1; // Maximum speed reached
+    fleet_shard_t* shard = fleet_shard_of(fleet, id);
+    fleet_write_lock(shard);
+
+    if (fleet->speed[id] < 100) {
+        new_speed = fleet->speed[id] + 10;
+        if (new_speed > 100) new_speed = 100;
+        FLEET_STORE(fleet->speed[id], (int16_t)new_speed);
+    }
+
+    fleet_write_unlock(shard);
+    return new_speed;
+}
+
+int fleet_slow_down(fleet_t* fleet, int id) {
+    if (!fleet_contains(fleet, id)) return -1;
+
+    int new_speed = -1; // Minimum speed reached
+    fleet_shard_t* shard = fleet_shard_of(fleet, id);
+    fleet_write_lock(shard);
+
+    if (fleet->speed[id] > 0) {
+        new_speed = fleet->speed[id] - 10;
+        if (new_speed < 0) new_speed = 0;
+        FLEET_STORE(fleet->speed[id], (int16_t)new_speed);
+    }
+
+    fleet_write_unlock(shard);
+    return new_speed;
+}
+
+void fleet_recharge_battery(fleet_t* fleet, int id) {
+    if (!fleet_contains(fleet, id)) return;
+
+    fleet_shard_t* shard = fleet_shard_of(fleet, id);
+    fleet_write_lock(shard);
+    FLEET_STORE(fleet->battery[id], (int32_t)PHYSICS_BATTERY_MAX);
+    fleet_write_unlock(shard);
+}
+
+// Restores the first vehicles of a shard from an image, clamped to the
+// ranges the simulation keeps
+void fleet_import_shard(fleet_t* fleet, int shard, const fleet_shard_image_t* image, int vehicles) {
+    if (!fleet || !image || shard < 0 || shard >= fleet->shard_count) return;
+    if (vehicles > FLEET_SHARD_SIZE) vehicles = FLEET_SHARD_SIZE;
+
+    fleet_shard_t* lock = &fleet->shards[shard];
+    size_t first = (size_t)shard << FLEET_SHARD_SHIFT;
+    fleet_write_lock(lock);
+    for (int i = 0; i < vehicles; i++) {
+        int speed = image->speed[i] < 0 ? 0 : image->speed[i] > 100 ? 100 : image->speed[i];
+        int32_t battery = image->battery[i] < 0 ? 0 : image->battery[i] > PHYSICS_BATTERY_MAX
+                                                  ? PHYSICS_BATTERY_MAX : image->battery[i];
+        int32_t temperature = image->temperature[i] < PHYSICS_TEMPERATURE_MIN ? PHYSICS_TEMPERATURE_MIN
+                            : image->temperature[i] > PHYSICS_TEMPERATURE_MAX ? PHYSICS_TEMPERATURE_MAX
+                            : image->temperature[i];
+        FLEET_STORE(fleet->speed[first + i], (int16_t)speed);
+        FLEET_STORE(fleet->battery[first + i], battery);
+        FLEET_STORE(fleet->temperature[first + i], temperature);
+        if (image->direction[i] <= DIRECTION_RIGHT) FLEET_STORE(fleet->direction[first + i], image->direction[i]);
+    }
+    fleet_write_unlock(lock);
+}
@@ -0,0 +1,82 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include "vehicle.h"
+#include "history.h"
+
+// Fleet constants
+#define FLEET_DEFAULT_VEHICLES 1
+#define FLEET_MAX_VEHICLES (1 << 24)            // ids fit the 24 bits of a binary frame
+#define FLEET_SHARD_SHIFT 8
+#define FLEET_SHARD_SIZE (1 << FLEET_SHARD_SHIFT) // consecutive vehicles per shard
+#define FLEET_STREAM_VEHICLE 0                  // vehicle of the broadcast and subscriptions
+#define FLEET_ADVANCE_RUN 16                    // shards per physics kernel call
+#define FLEET_DEFAULT_STEP_MS 10                // simulation timestep
+#define FLEET_MAX_STEP_MS 1000
+
+// Lock and version of FLEET_SHARD_SIZE consecutive vehicles. Writers
+// serialize on mutex and publish through the seqlock counter; readers never
+// take the mutex. Shards start on their own cache line so they do not
+// false-share.
+typedef struct {
+    pthread_mutex_t mutex;
+    unsigned seq;           // odd while a writer is publishing
+    unsigned long long step;    // simulation steps battery and temperature are current to
+} __attribute__((aligned(64))) fleet_shard_t;
+
+// One shard's vehicles in the fleet's own units, as saved by snapshot.c
+typedef struct {
+    int16_t speed[FLEET_SHARD_SIZE];
+    int32_t battery[FLEET_SHARD_SIZE];
+    int32_t temperature[FLEET_SHARD_SIZE];
+    uint8_t direction[FLEET_SHARD_SIZE];
+} fleet_shard_image_t;
+
+// Vehicle state as one array per field (structure of arrays), indexed by
+// vehicle id. A pass over one field touches only that field's cache lines,
+// and a shard's vehicles are contiguous in every array. Only the simulation
+// thread advances battery and temperature, once per fixed timestep; readers
+// copy what it last published.
+typedef struct {
+    int count;
+    int shard_count;
+    int16_t* speed;         // km/h (0-100)
+    int32_t* battery;       // PHYSICS_BATTERY_UNIT per percent (0-100)
+    int32_t* temperature;   // PHYSICS_TEMPERATURE_UNIT per celsius degree
+    uint8_t* direction;     // vehicle_direction_t
+    fleet_shard_t* shards;
+
+    // Simulation thread
+    int step_ms;
+    volatile int running;
+    pthread_t simulation;
+    history_t* history;     // FLEET_STREAM_VEHICLE at every step, if set before starting
+} fleet_t;
+
+// Fleet lifecycle
+int fleet_init(fleet_t* fleet, int count);
+int fleet_start_simulation(fleet_t* fleet, int step_ms);
+void fleet_stop_simulation(fleet_t* fleet);
+void fleet_cleanup(fleet_t* fleet);
+int fleet_contains(const fleet_t* fleet, long id);
+size_t fleet_memory_bytes(const fleet_t* fleet);
+
+// Readers
+void fleet_get_snapshot(fleet_t* fleet, int id, vehicle_snapshot_t* snapshot);
+time_t fleet_sample_telemetry(fleet_t* fleet, int id, vehicle_snapshot_t* snapshot);
+void fleet_format_telemetry(fleet_t* fleet, int id, char* buffer, size_t buffer_size);
+void fleet_export_shard(fleet_t* fleet, int shard, fleet_shard_image_t* image);
+
+// Writers
+void fleet_set_speed(fleet_t* fleet, int id, int speed);
+void fleet_set_direction(fleet_t* fleet, int id, vehicle_direction_t direction);
+int fleet_speed_up(fleet_t* fleet, int id);
+int fleet_slow_down(fleet_t* fleet, int id);
+void fleet_recharge_battery(fleet_t* fleet, int id);
+void fleet_import_shard(fleet_t* fleet, int shard, const fleet_shard_image_t* image, int vehicles);
+
+#endif // FLEET_H
@@ -0,0 +1,229 @@
+#include "history.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Rows are written with relaxed atomics while readers may be copying them;
+// pending and head decide which copies are kept
+#define HISTORY_STORE(field, value) __atomic_store_n(&(field), (value), __ATOMIC_RELAXED)
+#define HISTORY_LOAD(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+
+// ============================================================================
+// HISTORY LIFECYCLE
+// ============================================================================
+
+int history_init(history_t* history, int seconds, int step_ms) {
+    if (!history) return -1;
+
+    memset(history, 0, sizeof(history_t));
+    if (seconds <= 0 || seconds > HISTORY_MAX_SECONDS || step_ms <= 0) {
+        fprintf(stderr, "Invalid history length: %d s\n", seconds);
+        return -1;
+    }
+
+    long long rows = (long long)seconds * 1000 / step_ms;
+    if (rows < 1) rows = 1;
+    if (rows > HISTORY_MAX_ROWS) {
+        fprintf(stderr, "History of %d s at %d ms steps needs %lld rows, more than %d\n",
+                seconds, step_ms, rows, HISTORY_MAX_ROWS);
+        return -1;
+    }
+
+    history->capacity = (uint32_t)rows;
+    history->step_ms = step_ms;
+    history->speed = calloc(rows, sizeof(int16_t));
+    history->battery = calloc(rows, sizeof(uint8_t));
+    history->temperature = calloc(rows, sizeof(int8_t));
+    history->direction = calloc(rows, sizeof(uint8_t));
+    if (!history->speed || !history->battery || !history->temperature || !history->direction) {
+        perror("Error allocating history");
+        history_cleanup(history);
+        return -1;
+    }
+    return 0;
+}
+
+void history_cleanup(history_t* history) {
+    if (!history) return;
+
+    free(history->speed);
+    free(history->battery);
+    free(history->temperature);
+    free(history->direction);
+    memset(history, 0, sizeof(history_t));
+}
+
+size_t history_memory_bytes(const history_t* history) {
+    if (!history) return 0;
+
+    return (size_t)history->capacity * (sizeof(int16_t) + 3 * sizeof(uint8_t));
+}
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+// Step 0 is now; called by the simulation thread before its first step
+void history_start(history_t* history) {
+    if (!history || !history->capacity) return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    __atomic_store_n(&history->epoch_ms, (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000,
+                     __ATOMIC_RELAXED);
+    __atomic_store_n(&history->pending, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&history->head, 0, __ATOMIC_RELEASE);
+}
+
+// Steps first_step..last_step all get snapshot: steps the simulation
+// advanced in one call have no state of their own
+void history_record(history_t* history, uint64_t first_step, uint64_t last_step,
+                    const vehicle_snapshot_t* snapshot) {
+    if (!history || !history->capacity || !snapshot || last_step < first_step) return;
+
+    if (last_step - first_step >= history->capacity) {
+        first_step = last_step - history->capacity + 1;
+    }
+
+    // Announce the rows about to be overwritten before touching them
+    __atomic_store_n(&history->pending, last_step + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (uint64_t step = first_step; step <= last_step; step++) {
+        uint32_t row = (uint32_t)(step % history->capacity);
+        HISTORY_STORE(history->speed[row], (int16_t)snapshot->speed);
+        HISTORY_STORE(history->battery[row], (uint8_t)snapshot->battery);
+        HISTORY_STORE(history->temperature[row], (int8_t)snapshot->temperature);
+        HISTORY_STORE(history->direction[row], (uint8_t)snapshot->direction);
+    }
+    __atomic_store_n(&history->head, last_step + 1, __ATOMIC_RELEASE);
+}
+
+// ============================================================================
+// READERS
+// ============================================================================
+
+// Averages steps first..last into points of stride steps each. A point
+// over more than HISTORY_POINT_ROWS steps samples that many evenly spaced
+// ones, so a day-long ring costs a query no more than a short one.
+static void history_aggregate(const history_t* history, uint64_t first, uint64_t last, uint64_t stride,
+                              history_point_t* points) {
+    uint64_t skip = (stride + HISTORY_POINT_ROWS - 1) / HISTORY_POINT_ROWS;
+    int index = 0;
+    for (uint64_t start = first; start <= last; start += stride, index++) {
+        uint64_t end = start + stride - 1 < last ? start + stride - 1 : last;
+        long speed = 0, battery = 0, temperature = 0, steps = 0;
+        for (uint64_t step = start; step <= end; step += skip, steps++) {
+            uint32_t row = (uint32_t)(step % history->capacity);
+            speed += HISTORY_LOAD(history->speed[row]);
+            battery += HISTORY_LOAD(history->battery[row]);
+            temperature += HISTORY_LOAD(history->temperature[row]);
+        }
+        points[index].speed = (int)((speed + steps / 2) / steps);
+        points[index].battery = (int)((battery + steps / 2) / steps);
+        points[index].temperature = (int)(temperature >= 0 ? (temperature + steps / 2) / steps
+                                                             : (temperature - steps / 2) / steps);
+        points[index].direction =
+            (vehicle_direction_t)HISTORY_LOAD(history->direction[(uint32_t)(end % history->capacity)]);
+    }
+}
+
+// Oldest step the writer has not started to overwrite once the rows copied
+// so far were read
+static uint64_t history_intact_from(const history_t* history) {
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t pending = __atomic_load_n(&history->pending, __ATOMIC_RELAXED);
+    return pending > history->capacity ? pending - history->capacity : 0;
+}
+
+// Unix time of a step, in milliseconds
+long long history_step_time(const history_t* history, uint64_t step) {
+    return __atomic_load_n(&history->epoch_ms, __ATOMIC_RELAXED) + (long long)step * history->step_ms;
+}
+
+// Steps from *step on, one point each, at most max_points. Steps already
+// overwritten are skipped: *step moves to the first one copied. Returns the
+// number copied, 0 when there is nothing new.
+int history_read(const history_t* history, uint64_t* step, history_point_t* points, int max_points) {
+    if (!history || !history->capacity || !step || !points || max_points <= 0) return 0;
+
+    for (;;) {
+        uint64_t head = __atomic_load_n(&history->head, __ATOMIC_ACQUIRE);
+        uint64_t oldest = head > history->capacity ? head - history->capacity : 0;
+        uint64_t first = *step < oldest ? oldest : *step;
+        if (first >= head) return 0;
+
+        uint64_t count = head - first < (uint64_t)max_points ? head - first : (uint64_t)max_points;
+        history_aggregate(history, first, first + count - 1, 1, points);
+
+        // Drop the rows the writer reached meanwhile rather than copy them all again
+        uint64_t intact = history_intact_from(history);
+        if (intact >= first + count) continue;
+        if (intact > first) {
+            memmove(points, points + (intact - first), (size_t)(first + count - intact) * sizeof(history_point_t));
+            count -= intact - first;
+            first = intact;
+        }
+
+        *step = first;
+        return (int)count;
+    }
+}
+
+// Points for Unix times from_ms..to_ms, at most max_points, one per step_ms
+// (rounded up to whole simulation steps). step_ms 0, or a step that would
+// need more points, gets the smallest step that fits. Returns -1 if the
+// history is disabled; an empty range is count 0.
+int history_query(const history_t* history, long long from_ms, long long to_ms, int step_ms,
+                  history_point_t* points, int max_points, history_range_t* range) {
+    if (!history || !history->capacity || !points || max_points <= 0 || !range) return -1;
+
+    for (;;) {
+        uint64_t head = __atomic_load_n(&history->head, __ATOMIC_ACQUIRE);
+        long long epoch = __atomic_load_n(&history->epoch_ms, __ATOMIC_RELAXED);
+        int sim_ms = history->step_ms;
+
+        range->from_ms = from_ms;
+        range->step_ms = step_ms > 0 ? step_ms : sim_ms;
+        range->count = 0;
+        if (head == 0 || to_ms < from_ms || to_ms < epoch) return 0;
+
+        // Steps in the range that are still in the ring
+        uint64_t oldest = head > history->capacity ? head - history->capacity : 0;
+        uint64_t first = from_ms <= epoch ? 0 : (uint64_t)((from_ms - epoch + sim_ms - 1) / sim_ms);
+        uint64_t last = (uint64_t)((to_ms - epoch) / sim_ms);
+        if (first < oldest) {
+            // Stay clear of the rows the writer overwrites next while this copies
+            uint64_t slack = (uint64_t)(HISTORY_SLACK_MS / sim_ms);
+            if (slack > history->capacity / 4) slack = history->capacity / 4;
+            first = oldest + slack;
+        }
+        if (last > head - 1) last = head - 1;
+        if (first > last) return 0;
+
+        uint64_t rows = last - first + 1;
+        uint64_t stride = step_ms > 0 ? (uint64_t)((step_ms + sim_ms - 1) / sim_ms) : 1;
+        if ((rows + stride - 1) / stride > (uint64_t)max_points) {
+            stride = (rows + (uint64_t)max_points - 1) / (uint64_t)max_points;
+        }
+        history_aggregate(history, first, last, stride, points);
+
+        // Drop the leading points whose rows the writer reached meanwhile; the
+        // rest keep their place on the step grid
+        uint64_t count = (rows + stride - 1) / stride;
+        uint64_t intact = history_intact_from(history);
+        if (intact > first) {
+            uint64_t lost = (intact - first + stride - 1) / stride;
+            if (lost >= count) continue;
+            memmove(points, points + lost, (size_t)(count - lost) * sizeof(history_point_t));
+            count -= lost;
+            first += lost * stride;
+        }
+
+        range->from_ms = epoch + (long long)first * sim_ms;
+        range->step_ms = (int)stride * sim_ms;
+        range->count = (int)count;
+        return 0;
+    }
+}
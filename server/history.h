@@ -0,0 +1,66 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vehicle.h"
+
+// History constants
+#define HISTORY_DEFAULT_SECONDS 600     // kept for GET_HISTORY; 0 disables it
+#define HISTORY_MAX_SECONDS 86400
+#define HISTORY_MAX_ROWS (1 << 26)      // 320 MB of columns
+#define HISTORY_MAX_POINTS 1000         // per response; longer ranges are downsampled
+#define HISTORY_POINT_ROWS 64           // rows sampled per point at most, so a query costs 64K rows
+#define HISTORY_SLACK_MS 1000           // a range from the oldest step starts this far in
+
+// State of one vehicle at every simulation step, for the last capacity
+// steps. One array per field (5 bytes a step); step s lives in row
+// s % capacity, so a time range maps to rows with arithmetic alone. The
+// simulation thread is the only writer: it raises pending, writes the rows
+// and then publishes head. Readers copy without locking and drop the copied
+// rows that pending shows the writer reached meanwhile.
+typedef struct {
+    int16_t* speed;
+    uint8_t* battery;
+    int8_t* temperature;
+    uint8_t* direction;
+    uint32_t capacity;          // rows
+    int step_ms;
+    long long epoch_ms;         // Unix time of step 0
+    uint64_t pending;           // head once the rows being written are done
+    uint64_t head;              // steps recorded; the next one is step head
+} history_t;
+
+// One point of a range: the mean of the steps it covers (of HISTORY_POINT_ROWS
+// evenly spaced ones when it covers more), direction of the last
+typedef struct {
+    int speed;
+    int battery;
+    int temperature;
+    vehicle_direction_t direction;
+} history_point_t;
+
+// Where a query's points fall in time
+typedef struct {
+    long long from_ms;          // Unix time of the first point
+    int step_ms;                // between points
+    int count;
+} history_range_t;
+
+// History lifecycle
+int history_init(history_t* history, int seconds, int step_ms);
+void history_cleanup(history_t* history);
+size_t history_memory_bytes(const history_t* history);
+
+// Writer (simulation thread)
+void history_start(history_t* history);
+void history_record(history_t* history, uint64_t first_step, uint64_t last_step,
+                    const vehicle_snapshot_t* snapshot);
+
+// Readers
+long long history_step_time(const history_t* history, uint64_t step);
+int history_read(const history_t* history, uint64_t* step, history_point_t* points, int max_points);
+int history_query(const history_t* history, long long from_ms, long long to_ms, int step_ms,
+                  history_point_t* points, int max_points, history_range_t* range);
+
+#endif // HISTORY_H
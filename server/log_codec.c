@@ -0,0 +1,275 @@
+#include "log_codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// VARINT HELPERS
+// ============================================================================
+
+static size_t varint_encode(unsigned long long value, unsigned char* out) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (unsigned char)value;
+    return length;
+}
+
+// Returns bytes consumed, 0 if truncated, -1 if malformed
+static int varint_decode(const unsigned char* data, size_t length, unsigned long long* value) {
+    unsigned long long result = 0;
+    for (size_t i = 0; i < length && i < 10; i++) {
+        result |= (unsigned long long)(data[i] & 0x7F) << (7 * i);
+        if (!(data[i] & 0x80)) {
+            *value = result;
+            return (int)i + 1;
+        }
+    }
+    return length >= 10 ? -1 : 0;
+}
+
+static unsigned long long zigzag_encode(long long value) {
+    return ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+}
+
+static long long zigzag_decode(unsigned long long value) {
+    return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+// ============================================================================
+// DICTIONARY FUNCTIONS
+// ============================================================================
+
+int log_dictionary_init(log_dictionary_t* dict) {
+    if (!dict) return -1;
+
+    dict->arena = malloc((size_t)LOG_INTERN_MAX_ENTRIES * (LOG_INTERN_MAX_LEN + 1));
+    dict->lengths = calloc(LOG_INTERN_MAX_ENTRIES, sizeof(unsigned short));
+    dict->slots = calloc(LOG_INTERN_SLOTS, sizeof(int));
+    if (!dict->arena || !dict->lengths || !dict->slots) {
+        log_dictionary_cleanup(dict);
+        return -1;
+    }
+
+    dict->count = 0;
+    dict->last_timestamp = 0;
+    return 0;
+}
+
+void log_dictionary_reset(log_dictionary_t* dict, time_t start) {
+    if (!dict) return;
+
+    memset(dict->slots, 0, LOG_INTERN_SLOTS * sizeof(int));
+    dict->count = 0;
+    dict->last_timestamp = start;
+}
+
+void log_dictionary_cleanup(log_dictionary_t* dict) {
+    if (!dict) return;
+
+    free(dict->arena);
+    free(dict->lengths);
+    free(dict->slots);
+    dict->arena = NULL;
+    dict->lengths = NULL;
+    dict->slots = NULL;
+}
+
+static char* log_dictionary_entry(log_dictionary_t* dict, int id) {
+    return dict->arena + (size_t)id * (LOG_INTERN_MAX_LEN + 1);
+}
+
+static int log_dictionary_add(log_dictionary_t* dict, const char* text, size_t length) {
+    int id = dict->count++;
+    memcpy(log_dictionary_entry(dict, id), text, length);
+    log_dictionary_entry(dict, id)[length] = '\0';
+    dict->lengths[id] = (unsigned short)length;
+    return id;
+}
+
+// ============================================================================
+// ENCODING FUNCTIONS
+// ============================================================================
+
+static unsigned int log_hash(const char* text, size_t length) {
+    unsigned int hash = 2166136261u; // FNV-1a
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static size_t log_encode_string(log_dictionary_t* dict, const char* text, unsigned char* out) {
+    size_t length = strlen(text);
+    size_t written = 0;
+
+    if (length <= LOG_INTERN_MAX_LEN) {
+        unsigned int slot = log_hash(text, length) & (LOG_INTERN_SLOTS - 1);
+        while (dict->slots[slot] != 0) {
+            int id = dict->slots[slot] - 1;
+            if (dict->lengths[id] == length && memcmp(log_dictionary_entry(dict, id), text, length) == 0) {
+                return varint_encode((unsigned long long)id + 2, out);
+            }
+            slot = (slot + 1) & (LOG_INTERN_SLOTS - 1);
+        }
+
+        if (dict->count < LOG_INTERN_MAX_ENTRIES) {
+            dict->slots[slot] = log_dictionary_add(dict, text, length) + 1;
+            written = varint_encode(1, out);
+        }
+    }
+
+    if (written == 0) {
+        written = varint_encode(0, out); // table full or string too long
+    }
+    written += varint_encode(length, out + written);
+    memcpy(out + written, text, length);
+    return written + length;
+}
+
+size_t log_binary_encode_header(unsigned char* out) {
+    memset(out, 0, LOG_BINARY_HEADER_SIZE);
+    memcpy(out, LOG_BINARY_MAGIC, strlen(LOG_BINARY_MAGIC));
+    out[strlen(LOG_BINARY_MAGIC)] = LOG_BINARY_VERSION;
+    return LOG_BINARY_HEADER_SIZE;
+}
+
+size_t log_binary_encode_segment(log_dictionary_t* dict, time_t start, unsigned char* out) {
+    log_dictionary_reset(dict, start);
+    out[0] = LOG_BINARY_SEGMENT;
+    return 1 + varint_encode((unsigned long long)start, out + 1);
+}
+
+size_t log_binary_encode_record(log_dictionary_t* dict, unsigned char* out, time_t timestamp,
+                                log_type_t type, const char* ip, int port, const char* message) {
+    size_t written = 0;
+
+    out[written++] = (unsigned char)type;
+    written += varint_encode(zigzag_encode((long long)(timestamp - dict->last_timestamp)), out + written);
+    dict->last_timestamp = timestamp;
+
+    written += log_encode_string(dict, ip ? ip : "", out + written);
+    written += varint_encode((unsigned long long)(port < 0 ? 0 : port), out + written);
+    written += log_encode_string(dict, message ? message : "", out + written);
+    return written;
+}
+
+// ============================================================================
+// DECODING FUNCTIONS
+// ============================================================================
+
+int log_binary_check_header(const unsigned char* data, size_t length) {
+    if (length < LOG_BINARY_HEADER_SIZE) return -1;
+    if (memcmp(data, LOG_BINARY_MAGIC, strlen(LOG_BINARY_MAGIC)) != 0) return -1;
+    if (data[strlen(LOG_BINARY_MAGIC)] != LOG_BINARY_VERSION) return -1;
+    return 0;
+}
+
+// Decodes one string into out (capacity bytes, NUL terminated)
+static int log_decode_string(log_dictionary_t* dict, const unsigned char* data, size_t length,
+                             size_t* offset, char* out, size_t capacity) {
+    unsigned long long tag, string_length;
+    int used = varint_decode(data + *offset, length - *offset, &tag);
+    if (used <= 0) return used == 0 ? LOG_DECODE_TRUNCATED : LOG_DECODE_CORRUPT;
+    *offset += (size_t)used;
+
+    if (tag >= 2) {
+        if (tag - 2 >= (unsigned long long)dict->count) return LOG_DECODE_CORRUPT;
+        int id = (int)(tag - 2);
+        if (dict->lengths[id] >= capacity) return LOG_DECODE_CORRUPT;
+        memcpy(out, log_dictionary_entry(dict, id), (size_t)dict->lengths[id] + 1);
+        return 0;
+    }
+
+    used = varint_decode(data + *offset, length - *offset, &string_length);
+    if (used <= 0) return used == 0 ? LOG_DECODE_TRUNCATED : LOG_DECODE_CORRUPT;
+    *offset += (size_t)used;
+
+    if (string_length >= capacity) return LOG_DECODE_CORRUPT;
+    if (tag == 1 && (string_length > LOG_INTERN_MAX_LEN || dict->count >= LOG_INTERN_MAX_ENTRIES)) {
+        return LOG_DECODE_CORRUPT;
+    }
+    if (length - *offset < string_length) return LOG_DECODE_TRUNCATED;
+
+    memcpy(out, data + *offset, (size_t)string_length);
+    out[string_length] = '\0';
+    *offset += (size_t)string_length;
+
+    if (tag == 1) {
+        log_dictionary_add(dict, out, (size_t)string_length);
+    }
+    return 0;
+}
+
+// Decodes one segment marker or record. The dictionary is only updated once a
+// complete record is available, so a truncated call can be retried with more data.
+int log_binary_decode(log_dictionary_t* dict, const unsigned char* data, size_t length,
+                      size_t* consumed, log_record_t* record) {
+    if (!dict || !data || !consumed || !record) return LOG_DECODE_CORRUPT;
+    if (length == 0) return LOG_DECODE_TRUNCATED;
+
+    unsigned long long value;
+    size_t offset = 1;
+    int used;
+
+    if (data[0] == LOG_BINARY_SEGMENT) {
+        used = varint_decode(data + offset, length - offset, &value);
+        if (used <= 0) return used == 0 ? LOG_DECODE_TRUNCATED : LOG_DECODE_CORRUPT;
+        log_dictionary_reset(dict, (time_t)value);
+        *consumed = offset + (size_t)used;
+        return LOG_DECODE_SEGMENT;
+    }
+    if (data[0] > LOG_DISCONNECT_REQUEST) return LOG_DECODE_CORRUPT;
+
+    // Remember the table size so a truncated record can be rolled back
+    int saved_count = dict->count;
+
+    used = varint_decode(data + offset, length - offset, &value);
+    if (used <= 0) return used == 0 ? LOG_DECODE_TRUNCATED : LOG_DECODE_CORRUPT;
+    offset += (size_t)used;
+
+    int result = log_decode_string(dict, data, length, &offset, record->ip, sizeof(record->ip));
+    unsigned long long port = 0;
+    if (result == 0) {
+        used = varint_decode(data + offset, length - offset, &port);
+        if (used <= 0) result = used == 0 ? LOG_DECODE_TRUNCATED : LOG_DECODE_CORRUPT;
+        else offset += (size_t)used;
+    }
+    if (result == 0) {
+        result = log_decode_string(dict, data, length, &offset, record->message, sizeof(record->message));
+    }
+    if (result != 0) {
+        dict->count = saved_count;
+        return result;
+    }
+
+    record->type = (log_type_t)data[0];
+    record->timestamp = dict->last_timestamp + (time_t)zigzag_decode(value);
+    record->port = (int)port;
+    dict->last_timestamp = record->timestamp;
+    *consumed = offset;
+    return LOG_DECODE_RECORD;
+}
+
+// ============================================================================
+// TEXT FORMAT
+// ============================================================================
+
+size_t log_text_format(char* out, size_t size, const char* stamp, log_type_t type,
+                       const char* ip, int port, const char* message) {
+    char endpoint[INET_ADDRSTRLEN + 16] = "";
+    if (ip && ip[0] != '\0') {
+        snprintf(endpoint, sizeof(endpoint), "%s:%d - ", ip, port);
+    }
+
+    int length;
+    if (stamp) {
+        length = snprintf(out, size, "[%s] [%s] %s%s\n", stamp, logger_type_to_string(type), endpoint, message);
+    } else {
+        length = snprintf(out, size, "[%s] %s%s\n", logger_type_to_string(type), endpoint, message);
+    }
+    if (length < 0) return 0;
+    return (size_t)length < size ? (size_t)length : size - 1;
+}
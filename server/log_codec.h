@@ -0,0 +1,63 @@
+#ifndef LOG_CODEC_H
+#define LOG_CODEC_H
+
+#include <stddef.h>
+#include <time.h>
+#include "logger.h"
+
+// Binary log layout:
+//   file header   "HWLOG" <version> 0 0                      (once per file)
+//   segment       0xFF <varint start_time>                   (once per server run)
+//   record        <type byte> <zigzag varint time delta> <string ip>
+//                 <varint port> <string message>
+//   string        <varint 0> <varint len> <bytes>            literal
+//                 <varint 1> <varint len> <bytes>            literal, interned as next id
+//                 <varint id + 2>                            previously interned string
+// Interned ids and the time base reset at every segment.
+
+#define LOG_BINARY_MAGIC "HWLOG"
+#define LOG_BINARY_VERSION 1
+#define LOG_BINARY_HEADER_SIZE 8
+#define LOG_BINARY_SEGMENT 0xFF
+#define LOG_BINARY_RECORD_MAX (LOG_MESSAGE_MAX + 64)   // worst-case encoded record
+
+#define LOG_INTERN_SLOTS 4096           // hash slots, power of two
+#define LOG_INTERN_MAX_ENTRIES 2048     // interned strings per segment
+#define LOG_INTERN_MAX_LEN 64           // longer strings are always written literally
+
+// Decode results
+#define LOG_DECODE_RECORD 1
+#define LOG_DECODE_SEGMENT 0
+#define LOG_DECODE_TRUNCATED -1         // need more input
+#define LOG_DECODE_CORRUPT -2
+
+// Interned string table shared by the encoder and the decoder
+typedef struct {
+    char* arena;                // LOG_INTERN_MAX_ENTRIES * (LOG_INTERN_MAX_LEN + 1)
+    unsigned short* lengths;
+    int* slots;                 // encoder only: hash slot -> id + 1
+    int count;
+    time_t last_timestamp;
+} log_dictionary_t;
+
+// Dictionary functions
+int log_dictionary_init(log_dictionary_t* dict);
+void log_dictionary_reset(log_dictionary_t* dict, time_t start);
+void log_dictionary_cleanup(log_dictionary_t* dict);
+
+// Encoding functions (return bytes written to out)
+size_t log_binary_encode_header(unsigned char* out);
+size_t log_binary_encode_segment(log_dictionary_t* dict, time_t start, unsigned char* out);
+size_t log_binary_encode_record(log_dictionary_t* dict, unsigned char* out, time_t timestamp,
+                                log_type_t type, const char* ip, int port, const char* message);
+
+// Decoding functions
+int log_binary_check_header(const unsigned char* data, size_t length);
+int log_binary_decode(log_dictionary_t* dict, const unsigned char* data, size_t length,
+                      size_t* consumed, log_record_t* record);
+
+// Text format, shared with logdump. A NULL stamp gives the console variant.
+size_t log_text_format(char* out, size_t size, const char* stamp, log_type_t type,
+                       const char* ip, int port, const char* message);
+
+#endif // LOG_CODEC_H
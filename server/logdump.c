@@ -0,0 +1,97 @@
+/*
+ * Binary log decoder
+ * Converts a log written with --log-format binary back to the text format
+ * produced by the server, one line per record.
+ *
+ * Compilation: make logdump
+ * Usage: ./logdump <binary_log>   (reads stdin when no file is given)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "logger.h"
+#include "log_codec.h"
+
+#define LOGDUMP_CHUNK (1024 * 1024)
+
+static void print_record(const log_record_t* record) {
+    char stamp[64];
+    char line[LOG_MESSAGE_MAX + 128];
+    struct tm tm_info;
+
+    localtime_r(&record->timestamp, &tm_info);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+    size_t length = log_text_format(line, sizeof(line), stamp, record->type,
+                                    record->ip, record->port, record->message);
+    fwrite(line, 1, length, stdout);
+}
+
+int main(int argc, char* argv[]) {
+    FILE* input = stdin;
+    const char* name = "stdin";
+    if (argc > 1) {
+        name = argv[1];
+        input = fopen(name, "rb");
+        if (!input) {
+            perror("Error opening log file");
+            return 1;
+        }
+    }
+
+    unsigned char* buffer = malloc(LOGDUMP_CHUNK);
+    log_dictionary_t dict;
+    if (!buffer || log_dictionary_init(&dict) != 0) {
+        fprintf(stderr, "Error allocating decoder\n");
+        return 1;
+    }
+
+    size_t length = fread(buffer, 1, LOGDUMP_CHUNK, input);
+    if (log_binary_check_header(buffer, length) != 0) {
+        fprintf(stderr, "%s: not a binary log (version %d expected)\n", name, LOG_BINARY_VERSION);
+        return 1;
+    }
+
+    size_t offset = LOG_BINARY_HEADER_SIZE;
+    unsigned long records = 0;
+    int status = 0;
+    log_record_t record;
+
+    for (;;) {
+        size_t consumed = 0;
+        int result = log_binary_decode(&dict, buffer + offset, length - offset, &consumed, &record);
+
+        if (result == LOG_DECODE_RECORD) {
+            print_record(&record);
+            records++;
+            offset += consumed;
+        } else if (result == LOG_DECODE_SEGMENT) {
+            offset += consumed;
+        } else if (result == LOG_DECODE_TRUNCATED) {
+            // Keep the partial record and read the next chunk behind it
+            memmove(buffer, buffer + offset, length - offset);
+            length -= offset;
+            offset = 0;
+            size_t read_bytes = fread(buffer + length, 1, LOGDUMP_CHUNK - length, input);
+            if (read_bytes == 0) {
+                if (length > 0) {
+                    fprintf(stderr, "%s: truncated record at end of file\n", name);
+                    status = 1;
+                }
+                break;
+            }
+            length += read_bytes;
+        } else {
+            fprintf(stderr, "%s: corrupt record after %lu records\n", name, records);
+            status = 1;
+            break;
+        }
+    }
+
+    log_dictionary_cleanup(&dict);
+    free(buffer);
+    if (input != stdin) fclose(input);
+    return status;
+}
@@ -0,0 +1,434 @@
+#include "logger.h"
+#include "log_codec.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <sched.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Longest formatted line: timestamp, type, endpoint and a full message
+#define LOG_LINE_MAX (LOG_MESSAGE_MAX + 128)
+
+// ============================================================================
+// LOCK-FREE RING (bounded MPSC, per-slot sequence numbers)
+// ============================================================================
+
+// Returns 0 if the record was queued, -1 if the ring is full
+static int logger_try_enqueue(logger_t* logger, time_t timestamp, log_type_t type,
+                              const char* ip, int port, const char* message) {
+    unsigned long pos = __atomic_load_n(&logger->tail, __ATOMIC_RELAXED);
+    log_record_t* slot;
+
+    for (;;) {
+        slot = &logger->ring[pos & (LOG_RING_CAPACITY - 1)];
+        unsigned long seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        long diff = (long)(seq - pos);
+
+        if (diff == 0) {
+            // Slot free for this position: claim it
+            if (__atomic_compare_exchange_n(&logger->tail, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return -1; // writer has not consumed this slot yet
+        } else {
+            pos = __atomic_load_n(&logger->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->timestamp = timestamp;
+    slot->type = type;
+    slot->port = port;
+    strncpy(slot->ip, ip ? ip : "", INET_ADDRSTRLEN - 1);
+    slot->ip[INET_ADDRSTRLEN - 1] = '\0';
+    strncpy(slot->message, message ? message : "", LOG_MESSAGE_MAX - 1);
+    slot->message[LOG_MESSAGE_MAX - 1] = '\0';
+
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Writer thread only; returns NULL when the ring is empty
+static log_record_t* logger_peek(logger_t* logger) {
+    log_record_t* slot = &logger->ring[logger->head & (LOG_RING_CAPACITY - 1)];
+    unsigned long seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    return seq == logger->head + 1 ? slot : NULL;
+}
+
+static void logger_release(logger_t* logger, log_record_t* slot) {
+    __atomic_store_n(&slot->seq, logger->head + LOG_RING_CAPACITY, __ATOMIC_RELEASE);
+    __atomic_store_n(&logger->head, logger->head + 1, __ATOMIC_RELAXED);
+}
+
+// Producers, after queueing a record: wakes the writer only if it sleeps,
+// so a busy logger costs no syscall. The fence pairs with the writer's
+// between raising sleeping and its last look at the ring, so either the
+// writer sees the record or this sees it asleep.
+static void logger_wake(logger_t* logger) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&logger->sleeping, __ATOMIC_RELAXED)) return;
+
+    pthread_mutex_lock(&logger->wake_mutex);
+    pthread_cond_signal(&logger->wake);
+    pthread_mutex_unlock(&logger->wake_mutex);
+}
+
+// Writer, with an empty ring: sleeps until a record arrives, or until the
+// next timed flush is due if output is still buffered
+static void logger_sleep(logger_t* logger, int buffered, const struct timespec* last_flush) {
+    pthread_mutex_lock(&logger->wake_mutex);
+    __atomic_store_n(&logger->sleeping, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (!logger_peek(logger) && __atomic_load_n(&logger->running, __ATOMIC_ACQUIRE)) {
+        if (buffered) {
+            int interval_ms = __atomic_load_n(&logger->flush_interval_ms, __ATOMIC_RELAXED);
+            struct timespec deadline = *last_flush;
+            deadline.tv_sec += interval_ms / 1000;
+            deadline.tv_nsec += (long)(interval_ms % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&logger->wake, &logger->wake_mutex, &deadline);
+        } else {
+            pthread_cond_wait(&logger->wake, &logger->wake_mutex);
+        }
+    }
+
+    __atomic_store_n(&logger->sleeping, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&logger->wake_mutex);
+}
+
+// ============================================================================
+// WRITER THREAD
+// ============================================================================
+
+typedef struct {
+    char* data;
+    size_t length;
+    int fd;
+} log_buffer_t;
+
+static void log_buffer_flush(log_buffer_t* buffer) {
+    size_t written = 0;
+    while (written < buffer->length) {
+        ssize_t result = write(buffer->fd, buffer->data + written, buffer->length - written);
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            break; // nowhere to report a logging failure; drop the batch
+        }
+        written += (size_t)result;
+    }
+    buffer->length = 0;
+}
+
+// Writer thread state
+typedef struct {
+    log_buffer_t file;
+    log_buffer_t console;
+    log_dictionary_t dict;      // interned strings, binary format only
+    int binary;                 // -1 until the first record picks the encoding
+    time_t cached_second;
+    char stamp[64];
+} log_writer_t;
+
+// Writes the file header (new file) or validates it (append) and opens a segment
+static int logger_start_binary(logger_t* logger, log_writer_t* writer, time_t timestamp) {
+    if (__atomic_load_n(&logger->format, __ATOMIC_RELAXED) != LOG_FORMAT_BINARY) return 0;
+
+    struct stat info;
+    unsigned char header[LOG_BINARY_HEADER_SIZE];
+    if (fstat(logger->log_fd, &info) != 0 || log_dictionary_init(&writer->dict) != 0) return 0;
+
+    if (info.st_size == 0) {
+        writer->file.length += log_binary_encode_header((unsigned char*)writer->file.data + writer->file.length);
+    } else if (pread(logger->log_fd, header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+               log_binary_check_header(header, sizeof(header)) != 0) {
+        fprintf(stderr, "Log file %s is not a binary log, writing text\n", logger->filename ? logger->filename : "");
+        log_dictionary_cleanup(&writer->dict);
+        return 0;
+    }
+
+    writer->file.length += log_binary_encode_segment(&writer->dict, timestamp,
+                                                     (unsigned char*)writer->file.data + writer->file.length);
+    return 1;
+}
+
+static void logger_format(logger_t* logger, log_writer_t* writer, time_t timestamp,
+                          log_type_t type, const char* ip, int port, const char* message) {
+    log_buffer_t* file = &writer->file;
+    log_buffer_t* console = &writer->console;
+
+    if (file->length + LOG_LINE_MAX > LOG_WRITE_BUFFER) log_buffer_flush(file);
+    if (console->length + LOG_LINE_MAX > LOG_WRITE_BUFFER) log_buffer_flush(console);
+    if (writer->binary < 0) writer->binary = logger_start_binary(logger, writer, timestamp);
+
+    // localtime_r once per second instead of once per record
+    if (timestamp != writer->cached_second) {
+        struct tm tm_info;
+        writer->cached_second = timestamp;
+        localtime_r(&writer->cached_second, &tm_info);
+        strftime(writer->stamp, sizeof(writer->stamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+    }
+
+    if (writer->binary) {
+        file->length += log_binary_encode_record(&writer->dict, (unsigned char*)file->data + file->length,
+                                                 timestamp, type, ip, port, message);
+    } else {
+        file->length += log_text_format(file->data + file->length, LOG_LINE_MAX,
+                                        writer->stamp, type, ip, port, message);
+    }
+    console->length += log_text_format(console->data + console->length, LOG_LINE_MAX,
+                                       NULL, type, ip, port, message);
+}
+
+static long logger_elapsed_ms(const struct timespec* since) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1000 + (now.tv_nsec - since->tv_nsec) / 1000000;
+}
+
+// Drains the ring, formats records in batches and writes them with large writes
+static void* logger_writer_thread(void* arg) {
+    logger_t* logger = (logger_t*)arg;
+    log_writer_t writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.file.data = malloc(LOG_WRITE_BUFFER);
+    writer.file.fd = logger->log_fd;
+    writer.console.data = malloc(LOG_WRITE_BUFFER);
+    writer.console.fd = STDOUT_FILENO;
+    writer.binary = -1;
+    writer.cached_second = (time_t)-1;
+    if (!writer.file.data || !writer.console.data) {
+        free(writer.file.data);
+        free(writer.console.data);
+        return NULL;
+    }
+
+    struct timespec last_flush;
+    clock_gettime(CLOCK_MONOTONIC, &last_flush);
+    unsigned long reported_drops = 0;
+
+    for (;;) {
+        int stopping = !__atomic_load_n(&logger->running, __ATOMIC_ACQUIRE);
+        int drained = 0;
+
+        log_record_t* record;
+        while ((record = logger_peek(logger)) != NULL) {
+            logger_format(logger, &writer, record->timestamp, record->type, record->ip, record->port, record->message);
+            logger_release(logger, record);
+            drained++;
+        }
+
+        unsigned long dropped = __atomic_load_n(&logger->dropped, __ATOMIC_RELAXED);
+        if (dropped != reported_drops) {
+            char message[128];
+            snprintf(message, sizeof(message), "Logger overflow: %lu records dropped (%lu total)",
+                     dropped - reported_drops, dropped);
+            logger_format(logger, &writer, time(NULL), LOG_ERROR, "", 0, message);
+            reported_drops = dropped;
+        }
+
+        if ((writer.file.length > 0 || writer.console.length > 0) &&
+            (stopping || logger_elapsed_ms(&last_flush) >= logger->flush_interval_ms)) {
+            log_buffer_flush(&writer.file);
+            log_buffer_flush(&writer.console);
+            clock_gettime(CLOCK_MONOTONIC, &last_flush);
+        }
+
+        if (stopping && !logger_peek(logger)) break;
+        if (!drained) {
+            logger_sleep(logger, writer.file.length > 0 || writer.console.length > 0, &last_flush);
+        }
+    }
+
+    if (writer.binary > 0) log_dictionary_cleanup(&writer.dict);
+    free(writer.file.data);
+    free(writer.console.data);
+    return NULL;
+}
+
+// ============================================================================
+// LOGGING FUNCTIONS
+// ============================================================================
+
+int logger_init(logger_t* logger, const char* filename) {
+    if (!logger || !filename) return -1;
+
+    memset(logger, 0, sizeof(logger_t));
+    logger->policy = LOG_OVERFLOW_BLOCK;
+    logger->format = LOG_FORMAT_TEXT;
+    logger->flush_interval_ms = LOG_FLUSH_INTERVAL_MS;
+
+    logger->log_fd = open(filename, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (logger->log_fd < 0) {
+        perror("Error opening log file");
+        return -1;
+    }
+
+    // Duplicate filename
+    logger->filename = malloc(strlen(filename) + 1);
+    if (logger->filename) {
+        strcpy(logger->filename, filename);
+    }
+
+    logger->ring = malloc(LOG_RING_CAPACITY * sizeof(log_record_t));
+    if (!logger->ring) {
+        close(logger->log_fd);
+        logger->log_fd = -1;
+        return -1;
+    }
+    for (unsigned long i = 0; i < LOG_RING_CAPACITY; i++) {
+        logger->ring[i].seq = i;
+    }
+
+    // The writer's timed waits use the same clock as its flush timestamps
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&logger->wake, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&logger->wake_mutex, NULL);
+
+    logger->running = 1;
+    if (pthread_create(&logger->writer, NULL, logger_writer_thread, logger) != 0) {
+        perror("Error creating logger thread");
+        pthread_cond_destroy(&logger->wake);
+        pthread_mutex_destroy(&logger->wake_mutex);
+        free(logger->ring);
+        logger->ring = NULL;
+        close(logger->log_fd);
+        logger->log_fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+void logger_configure(logger_t* logger, log_overflow_policy_t policy, int flush_interval_ms) {
+    if (!logger) return;
+
+    __atomic_store_n(&logger->policy, policy, __ATOMIC_RELAXED);
+    __atomic_store_n(&logger->flush_interval_ms, flush_interval_ms < 0 ? 0 : flush_interval_ms, __ATOMIC_RELAXED);
+}
+
+// Takes effect at the first record written, so call it before logging anything
+void logger_set_format(logger_t* logger, log_format_t format) {
+    if (!logger) return;
+
+    __atomic_store_n(&logger->format, format, __ATOMIC_RELAXED);
+}
+
+// Stops the writer after it drains everything queued so far
+void logger_cleanup(logger_t* logger) {
+    if (!logger) return;
+
+    if (logger->ring) {
+        __atomic_store_n(&logger->running, 0, __ATOMIC_RELEASE);
+        logger_wake(logger);
+        pthread_join(logger->writer, NULL);
+        pthread_cond_destroy(&logger->wake);
+        pthread_mutex_destroy(&logger->wake_mutex);
+        free(logger->ring);
+        logger->ring = NULL;
+    }
+    if (logger->log_fd >= 0) {
+        close(logger->log_fd);
+        logger->log_fd = -1;
+    }
+    if (logger->filename) {
+        free(logger->filename);
+        logger->filename = NULL;
+    }
+}
+
+void logger_log(logger_t* logger, log_type_t type, const char* ip, int port, const char* message) {
+    if (!logger || !logger->ring) return;
+
+    log_overflow_policy_t policy = __atomic_load_n(&logger->policy, __ATOMIC_RELAXED);
+
+    // Sampling kicks in before the ring is completely full
+    if (policy == LOG_OVERFLOW_SAMPLE) {
+        unsigned long used = __atomic_load_n(&logger->tail, __ATOMIC_RELAXED) -
+                             __atomic_load_n(&logger->head, __ATOMIC_RELAXED);
+        if (used >= LOG_RING_CAPACITY - LOG_RING_CAPACITY / LOG_SAMPLE_THRESHOLD &&
+            __atomic_fetch_add(&logger->sample_counter, 1, __ATOMIC_RELAXED) % LOG_SAMPLE_RATE != 0) {
+            __atomic_fetch_add(&logger->sampled, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+
+    time_t now = time(NULL);
+    while (logger_try_enqueue(logger, now, type, ip, port, message) != 0) {
+        if (policy != LOG_OVERFLOW_BLOCK || !__atomic_load_n(&logger->running, __ATOMIC_ACQUIRE)) {
+            __atomic_fetch_add(&logger->dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        logger_wake(logger);
+        sched_yield(); // wait for the writer to free a slot
+    }
+    logger_wake(logger);
+}
+
+void logger_log_simple(logger_t* logger, log_type_t type, const char* message) {
+    logger_log(logger, type, "", 0, message);
+}
+
+void logger_get_stats(logger_t* logger, unsigned long* dropped, unsigned long* sampled) {
+    if (!logger) return;
+
+    if (dropped) *dropped = __atomic_load_n(&logger->dropped, __ATOMIC_RELAXED);
+    if (sampled) *sampled = __atomic_load_n(&logger->sampled, __ATOMIC_RELAXED);
+}
+
+// ============================================================================
+// HELPER FUNCTIONS
+// ============================================================================
+
+const char* logger_type_to_string(log_type_t type) {
+    switch (type) {
+        case LOG_SERVER_START: return "SERVER_START";
+        case LOG_CONNECT: return "CONNECT";
+        case LOG_DISCONNECT: return "DISCONNECT";
+        case LOG_AUTH_SUCCESS: return "AUTH_SUCCESS";
+        case LOG_AUTH_FAILED: return "AUTH_FAILED";
+        case LOG_COMMAND: return "COMMAND";
+        case LOG_RESPONSE: return "RESPONSE";
+        case LOG_ERROR: return "ERROR";
+        case LOG_DATA_SENT: return "DATA_SENT";
+        case LOG_COMMAND_EXECUTED: return "COMMAND_EXECUTED";
+        case LOG_USERS_LIST: return "USERS_LIST";
+        case LOG_TIMEOUT: return "TIMEOUT";
+        case LOG_CONNECTION_REJECTED: return "CONNECTION_REJECTED";
+        case LOG_UNKNOWN_COMMAND: return "UNKNOWN_COMMAND";
+        case LOG_UNAUTHORIZED: return "UNAUTHORIZED";
+        case LOG_DISCONNECT_REQUEST: return "DISCONNECT_REQUEST";
+        default: return "UNKNOWN";
+    }
+}
+
+int logger_parse_policy(const char* name, log_overflow_policy_t* policy) {
+    if (!name || !policy) return -1;
+
+    if (strcmp(name, "block") == 0) *policy = LOG_OVERFLOW_BLOCK;
+    else if (strcmp(name, "drop") == 0) *policy = LOG_OVERFLOW_DROP;
+    else if (strcmp(name, "sample") == 0) *policy = LOG_OVERFLOW_SAMPLE;
+    else return -1;
+
+    return 0;
+}
+
+int logger_parse_format(const char* name, log_format_t* format) {
+    if (!name || !format) return -1;
+
+    if (strcmp(name, "text") == 0) *format = LOG_FORMAT_TEXT;
+    else if (strcmp(name, "binary") == 0) *format = LOG_FORMAT_BINARY;
+    else return -1;
+
+    return 0;
+}
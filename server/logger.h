@@ -0,0 +1,93 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <pthread.h>
+#include <time.h>
+#include <netinet/in.h>
+
+// Logger constants
+#define LOG_RING_CAPACITY 4096          // records, power of two
+#define LOG_MESSAGE_MAX 480             // longer messages are truncated
+#define LOG_WRITE_BUFFER (256 * 1024)   // bytes batched per write(2)
+#define LOG_FLUSH_INTERVAL_MS 100
+#define LOG_SAMPLE_THRESHOLD 4          // sample once the ring is 3/4 full...
+#define LOG_SAMPLE_RATE 8               // ...keeping one record in eight
+
+// Log types
+typedef enum {
+    LOG_SERVER_START,
+    LOG_CONNECT,
+    LOG_DISCONNECT,
+    LOG_AUTH_SUCCESS,
+    LOG_AUTH_FAILED,
+    LOG_COMMAND,
+    LOG_RESPONSE,
+    LOG_ERROR,
+    LOG_DATA_SENT,
+    LOG_COMMAND_EXECUTED,
+    LOG_USERS_LIST,
+    LOG_TIMEOUT,
+    LOG_CONNECTION_REJECTED,
+    LOG_UNKNOWN_COMMAND,
+    LOG_UNAUTHORIZED,
+    LOG_DISCONNECT_REQUEST
+} log_type_t;
+
+// What producers do when the ring is full
+typedef enum {
+    LOG_OVERFLOW_BLOCK,     // wait for the writer to make room
+    LOG_OVERFLOW_DROP,      // discard the record and count it
+    LOG_OVERFLOW_SAMPLE     // under pressure keep 1 in LOG_SAMPLE_RATE, drop when full
+} log_overflow_policy_t;
+
+// On-disk encoding of the log file (the console is always text)
+typedef enum {
+    LOG_FORMAT_TEXT,
+    LOG_FORMAT_BINARY       // compact encoding, decode with logdump
+} log_format_t;
+
+// Fixed-size record pushed by hot-path threads
+typedef struct {
+    unsigned long seq;      // slot sequence for the lock-free ring
+    time_t timestamp;
+    log_type_t type;
+    int port;
+    char ip[INET_ADDRSTRLEN];
+    char message[LOG_MESSAGE_MAX];
+} log_record_t;
+
+// Logger structure
+typedef struct {
+    int log_fd;
+    char* filename;
+    log_record_t* ring;
+    unsigned long head;     // consumer position (writer thread only)
+    unsigned long tail;     // producer position, claimed with CAS
+    log_overflow_policy_t policy;
+    log_format_t format;
+    int flush_interval_ms;
+    unsigned long dropped;  // records discarded because the ring was full
+    unsigned long sampled;  // records skipped by the sampling policy
+    unsigned long sample_counter;
+    volatile int running;
+    pthread_t writer;
+    int sleeping;           // writer waits on wake: producers signal it
+    pthread_mutex_t wake_mutex;
+    pthread_cond_t wake;
+} logger_t;
+
+// Logging functions
+int logger_init(logger_t* logger, const char* filename);
+void logger_configure(logger_t* logger, log_overflow_policy_t policy, int flush_interval_ms);
+void logger_set_format(logger_t* logger, log_format_t format);
+void logger_cleanup(logger_t* logger);
+void logger_log(logger_t* logger, log_type_t type, const char* ip, int port, const char* message);
+void logger_log_simple(logger_t* logger, log_type_t type, const char* message);
+void logger_get_stats(logger_t* logger, unsigned long* dropped, unsigned long* sampled);
+
+// Helper functions
+const char* logger_type_to_string(log_type_t type);
+int logger_parse_policy(const char* name, log_overflow_policy_t* policy);
+int logger_parse_format(const char* name, log_format_t* format);
+
+#endif // LOGGER_H
@@ -0,0 +1,135 @@
+#include "multicast.h"
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// ============================================================================
+// ADDRESSES
+// ============================================================================
+
+// Parses "<ipv4>:<port>" into address. Returns -1 if malformed.
+int multicast_parse_address(const char* text, struct sockaddr_in* address) {
+    if (!text || !address) return -1;
+
+    const char* colon = strrchr(text, ':');
+    if (!colon || colon == text || (size_t)(colon - text) >= INET_ADDRSTRLEN) return -1;
+
+    char host[INET_ADDRSTRLEN];
+    memcpy(host, text, (size_t)(colon - text));
+    host[colon - text] = '\0';
+
+    char* end;
+    long port = strtol(colon + 1, &end, 10);
+    if (*(colon + 1) == '\0' || *end != '\0' || port <= 0 || port > 65535) return -1;
+
+    memset(address, 0, sizeof(*address));
+    address->sin_family = AF_INET;
+    address->sin_port = htons((uint16_t)port);
+    return inet_pton(AF_INET, host, &address->sin_addr) == 1 ? 0 : -1;
+}
+
+static int multicast_is_group(const struct sockaddr_in* address) {
+    return IN_MULTICAST(ntohl(address->sin_addr.s_addr));
+}
+
+// ============================================================================
+// PUBLISHER FUNCTIONS
+// ============================================================================
+
+// interface_ip picks the interface multicast leaves through (NULL for the
+// routing table's choice; "127.0.0.1" keeps it on loopback)
+int multicast_publisher_init(multicast_publisher_t* publisher, const struct sockaddr_in* destination,
+                             const char* interface_ip, int ttl) {
+    if (!publisher || !destination) return -1;
+
+    memset(publisher, 0, sizeof(*publisher));
+    publisher->destination = *destination;
+    publisher->stream_id = (uint32_t)time(NULL) ^ ((uint32_t)getpid() << 16);
+
+    publisher->socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (publisher->socket < 0) {
+        perror("Error creating multicast socket");
+        return -1;
+    }
+
+    if (multicast_is_group(destination)) {
+        unsigned char hops = (unsigned char)(ttl > 0 && ttl < 256 ? ttl : MULTICAST_DEFAULT_TTL);
+        unsigned char loop = 1; // receivers on this host get it too
+        if (setsockopt(publisher->socket, IPPROTO_IP, IP_MULTICAST_TTL, &hops, sizeof(hops)) < 0 ||
+            setsockopt(publisher->socket, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) < 0) {
+            perror("Error configuring multicast socket");
+            multicast_publisher_cleanup(publisher);
+            return -1;
+        }
+
+        if (interface_ip) {
+            struct in_addr interface;
+            if (inet_pton(AF_INET, interface_ip, &interface) != 1 ||
+                setsockopt(publisher->socket, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface)) < 0) {
+                fprintf(stderr, "Error selecting multicast interface %s\n", interface_ip);
+                multicast_publisher_cleanup(publisher);
+                return -1;
+            }
+        }
+    } else {
+        int enable = 1;
+        if (setsockopt(publisher->socket, SOL_SOCKET, SO_BROADCAST, &enable, sizeof(enable)) < 0) {
+            perror("Error enabling broadcast");
+            multicast_publisher_cleanup(publisher);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Sends one frame as the next datagram of the stream. A datagram the kernel
+// refuses still uses up its sequence number, so receivers see the gap.
+int multicast_publish(multicast_publisher_t* publisher, const unsigned char* frame, size_t length) {
+    if (!publisher || publisher->socket < 0 || !frame) return -1;
+
+    unsigned char datagram[MULTICAST_DATAGRAM_MAX];
+    size_t size = multicast_encode_datagram(publisher->stream_id, ++publisher->sequence, frame, length,
+                                            datagram, sizeof(datagram));
+    if (size == 0) return -1;
+
+    if (sendto(publisher->socket, datagram, size, 0, (const struct sockaddr*)&publisher->destination,
+               sizeof(publisher->destination)) < 0) {
+        publisher->errors++;
+        return -1;
+    }
+    return 0;
+}
+
+void multicast_publisher_cleanup(multicast_publisher_t* publisher) {
+    if (!publisher) return;
+
+    if (publisher->socket >= 0) close(publisher->socket);
+    publisher->socket = -1;
+}
+
+// ============================================================================
+// DATAGRAM ENCODING
+// ============================================================================
+
+// Returns the datagram length, 0 if it does not fit size
+size_t multicast_encode_datagram(uint32_t stream_id, uint64_t sequence, const unsigned char* frame,
+                                 size_t length, unsigned char* out, size_t size) {
+    if (!frame || !out || size < MULTICAST_HEADER_SIZE || length > size - MULTICAST_HEADER_SIZE) return 0;
+
+    out[0] = (unsigned char)(MULTICAST_MAGIC & 0xFF);
+    out[1] = (unsigned char)(MULTICAST_MAGIC >> 8);
+    out[2] = MULTICAST_VERSION;
+    out[3] = 0;
+    for (int i = 0; i < 4; i++) {
+        out[4 + i] = (unsigned char)(stream_id >> (8 * i));
+    }
+    for (int i = 0; i < 8; i++) {
+        out[8 + i] = (unsigned char)(sequence >> (8 * i));
+    }
+    memcpy(out + MULTICAST_HEADER_SIZE, frame, length);
+    return MULTICAST_HEADER_SIZE + length;
+}
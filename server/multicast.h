@@ -0,0 +1,45 @@
+#ifndef MULTICAST_H
+#define MULTICAST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+// Telemetry datagrams for observers that never open a TCP connection. One
+// datagram per tick goes to a multicast group (or a broadcast address) and
+// serves every receiver on the segment. All integers little-endian:
+//
+//   <u16 magic "VT"> <u8 version> <u8 flags = 0> <u32 stream id>
+//   <u64 sequence> <wire.h TELEMETRY frame>
+//
+// The stream id is drawn at startup; sequence numbers start at 1 and grow by
+// one per datagram, so a receiver seeing a jump knows how many it missed and
+// a new stream id means the server restarted.
+
+#define MULTICAST_MAGIC 0x5456          // "VT" on the wire
+#define MULTICAST_VERSION 1
+#define MULTICAST_HEADER_SIZE 16
+#define MULTICAST_DATAGRAM_MAX 512
+#define MULTICAST_DEFAULT_TTL 1         // stays on the local segment
+
+// Owned by the telemetry thread
+typedef struct {
+    int socket;
+    struct sockaddr_in destination;
+    uint32_t stream_id;
+    uint64_t sequence;          // of the last datagram sent
+    unsigned long errors;       // datagrams the kernel refused
+} multicast_publisher_t;
+
+// Publisher functions
+int multicast_parse_address(const char* text, struct sockaddr_in* address);
+int multicast_publisher_init(multicast_publisher_t* publisher, const struct sockaddr_in* destination,
+                             const char* interface_ip, int ttl);
+int multicast_publish(multicast_publisher_t* publisher, const unsigned char* frame, size_t length);
+void multicast_publisher_cleanup(multicast_publisher_t* publisher);
+
+// Datagram encoding
+size_t multicast_encode_datagram(uint32_t stream_id, uint64_t sequence, const unsigned char* frame,
+                                 size_t length, unsigned char* out, size_t size);
+
+#endif // MULTICAST_H
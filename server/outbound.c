@@ -0,0 +1,297 @@
+#include "outbound.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+
+// Server-wide slow-consumer policy; set once at startup, read by every thread
+static outbound_limits_t outbound_limits = {
+    OUTBOUND_DEFAULT_MAX_BYTES, OUTBOUND_QUEUE_MAX, 1, OUTBOUND_DEFAULT_EVICT_MS
+};
+static outbound_stats_t outbound_stats;
+
+// ============================================================================
+// POLICY FUNCTIONS
+// ============================================================================
+
+void outbound_configure(const outbound_limits_t* limits) {
+    if (!limits) return;
+    outbound_limits = *limits;
+}
+
+const outbound_limits_t* outbound_get_limits(void) {
+    return &outbound_limits;
+}
+
+void outbound_count(outbound_event_t event) {
+    switch (event) {
+        case OUTBOUND_EVENT_CONFLATED: __atomic_fetch_add(&outbound_stats.conflated, 1, __ATOMIC_RELAXED); break;
+        case OUTBOUND_EVENT_DROPPED: __atomic_fetch_add(&outbound_stats.dropped, 1, __ATOMIC_RELAXED); break;
+        case OUTBOUND_EVENT_EVICTED: __atomic_fetch_add(&outbound_stats.evicted, 1, __ATOMIC_RELAXED); break;
+    }
+}
+
+void outbound_get_stats(outbound_stats_t* stats) {
+    if (!stats) return;
+
+    stats->conflated = __atomic_load_n(&outbound_stats.conflated, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&outbound_stats.dropped, __ATOMIC_RELAXED);
+    stats->evicted = __atomic_load_n(&outbound_stats.evicted, __ATOMIC_RELAXED);
+}
+
+// Would queueing length more bytes push a client past either limit?
+int outbound_over_limit(size_t queued_bytes, int queued_messages, size_t length) {
+    return queued_bytes + length > outbound_limits.max_bytes ||
+           queued_messages + 1 > outbound_limits.max_messages;
+}
+
+int outbound_expired(long long over_limit_since, long long now_ms) {
+    return over_limit_since != 0 && now_ms - over_limit_since >= outbound_limits.evict_after_ms;
+}
+
+long long outbound_now_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// ============================================================================
+// SHARED BUFFER FUNCTIONS
+// ============================================================================
+
+shared_buffer_t* shared_buffer_create(const char* data, size_t length) {
+    shared_buffer_t* buffer = malloc(sizeof(shared_buffer_t) + length);
+    if (!buffer) return NULL;
+
+    buffer->refcount = 1;
+    buffer->length = length;
+    memcpy(buffer->data, data, length);
+    return buffer;
+}
+
+shared_buffer_t* shared_buffer_retain(shared_buffer_t* buffer) {
+    if (buffer) {
+        __atomic_add_fetch(&buffer->refcount, 1, __ATOMIC_RELAXED);
+    }
+    return buffer;
+}
+
+void shared_buffer_release(shared_buffer_t* buffer) {
+    if (buffer && __atomic_sub_fetch(&buffer->refcount, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(buffer);
+    }
+}
+
+// ============================================================================
+// OUTBOUND QUEUE FUNCTIONS
+// ============================================================================
+
+int outbound_queue_init(outbound_queue_t* queue) {
+    if (!queue) return -1;
+
+    memset(queue->entries, 0, sizeof(queue->entries));
+    queue->socket = -1;
+    queue->head = 0;
+    queue->count = 0;
+    queue->offset = 0;
+    queue->queued_bytes = 0;
+    queue->over_limit_since = 0;
+
+    if (pthread_mutex_init(&queue->mutex, NULL) != 0) {
+        perror("Error initializing outbound queue mutex");
+        return -1;
+    }
+    return 0;
+}
+
+// Caller holds queue->mutex
+static void outbound_queue_clear(outbound_queue_t* queue) {
+    while (queue->count > 0) {
+        shared_buffer_release(queue->entries[queue->head]);
+        queue->entries[queue->head] = NULL;
+        queue->head = (queue->head + 1) % OUTBOUND_QUEUE_MAX;
+        queue->count--;
+    }
+    queue->head = 0;
+    queue->offset = 0;
+    queue->queued_bytes = 0;
+    queue->over_limit_since = 0;
+}
+
+void outbound_queue_cleanup(outbound_queue_t* queue) {
+    if (!queue) return;
+
+    pthread_mutex_lock(&queue->mutex);
+    outbound_queue_clear(queue);
+    pthread_mutex_unlock(&queue->mutex);
+    pthread_mutex_destroy(&queue->mutex);
+}
+
+void outbound_queue_attach(outbound_queue_t* queue, int socket) {
+    if (!queue) return;
+
+    pthread_mutex_lock(&queue->mutex);
+    outbound_queue_clear(queue);
+    queue->socket = socket;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+// Drops pending output; after this no flush touches the socket, so it can be closed
+void outbound_queue_detach(outbound_queue_t* queue) {
+    if (!queue) return;
+
+    pthread_mutex_lock(&queue->mutex);
+    outbound_queue_clear(queue);
+    queue->socket = -1;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+// Caller holds queue->mutex. Index of the newest telemetry frame that has not
+// started sending, or -1.
+static int outbound_queue_find_telemetry(outbound_queue_t* queue) {
+    for (int i = queue->count - 1; i >= 0; i--) {
+        if (i == 0 && queue->offset > 0) break;
+        int index = (queue->head + i) % OUTBOUND_QUEUE_MAX;
+        if (queue->kinds[index] == OUTBOUND_TELEMETRY) return index;
+    }
+    return -1;
+}
+
+// Caller holds queue->mutex and has checked the queue is attached
+static int outbound_queue_push_locked(outbound_queue_t* queue, shared_buffer_t* buffer, outbound_kind_t kind) {
+    // Conflation: the newest frame takes the place of a stale one still queued
+    if (kind == OUTBOUND_TELEMETRY && outbound_limits.conflate) {
+        int index = outbound_queue_find_telemetry(queue);
+        if (index >= 0 && !outbound_over_limit(queue->queued_bytes - queue->entries[index]->length,
+                                               queue->count - 1, buffer->length)) {
+            queue->queued_bytes += buffer->length - queue->entries[index]->length;
+            shared_buffer_release(queue->entries[index]);
+            queue->entries[index] = shared_buffer_retain(buffer);
+            outbound_count(OUTBOUND_EVENT_CONFLATED);
+            return 0;
+        }
+    }
+
+    if (queue->count >= OUTBOUND_QUEUE_MAX ||
+        outbound_over_limit(queue->queued_bytes, queue->count, buffer->length)) {
+        if (queue->over_limit_since == 0) queue->over_limit_since = outbound_now_ms();
+        outbound_count(OUTBOUND_EVENT_DROPPED);
+        return 1;
+    }
+
+    int tail = (queue->head + queue->count) % OUTBOUND_QUEUE_MAX;
+    queue->entries[tail] = shared_buffer_retain(buffer);
+    queue->kinds[tail] = kind;
+    queue->count++;
+    queue->queued_bytes += buffer->length;
+    queue->over_limit_since = 0;
+    return 0;
+}
+
+// Takes a new reference to buffer. Returns 0 if queued (or conflated), 1 if
+// refused because the client is over a limit, -1 if detached.
+int outbound_queue_push(outbound_queue_t* queue, shared_buffer_t* buffer, outbound_kind_t kind) {
+    if (!queue || !buffer) return -1;
+    if (buffer->length == 0) return 0;
+
+    pthread_mutex_lock(&queue->mutex);
+    int result = queue->socket < 0 ? -1 : outbound_queue_push_locked(queue, buffer, kind);
+    pthread_mutex_unlock(&queue->mutex);
+    return result;
+}
+
+// Queues a delta frame. A delta cannot replace a stale frame, since the
+// client would miss the changes in it, so when conflation applies the full
+// keyframe of the same tick takes the stale frame's place instead.
+// Same results as outbound_queue_push.
+int outbound_queue_push_delta(outbound_queue_t* queue, shared_buffer_t* delta, shared_buffer_t* keyframe) {
+    if (!queue || !delta || !keyframe) return -1;
+
+    pthread_mutex_lock(&queue->mutex);
+    int result = -1;
+    if (queue->socket >= 0) {
+        int stale = outbound_limits.conflate && outbound_queue_find_telemetry(queue) >= 0;
+        result = outbound_queue_push_locked(queue, stale ? keyframe : delta, OUTBOUND_TELEMETRY);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    return result;
+}
+
+// Writes as much as the socket accepts without blocking.
+// Returns 0 when drained, 1 if output is still pending, -1 on socket error.
+int outbound_queue_flush(outbound_queue_t* queue) {
+    if (!queue) return -1;
+
+    pthread_mutex_lock(&queue->mutex);
+    int result = 0;
+
+    while (queue->count > 0 && queue->socket >= 0) {
+        struct iovec iov[OUTBOUND_QUEUE_MAX];
+        for (int i = 0; i < queue->count; i++) {
+            shared_buffer_t* buffer = queue->entries[(queue->head + i) % OUTBOUND_QUEUE_MAX];
+            size_t skip = i == 0 ? queue->offset : 0;
+            iov[i].iov_base = buffer->data + skip;
+            iov[i].iov_len = buffer->length - skip;
+        }
+
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = iov;
+        message.msg_iovlen = (size_t)queue->count;
+
+        ssize_t sent = sendmsg(queue->socket, &message, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            result = (errno == EAGAIN || errno == EWOULDBLOCK) ? 1 : -1;
+            break;
+        }
+
+        // Retire fully written buffers
+        size_t remaining = (size_t)sent;
+        queue->queued_bytes -= remaining;
+        while (remaining > 0) {
+            shared_buffer_t* buffer = queue->entries[queue->head];
+            size_t left = buffer->length - queue->offset;
+            if (remaining < left) {
+                queue->offset += remaining;
+                break;
+            }
+            remaining -= left;
+            shared_buffer_release(buffer);
+            queue->entries[queue->head] = NULL;
+            queue->head = (queue->head + 1) % OUTBOUND_QUEUE_MAX;
+            queue->count--;
+            queue->offset = 0;
+        }
+    }
+
+    // Draining back under the limits cancels a pending eviction
+    if (queue->over_limit_since != 0 && result >= 0 &&
+        !outbound_over_limit(queue->queued_bytes, queue->count, 0)) {
+        queue->over_limit_since = 0;
+    }
+
+    pthread_mutex_unlock(&queue->mutex);
+    return result;
+}
+
+int outbound_queue_pending(outbound_queue_t* queue) {
+    if (!queue) return 0;
+
+    pthread_mutex_lock(&queue->mutex);
+    int pending = queue->count > 0 && queue->socket >= 0;
+    pthread_mutex_unlock(&queue->mutex);
+    return pending;
+}
+
+int outbound_queue_expired(outbound_queue_t* queue, long long now_ms) {
+    if (!queue) return 0;
+
+    pthread_mutex_lock(&queue->mutex);
+    int expired = queue->socket >= 0 && outbound_expired(queue->over_limit_since, now_ms);
+    pthread_mutex_unlock(&queue->mutex);
+    return expired;
+}
@@ -0,0 +1,85 @@
+#ifndef OUTBOUND_H
+#define OUTBOUND_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+// Outbound constants
+#define OUTBOUND_QUEUE_MAX 64       // buffers queued per client, also the writev batch
+#define OUTBOUND_DEFAULT_MAX_BYTES (256 * 1024)
+#define OUTBOUND_DEFAULT_EVICT_MS 30000
+
+// What a queued message is, for conflation
+typedef enum {
+    OUTBOUND_RESPONSE,
+    OUTBOUND_TELEMETRY          // only the newest unsent frame is worth keeping
+} outbound_kind_t;
+
+// Slow-consumer policy, shared by the per-client queues and the event loop sessions
+typedef struct {
+    size_t max_bytes;           // queued bytes per client
+    int max_messages;           // queued messages per client
+    int conflate;               // replace unsent telemetry with the newest frame
+    int evict_after_ms;         // disconnect clients over a limit for this long
+} outbound_limits_t;
+
+// How often each policy triggered, server-wide
+typedef struct {
+    unsigned long conflated;    // stale telemetry frames replaced
+    unsigned long dropped;      // messages refused because a client was over a limit
+    unsigned long evicted;      // clients disconnected for staying over a limit
+} outbound_stats_t;
+
+typedef enum {
+    OUTBOUND_EVENT_CONFLATED,
+    OUTBOUND_EVENT_DROPPED,
+    OUTBOUND_EVENT_EVICTED
+} outbound_event_t;
+
+// Immutable payload shared by every queue it is pushed to (formatted once)
+typedef struct {
+    int refcount;
+    size_t length;
+    char data[];
+} shared_buffer_t;
+
+// Per-client FIFO of shared buffers, drained with non-blocking writev. The
+// mutex only covers this client, so a slow socket never blocks the registry.
+typedef struct {
+    pthread_mutex_t mutex;
+    int socket;                 // -1 once detached
+    shared_buffer_t* entries[OUTBOUND_QUEUE_MAX];
+    outbound_kind_t kinds[OUTBOUND_QUEUE_MAX];
+    int head;
+    int count;
+    size_t offset;              // bytes of entries[head] already sent
+    size_t queued_bytes;
+    long long over_limit_since; // monotonic ms of the first refused message, 0 if none
+} outbound_queue_t;
+
+// Policy functions
+void outbound_configure(const outbound_limits_t* limits);
+const outbound_limits_t* outbound_get_limits(void);
+void outbound_count(outbound_event_t event);
+void outbound_get_stats(outbound_stats_t* stats);
+int outbound_over_limit(size_t queued_bytes, int queued_messages, size_t length);
+int outbound_expired(long long over_limit_since, long long now_ms);
+long long outbound_now_ms(void);
+
+// Shared buffer functions
+shared_buffer_t* shared_buffer_create(const char* data, size_t length);
+shared_buffer_t* shared_buffer_retain(shared_buffer_t* buffer);
+void shared_buffer_release(shared_buffer_t* buffer);
+
+// Outbound queue functions
+int outbound_queue_init(outbound_queue_t* queue);
+void outbound_queue_cleanup(outbound_queue_t* queue);
+void outbound_queue_attach(outbound_queue_t* queue, int socket);
+void outbound_queue_detach(outbound_queue_t* queue);
+int outbound_queue_push(outbound_queue_t* queue, shared_buffer_t* buffer, outbound_kind_t kind);
+int outbound_queue_push_delta(outbound_queue_t* queue, shared_buffer_t* delta, shared_buffer_t* keyframe);
+int outbound_queue_flush(outbound_queue_t* queue);
+int outbound_queue_pending(outbound_queue_t* queue);
+int outbound_queue_expired(outbound_queue_t* queue, long long now_ms);
+
+#endif // OUTBOUND_H
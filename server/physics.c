@@ -0,0 +1,183 @@
+#include "physics.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PHYSICS_X86 1
+#include <immintrin.h>
+#endif
+
+// Per vehicle, over elapsed milliseconds (rates in physics.h):
+//   battery     -= elapsed * (10 + speed), min 0
+//   temperature += elapsed * speed, max PHYSICS_TEMPERATURE_MAX, when moving
+//   temperature -= elapsed * 100, min PHYSICS_TEMPERATURE_MIN, when stationary
+// Kernels write with plain stores: the caller holds the shards' seqlocks, and
+// readers discard copies that overlap them.
+
+typedef void (*physics_kernel_t)(const int16_t* speed, int32_t* battery, int32_t* temperature,
+                                 int count, int32_t elapsed);
+
+// ============================================================================
+// SCALAR KERNEL
+// ============================================================================
+
+static void physics_step(const int16_t* speed, int32_t* battery, int32_t* temperature, int i, int32_t elapsed) {
+    int32_t s = speed[i];
+
+    int32_t b = battery[i] - elapsed * (10 + s);
+    if (b < 0) b = 0;
+
+    int32_t t = temperature[i];
+    if (s > 0) {
+        t += elapsed * s;
+        if (t > PHYSICS_TEMPERATURE_MAX) t = PHYSICS_TEMPERATURE_MAX;
+    } else {
+        t -= elapsed * 100;
+        if (t < PHYSICS_TEMPERATURE_MIN) t = PHYSICS_TEMPERATURE_MIN;
+    }
+
+    battery[i] = b;
+    temperature[i] = t;
+}
+
+static void physics_advance_scalar(const int16_t* speed, int32_t* battery, int32_t* temperature,
+                                   int count, int32_t elapsed) {
+    for (int i = 0; i < count; i++) {
+        physics_step(speed, battery, temperature, i, elapsed);
+    }
+}
+
+#ifdef PHYSICS_X86
+
+// ============================================================================
+// SSE4.1 KERNEL (4 vehicles per step)
+// ============================================================================
+
+__attribute__((target("sse4.1")))
+static void physics_advance_sse41(const int16_t* speed, int32_t* battery, int32_t* temperature,
+                                  int count, int32_t elapsed) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i elapsed_v = _mm_set1_epi32(elapsed);
+    const __m128i base = _mm_set1_epi32(10 * elapsed);
+    const __m128i cool = _mm_set1_epi32(100 * elapsed);
+    const __m128i t_min = _mm_set1_epi32(PHYSICS_TEMPERATURE_MIN);
+    const __m128i t_max = _mm_set1_epi32(PHYSICS_TEMPERATURE_MAX);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)(speed + i)));
+        __m128i b = _mm_loadu_si128((const __m128i*)(battery + i));
+        __m128i t = _mm_loadu_si128((const __m128i*)(temperature + i));
+
+        __m128i heat = _mm_mullo_epi32(elapsed_v, s);
+        b = _mm_max_epi32(_mm_sub_epi32(b, _mm_add_epi32(base, heat)), zero);
+
+        __m128i hot = _mm_min_epi32(_mm_add_epi32(t, heat), t_max);
+        __m128i cold = _mm_max_epi32(_mm_sub_epi32(t, cool), t_min);
+        t = _mm_blendv_epi8(cold, hot, _mm_cmpgt_epi32(s, zero));
+
+        _mm_storeu_si128((__m128i*)(battery + i), b);
+        _mm_storeu_si128((__m128i*)(temperature + i), t);
+    }
+    for (; i < count; i++) {
+        physics_step(speed, battery, temperature, i, elapsed);
+    }
+}
+
+// ============================================================================
+// AVX2 KERNEL (8 vehicles per step)
+// ============================================================================
+
+__attribute__((target("avx2")))
+static void physics_advance_avx2(const int16_t* speed, int32_t* battery, int32_t* temperature,
+                                 int count, int32_t elapsed) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i elapsed_v = _mm256_set1_epi32(elapsed);
+    const __m256i base = _mm256_set1_epi32(10 * elapsed);
+    const __m256i cool = _mm256_set1_epi32(100 * elapsed);
+    const __m256i t_min = _mm256_set1_epi32(PHYSICS_TEMPERATURE_MIN);
+    const __m256i t_max = _mm256_set1_epi32(PHYSICS_TEMPERATURE_MAX);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(speed + i)));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(battery + i));
+        __m256i t = _mm256_loadu_si256((const __m256i*)(temperature + i));
+
+        __m256i heat = _mm256_mullo_epi32(elapsed_v, s);
+        b = _mm256_max_epi32(_mm256_sub_epi32(b, _mm256_add_epi32(base, heat)), zero);
+
+        __m256i hot = _mm256_min_epi32(_mm256_add_epi32(t, heat), t_max);
+        __m256i cold = _mm256_max_epi32(_mm256_sub_epi32(t, cool), t_min);
+        t = _mm256_blendv_epi8(cold, hot, _mm256_cmpgt_epi32(s, zero));
+
+        _mm256_storeu_si256((__m256i*)(battery + i), b);
+        _mm256_storeu_si256((__m256i*)(temperature + i), t);
+    }
+    for (; i < count; i++) {
+        physics_step(speed, battery, temperature, i, elapsed);
+    }
+}
+
+#endif // PHYSICS_X86
+
+// ============================================================================
+// RUNTIME DISPATCH
+// ============================================================================
+
+static const physics_kernel_t physics_kernels[PHYSICS_ISA_COUNT] = {
+    physics_advance_scalar,
+#ifdef PHYSICS_X86
+    physics_advance_sse41,
+    physics_advance_avx2,
+#endif
+};
+
+static int physics_selected = -1;   // resolved on first use
+
+int physics_isa_supported(physics_isa_t isa) {
+    switch (isa) {
+        case PHYSICS_SCALAR: return 1;
+#ifdef PHYSICS_X86
+        case PHYSICS_SSE41: __builtin_cpu_init(); return __builtin_cpu_supports("sse4.1") != 0;
+        case PHYSICS_AVX2: __builtin_cpu_init(); return __builtin_cpu_supports("avx2") != 0;
+#endif
+        default: return 0;
+    }
+}
+
+// Widest instruction set this CPU runs
+physics_isa_t physics_active_isa(void) {
+    int isa = __atomic_load_n(&physics_selected, __ATOMIC_RELAXED);
+    if (isa < 0) {
+        isa = PHYSICS_SCALAR;
+        for (int candidate = PHYSICS_ISA_COUNT - 1; candidate > PHYSICS_SCALAR; candidate--) {
+            if (physics_isa_supported((physics_isa_t)candidate)) {
+                isa = candidate;
+                break;
+            }
+        }
+        __atomic_store_n(&physics_selected, isa, __ATOMIC_RELAXED);
+    }
+    return (physics_isa_t)isa;
+}
+
+const char* physics_isa_name(physics_isa_t isa) {
+    switch (isa) {
+        case PHYSICS_SCALAR: return "scalar";
+        case PHYSICS_SSE41: return "sse4.1";
+        case PHYSICS_AVX2: return "avx2";
+        default: return "unknown";
+    }
+}
+
+void physics_advance_isa(physics_isa_t isa, const int16_t* speed, int32_t* battery, int32_t* temperature,
+                         int count, long elapsed_ms) {
+    if (!speed || !battery || !temperature || count <= 0 || elapsed_ms <= 0) return;
+    if (isa < 0 || isa >= PHYSICS_ISA_COUNT || !physics_kernels[isa]) isa = PHYSICS_SCALAR;
+
+    if (elapsed_ms > PHYSICS_MAX_ELAPSED_MS) elapsed_ms = PHYSICS_MAX_ELAPSED_MS;
+    physics_kernels[isa](speed, battery, temperature, count, (int32_t)elapsed_ms);
+}
+
+void physics_advance(const int16_t* speed, int32_t* battery, int32_t* temperature, int count, long elapsed_ms) {
+    physics_advance_isa(physics_active_isa(), speed, battery, temperature, count, elapsed_ms);
+}
@@ -0,0 +1,39 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include <stdint.h>
+
+// Battery and temperature are fixed-point, in units small enough that every
+// rate is a whole number of units per millisecond, so steps of any length
+// lose nothing to truncation:
+//   battery      -(10 + speed) per ms   (1% per minute, plus 1% per minute per 10 km/h)
+//   temperature  +speed per ms when moving (speed/1000 degrees per second)
+//                -100 per ms when stationary (0.1 degrees per second)
+#define PHYSICS_BATTERY_UNIT 600000         // units per battery percent
+#define PHYSICS_TEMPERATURE_UNIT 1000000    // units per celsius degree
+#define PHYSICS_BATTERY_MAX (100 * PHYSICS_BATTERY_UNIT)
+#define PHYSICS_TEMPERATURE_MIN (20 * PHYSICS_TEMPERATURE_UNIT)
+#define PHYSICS_TEMPERATURE_MAX (50 * PHYSICS_TEMPERATURE_UNIT)
+#define PHYSICS_MAX_ELAPSED_MS 6000000      // 100 minutes saturate every field; keeps products in 32 bits
+
+// Instruction sets the batch kernel is built for
+typedef enum {
+    PHYSICS_SCALAR,
+    PHYSICS_SSE41,
+    PHYSICS_AVX2,
+    PHYSICS_ISA_COUNT
+} physics_isa_t;
+
+// Batch kernel: advances battery and temperature of count vehicles stored as
+// parallel arrays by elapsed_ms. Every instruction set gives the same result
+// as the scalar loop.
+void physics_advance(const int16_t* speed, int32_t* battery, int32_t* temperature, int count, long elapsed_ms);
+void physics_advance_isa(physics_isa_t isa, const int16_t* speed, int32_t* battery, int32_t* temperature,
+                         int count, long elapsed_ms);
+
+// Runtime dispatch
+physics_isa_t physics_active_isa(void);
+int physics_isa_supported(physics_isa_t isa);
+const char* physics_isa_name(physics_isa_t isa);
+
+#endif // PHYSICS_H
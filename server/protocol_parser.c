@@ -0,0 +1,196 @@
+#include "protocol_parser.h"
+#include <string.h>
+
+// ============================================================================
+// LOOKUP TABLES
+// ============================================================================
+
+// Verbs are told apart by length first, then by their first byte, so a
+// lookup costs at most one memcmp.
+static command_type_t protocol_lookup_verb(const char* verb, size_t length) {
+    switch (length) {
+        case 4:
+            if (memcmp(verb, "AUTH", 4) == 0) return CMD_AUTH;
+            break;
+        case 6:
+            if (memcmp(verb, "RESUME", 6) == 0) return CMD_RESUME;
+            break;
+        case 8:
+            switch (verb[0]) {
+                case 'G': if (memcmp(verb, "GET_DATA", 8) == 0) return CMD_GET_DATA; break;
+                case 'S': if (memcmp(verb, "SEND_CMD", 8) == 0) return CMD_SEND_CMD; break;
+                case 'R': if (memcmp(verb, "RECHARGE", 8) == 0) return CMD_RECHARGE; break;
+                case 'P': if (memcmp(verb, "PROTOCOL", 8) == 0) return CMD_PROTOCOL; break;
+            }
+            break;
+        case 9:
+            if (memcmp(verb, "SUBSCRIBE", 9) == 0) return CMD_SUBSCRIBE;
+            break;
+        case 10:
+            switch (verb[0]) {
+                case 'L': if (memcmp(verb, "LIST_USERS", 10) == 0) return CMD_LIST_USERS; break;
+                case 'D': if (memcmp(verb, "DISCONNECT", 10) == 0) return CMD_DISCONNECT; break;
+            }
+            break;
+        case 11:
+            if (memcmp(verb, "GET_HISTORY", 11) == 0) return CMD_GET_HISTORY;
+            break;
+    }
+    return CMD_UNKNOWN;
+}
+
+vehicle_command_t protocol_decode_vehicle_command(const char* data, size_t length) {
+    if (!data) return VEHICLE_CMD_INVALID;
+
+    switch (length) {
+        case 8:
+            if (memcmp(data, "SPEED_UP", 8) == 0) return VEHICLE_CMD_SPEED_UP;
+            break;
+        case 9:
+            switch (data[0]) {
+                case 'S': if (memcmp(data, "SLOW_DOWN", 9) == 0) return VEHICLE_CMD_SLOW_DOWN; break;
+                case 'T': if (memcmp(data, "TURN_LEFT", 9) == 0) return VEHICLE_CMD_TURN_LEFT; break;
+            }
+            break;
+        case 10:
+            if (memcmp(data, "TURN_RIGHT", 10) == 0) return VEHICLE_CMD_TURN_RIGHT;
+            break;
+    }
+    return VEHICLE_CMD_INVALID;
+}
+
+// Decimal digits only, short enough not to overflow
+long protocol_decode_vehicle_id(const char* data, size_t length) {
+    if (!data || length == 0 || length > PROTOCOL_VEHICLE_ID_DIGITS) return PROTOCOL_VEHICLE_INVALID;
+
+    long id = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] < '0' || data[i] > '9') return PROTOCOL_VEHICLE_INVALID;
+        id = id * 10 + (data[i] - '0');
+    }
+    return id;
+}
+
+// ============================================================================
+// PARSER FUNCTIONS
+// ============================================================================
+
+static int is_line_end(char c) {
+    return c == '\0' || c == '\r' || c == '\n';
+}
+
+// Stops at end if given, else at the end of the line
+static int at_end(const char* p, const char* end) {
+    return (end && p >= end) || is_line_end(*p);
+}
+
+// Whitespace-separated params up to end; decodes the SEND_CMD sub-command
+static void protocol_tokenize(parsed_command_t* parsed, const char* p, const char* end) {
+    while (parsed->param_count < MAX_COMMAND_PARAMS) {
+        while (!at_end(p, end) && (*p == ' ' || *p == '\t')) p++;
+        if (at_end(p, end)) break;
+
+        const char* start = p;
+        while (!at_end(p, end) && *p != ' ' && *p != '\t') p++;
+        parsed->params[parsed->param_count].data = start;
+        parsed->params[parsed->param_count].length = (size_t)(p - start);
+        parsed->param_count++;
+    }
+
+    // A leading param that starts with a digit names the vehicle
+    int first = 0;
+    if ((parsed->type == CMD_GET_DATA || parsed->type == CMD_SEND_CMD || parsed->type == CMD_RECHARGE) &&
+        parsed->param_count > 0 && parsed->params[0].data[0] >= '0' && parsed->params[0].data[0] <= '9') {
+        parsed->vehicle_id = protocol_decode_vehicle_id(parsed->params[0].data, parsed->params[0].length);
+        first = 1;
+    }
+
+    if (parsed->type == CMD_SEND_CMD) {
+        parsed->vehicle_cmd = parsed->param_count > first
+            ? protocol_decode_vehicle_command(parsed->params[first].data, parsed->params[first].length)
+            : VEHICLE_CMD_INVALID;
+    }
+}
+
+static void protocol_reset(parsed_command_t* parsed, command_type_t type) {
+    parsed->type = type;
+    parsed->vehicle_cmd = VEHICLE_CMD_NONE;
+    parsed->vehicle_id = PROTOCOL_VEHICLE_DEFAULT;
+    parsed->param_count = 0;
+}
+
+// Single pass over the first line: "VERB: param param ...". Nothing is
+// copied; params are views into command.
+command_type_t protocol_parse_command(const char* command, parsed_command_t* parsed) {
+    if (!parsed) return CMD_UNKNOWN;
+
+    protocol_reset(parsed, CMD_UNKNOWN);
+    if (!command) return CMD_UNKNOWN;
+
+    const char* p = command;
+    while (!is_line_end(*p) && *p != ':') p++;
+    if (*p != ':') return CMD_UNKNOWN;
+
+    parsed->type = protocol_lookup_verb(command, (size_t)(p - command));
+    if (parsed->type == CMD_UNKNOWN) return CMD_UNKNOWN;
+
+    protocol_tokenize(parsed, p + 1, NULL);
+    return parsed->type;
+}
+
+// Same as the text after "VERB:", for frames that carry the verb separately
+void protocol_parse_args(parsed_command_t* parsed, command_type_t type, const char* data, size_t length) {
+    if (!parsed) return;
+
+    protocol_reset(parsed, type);
+    if (data && type != CMD_UNKNOWN) {
+        protocol_tokenize(parsed, data, data + length);
+    } else if (type == CMD_SEND_CMD) {
+        parsed->vehicle_cmd = VEHICLE_CMD_INVALID;
+    }
+}
+
+// Copies a view into a NUL-terminated buffer, truncating if needed. Returns
+// the view length, so a result >= size means the copy was truncated.
+size_t string_view_copy(string_view_t view, char* buffer, size_t size) {
+    if (!buffer || size == 0) return view.length;
+
+    size_t count = view.length < size - 1 ? view.length : size - 1;
+    if (count > 0) memcpy(buffer, view.data, count);
+    buffer[count] = '\0';
+    return view.length;
+}
+
+int string_view_equals(string_view_t view, const char* text) {
+    if (!text) return 0;
+
+    size_t length = strlen(text);
+    return view.length == length && memcmp(view.data, text, length) == 0;
+}
+
+// ============================================================================
+// HELPER FUNCTIONS
+// ============================================================================
+
+const char* protocol_command_type_to_string(command_type_t type) {
+    switch (type) {
+        case CMD_AUTH: return "AUTH";
+        case CMD_GET_DATA: return "GET_DATA";
+        case CMD_SEND_CMD: return "SEND_CMD";
+        case CMD_LIST_USERS: return "LIST_USERS";
+        case CMD_RECHARGE: return "RECHARGE";
+        case CMD_DISCONNECT: return "DISCONNECT";
+        case CMD_PROTOCOL: return "PROTOCOL";
+        case CMD_SUBSCRIBE: return "SUBSCRIBE";
+        case CMD_GET_HISTORY: return "GET_HISTORY";
+        case CMD_RESUME: return "RESUME";
+        case CMD_UNKNOWN: return "UNKNOWN";
+        default: return "UNKNOWN";
+    }
+}
+
+int protocol_validate_vehicle_command(const char* command) {
+    if (!command) return 0;
+
+    return protocol_decode_vehicle_command(command, strlen(command)) != VEHICLE_CMD_INVALID;
+}
@@ -0,0 +1,67 @@
+#ifndef PROTOCOL_PARSER_H
+#define PROTOCOL_PARSER_H
+
+#include <stddef.h>
+
+// Parser constants
+#define MAX_COMMAND_PARAMS 3
+#define PROTOCOL_VEHICLE_DEFAULT 0      // commands that name no vehicle address this one
+#define PROTOCOL_VEHICLE_INVALID -1     // id present but not a number that fits
+#define PROTOCOL_VEHICLE_ID_DIGITS 9
+
+// Command types
+typedef enum {
+    CMD_AUTH,
+    CMD_GET_DATA,
+    CMD_SEND_CMD,
+    CMD_LIST_USERS,
+    CMD_RECHARGE,
+    CMD_DISCONNECT,
+    CMD_PROTOCOL,       // switch the connection between text and binary framing
+    CMD_SUBSCRIBE,      // stream telemetry to this connection at its own rate
+    CMD_GET_HISTORY,    // a time range of the stream vehicle's history
+    CMD_RESUME,         // authenticate with the token of an earlier AUTH
+    CMD_UNKNOWN
+} command_type_t;
+
+// SEND_CMD sub-commands, decoded once by the parser
+typedef enum {
+    VEHICLE_CMD_NONE,           // not a SEND_CMD
+    VEHICLE_CMD_SPEED_UP,
+    VEHICLE_CMD_SLOW_DOWN,
+    VEHICLE_CMD_TURN_LEFT,
+    VEHICLE_CMD_TURN_RIGHT,
+    VEHICLE_CMD_INVALID
+} vehicle_command_t;
+
+// Non-owning slice of the message being parsed (not NUL-terminated)
+typedef struct {
+    const char* data;
+    size_t length;
+} string_view_t;
+
+// Structure for parsed command. Params point into the parsed message and are
+// only valid while it is. GET_DATA, SEND_CMD and RECHARGE take an optional
+// leading vehicle id ("SEND_CMD: 42 SPEED_UP"), decoded into vehicle_id and
+// kept as params[0].
+typedef struct {
+    command_type_t type;
+    vehicle_command_t vehicle_cmd;
+    long vehicle_id;
+    string_view_t params[MAX_COMMAND_PARAMS];
+    int param_count;
+} parsed_command_t;
+
+// Parser functions
+command_type_t protocol_parse_command(const char* command, parsed_command_t* parsed);
+void protocol_parse_args(parsed_command_t* parsed, command_type_t type, const char* data, size_t length);
+vehicle_command_t protocol_decode_vehicle_command(const char* data, size_t length);
+long protocol_decode_vehicle_id(const char* data, size_t length);
+size_t string_view_copy(string_view_t view, char* buffer, size_t size);
+int string_view_equals(string_view_t view, const char* text);
+
+// Helper functions
+const char* protocol_command_type_to_string(command_type_t type);
+int protocol_validate_vehicle_command(const char* command);
+
+#endif // PROTOCOL_PARSER_H
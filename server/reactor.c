@@ -0,0 +1,353 @@
+#include "reactor.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// Tags stored in epoll_event.data.ptr for the non-session descriptors
+static int listener_tag;
+static int wakeup_tag;
+
+// ============================================================================
+// SESSION HELPERS
+// ============================================================================
+
+static int reactor_watch(reactor_t* reactor, session_t* session) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    if (session->state != SESSION_READING) {
+        ev.events |= EPOLLOUT;
+    }
+    ev.data.ptr = session;
+    return epoll_ctl(reactor->epoll_fd, EPOLL_CTL_MOD, session->socket, &ev);
+}
+
+static void session_close(reactor_t* reactor, session_t* session) {
+    epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, session->socket, NULL);
+
+    subscription_move(session->input.telemetry_hz, 0);
+    session_groups_unlink(&reactor->groups, session);
+
+    // Removing the client also closes its socket, unless the idle cleanup
+    // already freed the slot
+    if (client_manager_remove_client(reactor->client_mgr, session->client) != 0) {
+        socket_close_connection(session->socket);
+    }
+
+    if (session->prev) session->prev->next = session->next;
+    else reactor->sessions = session->next;
+    if (session->next) session->next->prev = session->prev;
+    reactor->session_count--;
+
+    // Later events in the same batch may still point here; free after the batch
+    session->socket = -1;
+    session->prev = NULL;
+    session->next = reactor->closed;
+    reactor->closed = session;
+}
+
+static void reactor_release_closed(reactor_t* reactor) {
+    while (reactor->closed) {
+        session_t* session = reactor->closed;
+        reactor->closed = session->next;
+        session_destroy(&reactor->session_slab, session);
+    }
+}
+
+static void session_set_state(reactor_t* reactor, session_t* session, session_state_t state) {
+    if (session->state != state) {
+        session->state = state;
+        reactor_watch(reactor, session);
+    }
+}
+
+// Write as much pending output as the socket accepts; -1 means close
+static int session_flush(reactor_t* reactor, session_t* session) {
+    while (session->out_sent < session->out_len) {
+        int sent = socket_send_data(session->socket, session->out + session->out_sent,
+                                    session->out_len - session->out_sent);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        session->out_sent += (size_t)sent;
+    }
+
+    if (session->out_sent < session->out_len) {
+        // Kernel buffer full: wait for EPOLLOUT
+        if (session->state == SESSION_READING) {
+            session_set_state(reactor, session, SESSION_WRITING);
+        }
+        return 0;
+    }
+
+    session_out_reset(session);
+    if (session->state == SESSION_CLOSING) return -1;
+    session_set_state(reactor, session, SESSION_READING);
+    return 0;
+}
+
+// ============================================================================
+// EVENT HANDLERS
+// ============================================================================
+
+static void reactor_accept(reactor_t* reactor) {
+    for (;;) {
+        struct sockaddr_in client_addr;
+        int client_socket = socket_manager_accept_client(reactor->socket_mgr, &client_addr);
+        if (client_socket < 0) return; // EAGAIN: backlog drained
+
+        // inet_ntoa's static buffer is not safe with several reactor threads
+        char ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &client_addr.sin_addr, ip, sizeof(ip));
+        int port = ntohs(client_addr.sin_port);
+
+        if (socket_set_nonblocking(client_socket) != 0) {
+            socket_close_connection(client_socket);
+            logger_log(reactor->logger, LOG_CONNECTION_REJECTED, ip, port, "Error setting socket non-blocking");
+            continue;
+        }
+        client_handle_t handle = client_manager_add_client(reactor->client_mgr, client_socket, ip, port);
+        if (handle == CLIENT_HANDLE_INVALID) {
+            logger_log(reactor->logger, LOG_CONNECTION_REJECTED, ip, port,
+                       client_manager_add_error(reactor->client_mgr, client_socket));
+            socket_close_connection(client_socket);
+            continue;
+        }
+
+        session_t* session = session_create(&reactor->session_slab, client_socket, ip, port);
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.ptr = session;
+        if (!session || epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, client_socket, &ev) != 0) {
+            session_destroy(&reactor->session_slab, session);
+            client_manager_remove_client(reactor->client_mgr, handle);
+            logger_log(reactor->logger, LOG_CONNECTION_REJECTED, ip, port, "Error adding client");
+            continue;
+        }
+        session->client = handle;
+
+        session->next = reactor->sessions;
+        if (reactor->sessions) reactor->sessions->prev = session;
+        reactor->sessions = session;
+        reactor->session_count++;
+        session_groups_link(&reactor->groups, session);
+
+        logger_log(reactor->logger, LOG_CONNECT, ip, port, "Client connected");
+    }
+}
+
+// Returns -1 when the session must be closed
+static int reactor_read(reactor_t* reactor, session_t* session) {
+    char buffer[BUFFER_SIZE];
+    int bytes_received = socket_receive_data(session->socket, buffer, sizeof(buffer));
+
+    if (bytes_received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0;
+    }
+    if (bytes_received <= 0) {
+        if (bytes_received == 0) {
+            logger_log(reactor->logger, LOG_DISCONNECT, session->ip, session->port, "Client disconnected");
+        } else {
+            logger_log(reactor->logger, LOG_ERROR, session->ip, session->port, "Error receiving data");
+        }
+        return -1;
+    }
+
+    int result = session_handle_input(session, buffer, (size_t)bytes_received,
+                                      reactor->client_mgr, reactor->fleet, reactor->logger);
+    session_groups_update(&reactor->groups, session);
+    if (result < 0) return -1;
+    if (result > 0) {
+        session_set_state(reactor, session, SESSION_CLOSING);
+    }
+    return session_flush(reactor, session);
+}
+
+static void reactor_drain_broadcasts(reactor_t* reactor) {
+    uint64_t count;
+    while (read(reactor->wakeup_fd, &count, sizeof(count)) > 0) {
+        // Drain the counter; the pending buffer holds the actual data
+    }
+
+    // Each session gets the ticks its rate group is due for, in the encoding
+    // and delta mode it negotiated. Only the due groups are walked, so ticks
+    // nobody here subscribed to (a pinned --shm or --multicast rate) cost
+    // nothing per session.
+    size_t length;
+    char* data = broadcast_queue_take(&reactor->broadcasts, &length);
+    if (!data) return;
+
+    subscription_mask_t due;
+    telemetry_ticks_due(data, length, &due);
+    long long now = outbound_now_ms();
+    for (int group = 0; group < SUBSCRIBE_GROUP_COUNT; group++) {
+        if (!due.due[group]) continue;
+        session_t* session = reactor->groups.heads[group];
+        while (session) {
+            session_t* next = session->group_next;
+            int queued = session_append_broadcasts(session, data, length);
+            if (queued < 0 || session_flush(reactor, session) != 0) {
+                session_close(reactor, session);
+            } else if (session_expired(session, now)) {
+                // Slow consumer: over its outbound limit for too long
+                outbound_count(OUTBOUND_EVENT_EVICTED);
+                logger_log(reactor->logger, LOG_DISCONNECT, session->ip, session->port,
+                           "Evicted: outbound queue over limit");
+                session_close(reactor, session);
+            }
+            session = next;
+        }
+    }
+    free(data);
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+int reactor_init(reactor_t* reactor, socket_manager_t* socket_mgr, client_manager_t* client_mgr,
+                 fleet_t* fleet, logger_t* logger) {
+    if (!reactor || !socket_mgr || !client_mgr || !fleet || !logger) return -1;
+
+    memset(reactor, 0, sizeof(reactor_t));
+    reactor->socket_mgr = socket_mgr;
+    reactor->client_mgr = client_mgr;
+    reactor->fleet = fleet;
+    reactor->logger = logger;
+    reactor->running = 1;
+    reactor->cpu = -1;
+    slab_init(&reactor->session_slab, sizeof(session_t), SLAB_CACHE_LINE, SESSION_SLAB_OBJECTS);
+
+    if (socket_set_nonblocking(socket_mgr->server_socket) != 0) return -1;
+
+    reactor->epoll_fd = epoll_create1(0);
+    if (reactor->epoll_fd < 0) {
+        perror("Error creating epoll instance");
+        return -1;
+    }
+
+    reactor->wakeup_fd = eventfd(0, EFD_NONBLOCK);
+    if (reactor->wakeup_fd < 0) {
+        perror("Error creating wakeup eventfd");
+        close(reactor->epoll_fd);
+        return -1;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = &listener_tag;
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, socket_mgr->server_socket, &ev) != 0) {
+        perror("Error registering listening socket");
+        close(reactor->wakeup_fd);
+        close(reactor->epoll_fd);
+        return -1;
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = &wakeup_tag;
+    if (epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, reactor->wakeup_fd, &ev) != 0) {
+        perror("Error registering wakeup eventfd");
+        close(reactor->wakeup_fd);
+        close(reactor->epoll_fd);
+        return -1;
+    }
+
+    broadcast_queue_init(&reactor->broadcasts);
+
+    return 0;
+}
+
+void reactor_run(reactor_t* reactor) {
+    if (!reactor) return;
+
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    while (reactor->running) {
+        int ready = epoll_wait(reactor->epoll_fd, events, REACTOR_MAX_EVENTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            perror("Error waiting for events");
+            break;
+        }
+
+        for (int i = 0; i < ready; i++) {
+            void* tag = events[i].data.ptr;
+
+            if (tag == &listener_tag) {
+                reactor_accept(reactor);
+                continue;
+            }
+            if (tag == &wakeup_tag) {
+                reactor_drain_broadcasts(reactor);
+                continue;
+            }
+
+            session_t* session = (session_t*)tag;
+            int close_session = 0;
+            if (session->socket == -1) continue; // closed earlier in this batch
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                logger_log(reactor->logger, LOG_DISCONNECT, session->ip, session->port, "Client disconnected");
+                close_session = 1;
+            }
+            if (!close_session && (events[i].events & EPOLLOUT)) {
+                close_session = session_flush(reactor, session) != 0;
+            }
+            if (!close_session && (events[i].events & (EPOLLIN | EPOLLRDHUP))) {
+                close_session = reactor_read(reactor, session) != 0;
+            }
+
+            if (close_session) {
+                session_close(reactor, session);
+            }
+        }
+
+        reactor_release_closed(reactor);
+    }
+}
+
+void reactor_stop(reactor_t* reactor) {
+    if (!reactor) return;
+
+    // Async-signal-safe: only a flag store and an eventfd write
+    reactor->running = 0;
+    uint64_t one = 1;
+    if (write(reactor->wakeup_fd, &one, sizeof(one)) < 0) {
+        // Loop will still observe running == 0 on its next wakeup
+    }
+}
+
+void reactor_broadcast(reactor_t* reactor, const char* record, size_t length) {
+    if (!reactor || !record) return;
+
+    if (broadcast_queue_push(&reactor->broadcasts, record, length) != 0) return;
+
+    uint64_t one = 1;
+    if (write(reactor->wakeup_fd, &one, sizeof(one)) < 0) {
+        perror("Error waking reactor");
+    }
+}
+
+void reactor_cleanup(reactor_t* reactor) {
+    if (!reactor) return;
+
+    while (reactor->sessions) {
+        session_close(reactor, reactor->sessions);
+    }
+    reactor_release_closed(reactor);
+
+    slab_cleanup(&reactor->session_slab);
+    broadcast_queue_cleanup(&reactor->broadcasts);
+
+    if (reactor->wakeup_fd >= 0) close(reactor->wakeup_fd);
+    if (reactor->epoll_fd >= 0) close(reactor->epoll_fd);
+    reactor->wakeup_fd = -1;
+    reactor->epoll_fd = -1;
+}
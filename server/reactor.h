@@ -0,0 +1,49 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <pthread.h>
+#include "socket_manager.h"
+#include "client_protocol.h"
+#include "fleet.h"
+#include "session.h"
+#ifdef USE_IO_URING
+#include "uring.h"
+#endif
+
+// Reactor constants
+#define REACTOR_MAX_EVENTS 256
+
+// Event loop; multi-reactor mode runs one per shard. The I/O backend (epoll
+// in reactor.c, io_uring in reactor_uring.c) is selected at build time.
+typedef struct {
+#ifdef USE_IO_URING
+    uring_t ring;
+    uring_buf_pool_t recv_pool;
+    uint64_t wakeup_value;  // target of the pending eventfd read
+#else
+    int epoll_fd;
+#endif
+    int wakeup_fd;
+    volatile int running;
+    int cpu;            // CPU the server pins this reactor's thread to, -1 for none
+    socket_manager_t* socket_mgr;
+    client_manager_t* client_mgr;
+    fleet_t* fleet;
+    logger_t* logger;
+    session_t* sessions;
+    session_t* closed;  // closed sessions waiting to be freed
+    int session_count;
+    slab_t session_slab;    // backs every session of this reactor
+    broadcast_queue_t broadcasts;   // telemetry tick records, see telemetry.h
+    session_groups_t groups;        // open sessions by rate group
+} reactor_t;
+
+// Reactor functions
+int reactor_init(reactor_t* reactor, socket_manager_t* socket_mgr, client_manager_t* client_mgr,
+                 fleet_t* fleet, logger_t* logger);
+void reactor_run(reactor_t* reactor);
+void reactor_stop(reactor_t* reactor);
+void reactor_broadcast(reactor_t* reactor, const char* record, size_t length);
+void reactor_cleanup(reactor_t* reactor);
+
+#endif // REACTOR_H
@@ -0,0 +1,434 @@
+#include "reactor.h"
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// io_uring backend for reactor.h (build with `make IO_BACKEND=uring`).
+// One multishot accept, one multishot recv per session drawing from a
+// provided buffer ring, and at most one send in flight per session. All
+// SQEs prepared while handling a batch of completions go out in a single
+// io_uring_enter call.
+
+// Operation tags packed into the low bits of user_data (sessions are malloc-aligned)
+#define OP_ACCEPT 1
+#define OP_RECV 2
+#define OP_SEND 3
+#define OP_WAKEUP 4
+#define OP_MASK 7ULL
+
+// ============================================================================
+// SUBMISSION HELPERS
+// ============================================================================
+
+static uint64_t op_pack(session_t* session, int op) {
+    return (uint64_t)(uintptr_t)session | (uint64_t)op;
+}
+
+static struct io_uring_sqe* reactor_sqe(reactor_t* reactor) {
+    struct io_uring_sqe* sqe = uring_get_sqe(&reactor->ring);
+    if (!sqe) {
+        // Queue full: push what we have to the kernel and retry
+        uring_submit(&reactor->ring, 0);
+        sqe = uring_get_sqe(&reactor->ring);
+    }
+    return sqe;
+}
+
+static void reactor_arm_accept(reactor_t* reactor) {
+    struct io_uring_sqe* sqe = reactor_sqe(reactor);
+    if (!sqe) return;
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = reactor->socket_mgr->server_socket;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = op_pack(NULL, OP_ACCEPT);
+}
+
+static void reactor_arm_wakeup(reactor_t* reactor) {
+    struct io_uring_sqe* sqe = reactor_sqe(reactor);
+    if (!sqe) return;
+
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = reactor->wakeup_fd;
+    sqe->addr = (uint64_t)(uintptr_t)&reactor->wakeup_value;
+    sqe->len = sizeof(reactor->wakeup_value);
+    sqe->user_data = op_pack(NULL, OP_WAKEUP);
+}
+
+static void reactor_arm_recv(reactor_t* reactor, session_t* session) {
+    struct io_uring_sqe* sqe = reactor_sqe(reactor);
+    if (!sqe) return;
+
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = session->socket;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUF_GROUP;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = op_pack(session, OP_RECV);
+    session->pending_ops++;
+}
+
+static void reactor_submit_send(reactor_t* reactor, session_t* session) {
+    struct io_uring_sqe* sqe = reactor_sqe(reactor);
+    if (!sqe) return;
+
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = session->socket;
+    sqe->addr = (uint64_t)(uintptr_t)(session->inflight + session->inflight_sent);
+    sqe->len = (unsigned)(session->inflight_len - session->inflight_sent);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = op_pack(session, OP_SEND);
+    session->pending_ops++;
+}
+
+// ============================================================================
+// SESSION HELPERS
+// ============================================================================
+
+static void session_close(reactor_t* reactor, session_t* session) {
+    if (session->socket == -1) return;
+
+    // Shutdown completes the pending recv/send so pending_ops can drain
+    shutdown(session->socket, SHUT_RDWR);
+
+    subscription_move(session->input.telemetry_hz, 0);
+    session_groups_unlink(&reactor->groups, session);
+
+    // SQEs prepared in this batch (a resubmitted send tail, a re-armed recv)
+    // name the socket by number, and the kernel only resolves it when they
+    // are submitted: send them now, before a multishot accept can hand that
+    // number to a new connection
+    uring_submit(&reactor->ring, 0);
+
+    // Removing the client also closes its socket, unless the idle cleanup
+    // already freed the slot
+    if (client_manager_remove_client(reactor->client_mgr, session->client) != 0) {
+        socket_close_connection(session->socket);
+    }
+
+    if (session->prev) session->prev->next = session->next;
+    else reactor->sessions = session->next;
+    if (session->next) session->next->prev = session->prev;
+    reactor->session_count--;
+
+    session->socket = -1;
+    session->prev = NULL;
+    session->next = reactor->closed;
+    if (reactor->closed) reactor->closed->prev = session;
+    reactor->closed = session;
+}
+
+// Free a closed session once the kernel no longer references it
+static void session_release(reactor_t* reactor, session_t* session) {
+    if (session->socket != -1 || session->pending_ops > 0) return;
+
+    if (session->prev) session->prev->next = session->next;
+    else reactor->closed = session->next;
+    if (session->next) session->next->prev = session->prev;
+    session_destroy(&reactor->session_slab, session);
+}
+
+// Move pending output into the in-flight buffer and send it, unless a send is already running
+static void session_flush(reactor_t* reactor, session_t* session) {
+    if (session->inflight_len > 0) return;
+
+    if (session->out_sent == session->out_len) {
+        if (session->state == SESSION_CLOSING) {
+            session_close(reactor, session);
+        } else {
+            session->state = SESSION_READING;
+        }
+        return;
+    }
+
+    // Swap buffers so appends never move memory the kernel is reading
+    char* buffer = session->inflight;
+    size_t cap = session->inflight_cap;
+    session->inflight = session->out;
+    session->inflight_cap = session->out_cap;
+    session->inflight_len = session->out_len;
+    session->inflight_sent = session->out_sent;
+    session->out = buffer;
+    session->out_cap = cap;
+    session_out_reset(session);
+
+    if (session->state == SESSION_READING) session->state = SESSION_WRITING;
+    reactor_submit_send(reactor, session);
+}
+
+// ============================================================================
+// COMPLETION HANDLERS
+// ============================================================================
+
+static void reactor_on_accept(reactor_t* reactor, int result, unsigned flags) {
+    if (!(flags & IORING_CQE_F_MORE) && reactor->running) {
+        reactor_arm_accept(reactor);
+    }
+    if (result < 0) {
+        if (result != -EINTR && result != -ECANCELED) {
+            fprintf(stderr, "Error accepting connection: %s\n", strerror(-result));
+        }
+        return;
+    }
+
+    int client_socket = result;
+    struct sockaddr_in client_addr;
+    socklen_t client_len = sizeof(client_addr);
+    memset(&client_addr, 0, sizeof(client_addr));
+    getpeername(client_socket, (struct sockaddr*)&client_addr, &client_len);
+
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, &client_addr.sin_addr, ip, sizeof(ip));
+    int port = ntohs(client_addr.sin_port);
+
+    client_handle_t handle = client_manager_add_client(reactor->client_mgr, client_socket, ip, port);
+    if (handle == CLIENT_HANDLE_INVALID) {
+        logger_log(reactor->logger, LOG_CONNECTION_REJECTED, ip, port,
+                   client_manager_add_error(reactor->client_mgr, client_socket));
+        socket_close_connection(client_socket);
+        return;
+    }
+
+    session_t* session = session_create(&reactor->session_slab, client_socket, ip, port);
+    if (!session) {
+        client_manager_remove_client(reactor->client_mgr, handle);
+        logger_log(reactor->logger, LOG_CONNECTION_REJECTED, ip, port, "Error adding client");
+        return;
+    }
+    session->client = handle;
+
+    session->next = reactor->sessions;
+    if (reactor->sessions) reactor->sessions->prev = session;
+    reactor->sessions = session;
+    reactor->session_count++;
+    session_groups_link(&reactor->groups, session);
+
+    logger_log(reactor->logger, LOG_CONNECT, ip, port, "Client connected");
+    reactor_arm_recv(reactor, session);
+}
+
+static void reactor_on_recv(reactor_t* reactor, session_t* session, int result, unsigned flags) {
+    int more = (flags & IORING_CQE_F_MORE) != 0;
+    if (!more) session->pending_ops--;
+
+    if (result > 0) {
+        uint16_t bid = (uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT);
+        if (session->socket != -1) {
+            int outcome = session_handle_input(session, uring_buf_pool_get(&reactor->recv_pool, bid),
+                                               (size_t)result, reactor->client_mgr,
+                                               reactor->fleet, reactor->logger);
+            session_groups_update(&reactor->groups, session);
+            if (outcome < 0) {
+                session_close(reactor, session);
+            } else {
+                if (outcome > 0) session->state = SESSION_CLOSING;
+                session_flush(reactor, session);
+            }
+        }
+        uring_buf_pool_recycle(&reactor->recv_pool, bid);
+
+        if (!more && session->socket != -1) reactor_arm_recv(reactor, session);
+    } else if (result == -ENOBUFS) {
+        // Buffer ring ran dry; buffers return as sessions are served
+        if (!more && session->socket != -1) reactor_arm_recv(reactor, session);
+    } else if (session->socket != -1) {
+        if (result == 0) {
+            logger_log(reactor->logger, LOG_DISCONNECT, session->ip, session->port, "Client disconnected");
+        } else {
+            logger_log(reactor->logger, LOG_ERROR, session->ip, session->port, "Error receiving data");
+        }
+        session_close(reactor, session);
+    }
+
+    session_release(reactor, session);
+}
+
+static void reactor_on_send(reactor_t* reactor, session_t* session, int result) {
+    session->pending_ops--;
+
+    if (session->socket == -1) {
+        session_release(reactor, session);
+        return;
+    }
+    if (result < 0) {
+        session_close(reactor, session);
+        session_release(reactor, session);
+        return;
+    }
+
+    session->inflight_sent += (size_t)result;
+    if (session->inflight_sent < session->inflight_len) {
+        reactor_submit_send(reactor, session); // short send: resubmit the tail
+        return;
+    }
+
+    session->inflight_len = 0;
+    session->inflight_sent = 0;
+    session_flush(reactor, session);
+    session_release(reactor, session);
+}
+
+static void reactor_on_wakeup(reactor_t* reactor) {
+    if (reactor->running) reactor_arm_wakeup(reactor);
+
+    // Each session gets the ticks its rate group is due for, in the encoding
+    // and delta mode it negotiated. Only the due groups are walked.
+    size_t length;
+    char* data = broadcast_queue_take(&reactor->broadcasts, &length);
+    if (!data) return;
+
+    subscription_mask_t due;
+    telemetry_ticks_due(data, length, &due);
+    long long now = outbound_now_ms();
+    for (int group = 0; group < SUBSCRIBE_GROUP_COUNT; group++) {
+        if (!due.due[group]) continue;
+        session_t* session = reactor->groups.heads[group];
+        while (session) {
+            session_t* next = session->group_next;
+            int queued = session_append_broadcasts(session, data, length);
+            if (queued < 0) {
+                session_close(reactor, session);
+                session_release(reactor, session);
+            } else if (session_expired(session, now)) {
+                // Slow consumer: over its outbound limit for too long
+                outbound_count(OUTBOUND_EVENT_EVICTED);
+                logger_log(reactor->logger, LOG_DISCONNECT, session->ip, session->port,
+                           "Evicted: outbound queue over limit");
+                session_close(reactor, session);
+                session_release(reactor, session);
+            } else {
+                session_flush(reactor, session);
+            }
+            session = next;
+        }
+    }
+    free(data);
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+
+int reactor_init(reactor_t* reactor, socket_manager_t* socket_mgr, client_manager_t* client_mgr,
+                 fleet_t* fleet, logger_t* logger) {
+    if (!reactor || !socket_mgr || !client_mgr || !fleet || !logger) return -1;
+
+    memset(reactor, 0, sizeof(reactor_t));
+    reactor->socket_mgr = socket_mgr;
+    reactor->client_mgr = client_mgr;
+    reactor->fleet = fleet;
+    reactor->logger = logger;
+    reactor->running = 1;
+    reactor->cpu = -1;
+    slab_init(&reactor->session_slab, sizeof(session_t), SLAB_CACHE_LINE, SESSION_SLAB_OBJECTS);
+
+    if (uring_init(&reactor->ring, URING_ENTRIES) != 0) return -1;
+
+    if (uring_buf_pool_init(&reactor->ring, &reactor->recv_pool, URING_BUF_COUNT, URING_BUF_GROUP) != 0) {
+        uring_cleanup(&reactor->ring);
+        return -1;
+    }
+
+    // Blocking eventfd: io_uring parks the read until a broadcast arrives
+    reactor->wakeup_fd = eventfd(0, 0);
+    if (reactor->wakeup_fd < 0) {
+        perror("Error creating wakeup eventfd");
+        uring_buf_pool_cleanup(&reactor->ring, &reactor->recv_pool, URING_BUF_GROUP);
+        uring_cleanup(&reactor->ring);
+        return -1;
+    }
+
+    broadcast_queue_init(&reactor->broadcasts);
+    return 0;
+}
+
+void reactor_run(reactor_t* reactor) {
+    if (!reactor) return;
+
+    reactor_arm_accept(reactor);
+    reactor_arm_wakeup(reactor);
+
+    while (reactor->running) {
+        // One syscall submits the whole batch and waits for the next completion
+        int result = uring_submit(&reactor->ring, 1);
+        if (result < 0 && result != -EINTR && result != -EBUSY) {
+            fprintf(stderr, "Error submitting to io_uring: %s\n", strerror(-result));
+            break;
+        }
+
+        struct io_uring_cqe* cqe;
+        while ((cqe = uring_peek_cqe(&reactor->ring)) != NULL) {
+            uint64_t user_data = cqe->user_data;
+            int res = cqe->res;
+            unsigned flags = cqe->flags;
+            uring_cqe_seen(&reactor->ring);
+
+            session_t* session = (session_t*)(uintptr_t)(user_data & ~OP_MASK);
+            switch ((int)(user_data & OP_MASK)) {
+                case OP_ACCEPT: reactor_on_accept(reactor, res, flags); break;
+                case OP_RECV: reactor_on_recv(reactor, session, res, flags); break;
+                case OP_SEND: reactor_on_send(reactor, session, res); break;
+                case OP_WAKEUP: reactor_on_wakeup(reactor); break;
+                default: break;
+            }
+        }
+    }
+
+    // The multishot accept would keep taking connections until the ring is
+    // torn down, and the listener may live on in a new process (upgrade.c)
+    struct io_uring_sqe* sqe = reactor_sqe(reactor);
+    if (sqe) {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = op_pack(NULL, OP_ACCEPT);
+        uring_submit(&reactor->ring, 0);
+    }
+}
+
+void reactor_stop(reactor_t* reactor) {
+    if (!reactor) return;
+
+    // Async-signal-safe: only a flag store and an eventfd write
+    reactor->running = 0;
+    uint64_t one = 1;
+    if (write(reactor->wakeup_fd, &one, sizeof(one)) < 0) {
+        // Loop will still observe running == 0 on its next wakeup
+    }
+}
+
+void reactor_broadcast(reactor_t* reactor, const char* record, size_t length) {
+    if (!reactor || !record) return;
+
+    if (broadcast_queue_push(&reactor->broadcasts, record, length) != 0) return;
+
+    uint64_t one = 1;
+    if (write(reactor->wakeup_fd, &one, sizeof(one)) < 0) {
+        perror("Error waking reactor");
+    }
+}
+
+void reactor_cleanup(reactor_t* reactor) {
+    if (!reactor) return;
+
+    while (reactor->sessions) {
+        session_close(reactor, reactor->sessions);
+    }
+    // Tearing down the ring cancels whatever is still in flight
+    uring_buf_pool_cleanup(&reactor->ring, &reactor->recv_pool, URING_BUF_GROUP);
+    uring_cleanup(&reactor->ring);
+    while (reactor->closed) {
+        session_t* session = reactor->closed;
+        reactor->closed = session->next;
+        session_destroy(&reactor->session_slab, session);
+    }
+
+    slab_cleanup(&reactor->session_slab);
+    broadcast_queue_cleanup(&reactor->broadcasts);
+    if (reactor->wakeup_fd >= 0) close(reactor->wakeup_fd);
+    reactor->wakeup_fd = -1;
+}
@@ -0,0 +1,386 @@
+#include "series.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SERIES_NAME_LENGTH 12           // "00000001.seg"
+
+// ============================================================================
+// SEGMENT LAYOUT
+// ============================================================================
+
+static size_t series_data_offset(void) {
+    return sizeof(series_header_t) + SERIES_INDEX_ENTRIES * sizeof(series_index_t);
+}
+
+static int series_is_segment(const struct dirent* entry) {
+    const char* name = entry->d_name;
+    if (strlen(name) != SERIES_NAME_LENGTH || strcmp(name + 8, ".seg") != 0) return 0;
+    for (int i = 0; i < 8; i++) {
+        if (name[i] < '0' || name[i] > '9') return 0;
+    }
+    return 1;
+}
+
+static void series_segment_path(const char* directory, uint32_t sequence, char* path, size_t size) {
+    snprintf(path, size, "%s/%08u.seg", directory, sequence);
+}
+
+// Reads and checks a segment header. Returns -1 if it is not a segment.
+static int series_read_header(int fd, series_header_t* header) {
+    if (pread(fd, header, sizeof(*header), 0) != (ssize_t)sizeof(*header)) return -1;
+    if (header->magic != SERIES_MAGIC || header->version != SERIES_VERSION ||
+        header->index_capacity != SERIES_INDEX_ENTRIES || header->block_count > SERIES_INDEX_ENTRIES) {
+        return -1;
+    }
+    return 0;
+}
+
+// Completes a segment a previous run left open: the header already counts
+// only what was fully written, so sealing it is marking it closed and
+// dropping the unused preallocation
+static void series_seal_file(const char* path) {
+    int fd = open(path, O_RDWR);
+    if (fd < 0) return;
+
+    series_header_t header;
+    if (series_read_header(fd, &header) == 0 && !header.closed) {
+        header.closed = 1;
+        if (pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+            ftruncate(fd, (off_t)(series_data_offset() + header.data_bytes)) != 0) {
+            fprintf(stderr, "Error sealing segment %s\n", path);
+        }
+    }
+    close(fd);
+}
+
+// ============================================================================
+// WRITER
+// ============================================================================
+
+// Makes the last block's samples visible: data first, then its index entry,
+// then the header
+static void series_publish(series_store_t* store) {
+    if (!store->map || store->header->block_count == 0) return;
+
+    series_index_t* entry = &store->index[store->header->block_count - 1];
+    entry->bits = (uint32_t)store->block.bits;
+    entry->count = store->block.count;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    store->header->last_ms = store->block.last.time_ms;
+    store->header->sample_count = store->block_base + store->block.count;
+    store->header->data_bytes = entry->offset + (store->block.bits + 7) / 8;
+}
+
+static int series_segment_create(series_store_t* store) {
+    char path[sizeof(store->directory) + 16];
+    series_segment_path(store->directory, store->sequence + 1, path, sizeof(path));
+
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        perror("Error creating store segment");
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)store->segment_bytes) != 0) {
+        perror("Error sizing store segment");
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+    void* map = mmap(NULL, store->segment_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("Error mapping store segment");
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+
+    // ftruncate zeroed the file, which the encoder relies on
+    store->sequence++;
+    store->fd = fd;
+    store->map = map;
+    store->header = map;
+    store->index = (series_index_t*)((unsigned char*)map + sizeof(series_header_t));
+    store->data = (unsigned char*)map + series_data_offset();
+    store->data_capacity = store->segment_bytes - series_data_offset();
+    store->block_base = 0;
+    memset(&store->block, 0, sizeof(store->block));
+    store->header->version = SERIES_VERSION;
+    store->header->index_capacity = SERIES_INDEX_ENTRIES;
+    store->header->magic = SERIES_MAGIC;
+    return 0;
+}
+
+static void series_segment_close(series_store_t* store) {
+    if (!store->map) return;
+
+    series_publish(store);
+    store->header->closed = 1;
+    size_t used = series_data_offset() + store->header->data_bytes;
+    msync(store->map, store->segment_bytes, MS_SYNC);
+    munmap(store->map, store->segment_bytes);
+    if (ftruncate(store->fd, (off_t)used) != 0) perror("Error truncating store segment");
+    close(store->fd);
+    store->fd = -1;
+    store->map = NULL;
+    store->header = NULL;
+    store->index = NULL;
+    store->data = NULL;
+}
+
+// Opens a block at the next byte after the last one. Returns -1 if the
+// segment has no room for another.
+static int series_block_begin(series_store_t* store, const series_sample_t* sample) {
+    series_header_t* header = store->header;
+    uint64_t offset = 0;
+    if (header->block_count > 0) {
+        series_publish(store);
+        offset = header->data_bytes;
+    }
+    if (header->block_count == SERIES_INDEX_ENTRIES ||
+        offset + (SERIES_SAMPLE_MAX_BITS + 7) / 8 > store->data_capacity) {
+        return -1;
+    }
+    // Only fold the finished block into the base once it is really left
+    // behind, or closing the segment would publish its samples twice
+    store->block_base += store->block.count;
+
+    series_index_t* entry = &store->index[header->block_count];
+    entry->first_ms = sample->time_ms;
+    entry->offset = offset;
+    if (header->block_count == 0) header->first_ms = sample->time_ms;
+    series_encoder_init(&store->block, store->data + offset, store->data_capacity - offset);
+    header->block_count++;
+    return 0;
+}
+
+static int series_append(series_store_t* store, const series_sample_t* sample) {
+    if (store->map && sample->time_ms - store->header->first_ms >= (int64_t)store->segment_seconds * 1000) {
+        series_segment_close(store);
+    }
+
+    // A full block, then a full segment, moves the sample on to the next one
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (!store->map && series_segment_create(store) != 0) return -1;
+
+        if (store->block.count > 0 && store->block.count < SERIES_BLOCK_SAMPLES &&
+            series_encoder_append(&store->block, sample) == 0) {
+            return 0;
+        }
+        if (series_block_begin(store, sample) == 0 && series_encoder_append(&store->block, sample) == 0) {
+            return 0;
+        }
+        series_segment_close(store);
+    }
+    return -1;
+}
+
+// Appends every step recorded since the last pass
+static void series_ingest(series_store_t* store) {
+    history_point_t points[SERIES_BATCH];
+    for (;;) {
+        uint64_t step = store->next_step;
+        int count = history_read(store->history, &step, points, SERIES_BATCH);
+        if (count <= 0) break;
+        store->skipped += step - store->next_step;
+
+        for (int i = 0; i < count; i++) {
+            series_sample_t sample;
+            sample.time_ms = history_step_time(store->history, step + (uint64_t)i);
+            sample.speed = points[i].speed;
+            sample.battery = points[i].battery;
+            sample.temperature = points[i].temperature;
+            sample.direction = (int)points[i].direction;
+            if (series_append(store, &sample) == 0) store->samples++;
+        }
+        store->next_step = step + (uint64_t)count;
+    }
+
+    if (store->map) {
+        series_publish(store);
+        msync(store->map, store->segment_bytes, MS_ASYNC);
+    }
+}
+
+static void* series_ingest_thread(void* arg) {
+    series_store_t* store = (series_store_t*)arg;
+    struct timespec period = {SERIES_FLUSH_MS / 1000, (SERIES_FLUSH_MS % 1000) * 1000000L};
+
+    while (__atomic_load_n(&store->running, __ATOMIC_ACQUIRE)) {
+        nanosleep(&period, NULL);
+        series_ingest(store);
+    }
+    return NULL;
+}
+
+// ============================================================================
+// STORE LIFECYCLE
+// ============================================================================
+
+// Creates the directory if needed, seals any segment a previous run left
+// open and continues the numbering after the last one
+int series_store_open(series_store_t* store, const char* directory, int segment_mb, int segment_minutes) {
+    if (!store || !directory) return -1;
+
+    memset(store, 0, sizeof(series_store_t));
+    store->fd = -1;
+    if (strlen(directory) >= sizeof(store->directory) || segment_mb <= 0 || segment_mb > SERIES_MAX_SEGMENT_MB ||
+        segment_minutes <= 0) {
+        fprintf(stderr, "Invalid store configuration: %s\n", directory);
+        return -1;
+    }
+    strcpy(store->directory, directory);
+    store->segment_bytes = (size_t)segment_mb * 1024 * 1024;
+    store->segment_seconds = segment_minutes * 60;
+
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        perror("Error creating store directory");
+        return -1;
+    }
+
+    struct dirent** names;
+    int count = scandir(directory, &names, series_is_segment, alphasort);
+    if (count < 0) {
+        perror("Error reading store directory");
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        char path[sizeof(store->directory) + 16];
+        snprintf(path, sizeof(path), "%s/%s", directory, names[i]->d_name);
+        series_seal_file(path);
+        uint32_t sequence = (uint32_t)strtoul(names[i]->d_name, NULL, 10);
+        if (sequence > store->sequence) store->sequence = sequence;
+        free(names[i]);
+    }
+    free(names);
+    return 0;
+}
+
+// Records from the history's current step on
+int series_store_start(series_store_t* store, history_t* history) {
+    if (!store || !history || store->running) return -1;
+
+    store->history = history;
+    store->next_step = __atomic_load_n(&history->head, __ATOMIC_ACQUIRE);
+    store->running = 1;
+    if (pthread_create(&store->thread, NULL, series_ingest_thread, store) != 0) {
+        perror("Error creating store thread");
+        store->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+// Writes what is left in the history and closes the open segment
+void series_store_close(series_store_t* store) {
+    if (!store) return;
+
+    if (store->running) {
+        __atomic_store_n(&store->running, 0, __ATOMIC_RELEASE);
+        pthread_join(store->thread, NULL);
+        series_ingest(store);
+    }
+    series_segment_close(store);
+}
+
+// ============================================================================
+// QUERIES
+// ============================================================================
+
+// Visits one segment's samples in from_ms..to_ms. Returns 1 once past to_ms
+// or stopped by visit.
+static int series_query_segment(const char* path, int64_t from_ms, int64_t to_ms, series_visit_t visit,
+                                void* context, int* segments_read) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+
+    // The header alone rules out most segments of a long store
+    series_header_t header;
+    struct stat info;
+    if (series_read_header(fd, &header) != 0 || header.sample_count == 0 || header.last_ms < from_ms ||
+        fstat(fd, &info) != 0 || (size_t)info.st_size < series_data_offset()) {
+        close(fd);
+        return 0;
+    }
+    if (header.first_ms > to_ms) {
+        close(fd);
+        return 1;
+    }
+
+    size_t size = (size_t)info.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+    if (segments_read) (*segments_read)++;
+
+    const series_index_t* index = (const series_index_t*)((const unsigned char*)map + sizeof(series_header_t));
+    const unsigned char* data = (const unsigned char*)map + series_data_offset();
+    size_t data_size = size - series_data_offset();
+
+    // Last block starting at or before from_ms
+    int low = 0, high = (int)header.block_count - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (index[middle].first_ms <= from_ms) low = middle;
+        else high = middle - 1;
+    }
+
+    int done = 0;
+    for (int block = low; block < (int)header.block_count && !done; block++) {
+        series_index_t entry = index[block];
+        if (entry.first_ms > to_ms) {
+            done = 1;
+            break;
+        }
+        if (entry.offset + (entry.bits + 7) / 8 > data_size) break;
+
+        series_decoder_t decoder;
+        series_sample_t sample;
+        series_decoder_init(&decoder, data + entry.offset, entry.bits, entry.count);
+        while (series_decoder_next(&decoder, &sample) > 0) {
+            if (sample.time_ms < from_ms) continue;
+            if (sample.time_ms > to_ms || visit(&sample, context) != 0) {
+                done = 1;
+                break;
+            }
+        }
+    }
+    munmap(map, size);
+    return done;
+}
+
+// Visits every stored sample in from_ms..to_ms, oldest first. Segments are
+// mapped one at a time, and only those whose header overlaps the range, so
+// a query costs the blocks it decodes rather than the size of the store.
+// Returns the number of segments in the directory, -1 if it cannot be read.
+int series_query(const char* directory, int64_t from_ms, int64_t to_ms, series_visit_t visit, void* context,
+                 int* segments_read) {
+    if (!directory || !visit) return -1;
+
+    struct dirent** names;
+    int count = scandir(directory, &names, series_is_segment, alphasort);
+    if (count < 0) {
+        perror("Error reading store directory");
+        return -1;
+    }
+
+    int done = 0;
+    for (int i = 0; i < count; i++) {
+        if (!done) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s", directory, names[i]->d_name);
+            done = series_query_segment(path, from_ms, to_ms, visit, context, segments_read);
+        }
+        free(names[i]);
+    }
+    free(names);
+    return count;
+}
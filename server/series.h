@@ -0,0 +1,92 @@
+#ifndef SERIES_H
+#define SERIES_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "series_codec.h"
+#include "history.h"
+
+// Store constants
+#define SERIES_DEFAULT_SEGMENT_MB 4
+#define SERIES_MAX_SEGMENT_MB 1024
+#define SERIES_DEFAULT_SEGMENT_MINUTES 60
+#define SERIES_INDEX_ENTRIES 1024       // blocks per segment
+#define SERIES_BLOCK_SAMPLES 4096       // samples per block; 41 s at 100 Hz
+#define SERIES_FLUSH_MS 1000            // ingest period
+#define SERIES_BATCH 1024               // steps copied from the history per read
+#define SERIES_MAGIC 0x53535456         // "VTSS"
+#define SERIES_VERSION 1
+
+// Durable telemetry in a directory of segment files (00000001.seg, ...),
+// each written through a shared memory map. A segment is
+//
+//   header   64 bytes, series_header_t
+//   index    SERIES_INDEX_ENTRIES x series_index_t, one per block
+//   data     blocks of series_codec.h bit stream, each starting on a byte
+//            and decodable on its own
+//
+// The index is sparse: one entry per block of up to SERIES_BLOCK_SAMPLES
+// samples, holding its first timestamp, so a seek is a binary search over the
+// index and the decoding of one block. The writer fills a block, then its
+// index entry, then the header, so a crash leaves every sample the header
+// counts readable. A segment closes when its data or index is full or it spans
+// the configured time. It is then truncated to the bytes in use.
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t closed;            // 1 once the segment is complete
+    uint32_t block_count;
+    uint32_t index_capacity;
+    int64_t first_ms;
+    int64_t last_ms;
+    uint64_t sample_count;
+    uint64_t data_bytes;        // bytes of the data area in use
+    uint64_t reserved[2];
+} series_header_t;
+
+typedef struct {
+    int64_t first_ms;
+    uint64_t offset;            // from the start of the data area
+    uint32_t count;             // samples
+    uint32_t bits;
+} series_index_t;
+
+// Writer: the ingest thread copies new steps out of the history ring each
+// SERIES_FLUSH_MS and appends them, so recording costs the simulation nothing
+typedef struct {
+    char directory[256];
+    size_t segment_bytes;
+    int segment_seconds;
+
+    // Open segment
+    int fd;
+    uint32_t sequence;
+    unsigned char* map;
+    series_header_t* header;
+    series_index_t* index;
+    unsigned char* data;
+    size_t data_capacity;
+    series_encoder_t block;     // the last block, still being appended to
+    uint64_t block_base;        // samples in the segment's earlier blocks
+
+    // Ingest
+    history_t* history;
+    uint64_t next_step;
+    pthread_t thread;
+    volatile int running;
+    unsigned long long samples;
+    unsigned long long skipped;     // steps overwritten in the ring before ingest
+} series_store_t;
+
+// Store lifecycle
+int series_store_open(series_store_t* store, const char* directory, int segment_mb, int segment_minutes);
+int series_store_start(series_store_t* store, history_t* history);
+void series_store_close(series_store_t* store);
+
+// Queries: visit returns non-zero to stop early
+typedef int (*series_visit_t)(const series_sample_t* sample, void* context);
+int series_query(const char* directory, int64_t from_ms, int64_t to_ms, series_visit_t visit, void* context,
+                 int* segments_read);
+
+#endif // SERIES_H
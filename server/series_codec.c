@@ -0,0 +1,188 @@
+#include "series_codec.h"
+#include <string.h>
+
+// ============================================================================
+// BIT HELPERS
+// ============================================================================
+
+static void series_put_bits(series_encoder_t* encoder, uint64_t value, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+        if ((value >> i) & 1) encoder->data[encoder->bits >> 3] |= (unsigned char)(0x80 >> (encoder->bits & 7));
+        encoder->bits++;
+    }
+}
+
+// Returns -1 past the valid bits
+static int series_get_bits(series_decoder_t* decoder, int count, uint64_t* value) {
+    if (decoder->position + (size_t)count > decoder->bits) return -1;
+
+    uint64_t result = 0;
+    for (int i = 0; i < count; i++) {
+        size_t bit = decoder->position++;
+        result = (result << 1) | ((decoder->data[bit >> 3] >> (7 - (bit & 7))) & 1);
+    }
+    *value = result;
+    return 0;
+}
+
+static uint64_t series_zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t series_unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// Sign-extends the low count bits
+static int64_t series_signed(uint64_t value, int count) {
+    uint64_t sign = (uint64_t)1 << (count - 1);
+    return (int64_t)((value ^ sign) - sign);
+}
+
+static int series_field(const series_sample_t* sample, int field) {
+    switch (field) {
+        case 0: return sample->speed;
+        case 1: return sample->battery;
+        case 2: return sample->temperature;
+        default: return sample->direction;
+    }
+}
+
+static void series_set_field(series_sample_t* sample, int field, int value) {
+    switch (field) {
+        case 0: sample->speed = value; break;
+        case 1: sample->battery = value; break;
+        case 2: sample->temperature = value; break;
+        default: sample->direction = value; break;
+    }
+}
+
+// Bits of each delta-of-delta bucket after its prefix, smallest first
+static const int series_dod_bits[] = {7, 9, 12, 32};
+#define SERIES_DOD_BUCKETS 4
+
+// ============================================================================
+// ENCODING FUNCTIONS
+// ============================================================================
+
+// data must be zeroed: bits are ORed in
+void series_encoder_init(series_encoder_t* encoder, unsigned char* data, size_t capacity) {
+    memset(encoder, 0, sizeof(*encoder));
+    encoder->data = data;
+    encoder->capacity_bits = capacity * 8;
+}
+
+// Returns -1, writing nothing, if the sample does not fit the buffer or its
+// interval is too far from the previous one; it then starts a new block.
+int series_encoder_append(series_encoder_t* encoder, const series_sample_t* sample) {
+    if (!encoder || !sample || encoder->bits + SERIES_SAMPLE_MAX_BITS > encoder->capacity_bits) return -1;
+
+    if (encoder->count == 0) {
+        series_put_bits(encoder, (uint64_t)sample->time_ms, 64);
+        series_put_bits(encoder, (uint16_t)sample->speed, 16);
+        series_put_bits(encoder, (uint8_t)sample->battery, 8);
+        series_put_bits(encoder, (uint8_t)sample->temperature, 8);
+        series_put_bits(encoder, (uint8_t)sample->direction, 8);
+    } else {
+        int64_t delta = sample->time_ms - encoder->last.time_ms;
+        uint64_t dod = series_zigzag(delta - encoder->last_delta);
+        if (dod == 0) {
+            series_put_bits(encoder, 0, 1);
+        } else {
+            int bucket = 0;
+            while (bucket < SERIES_DOD_BUCKETS && dod >= (uint64_t)1 << series_dod_bits[bucket]) bucket++;
+            if (bucket == SERIES_DOD_BUCKETS) return -1;
+            // Prefix: bucket + 1 ones, then a zero except for the last bucket
+            int prefix_bits = bucket + 2 < 4 ? bucket + 2 : 4;
+            uint64_t prefix = (((uint64_t)1 << (bucket + 1)) - 1) << (prefix_bits - bucket - 1);
+            series_put_bits(encoder, prefix, prefix_bits);
+            series_put_bits(encoder, dod, series_dod_bits[bucket]);
+        }
+        encoder->last_delta = delta;
+
+        for (int field = 0; field < SERIES_FIELD_COUNT; field++) {
+            int64_t change = (int64_t)series_field(sample, field) - series_field(&encoder->last, field);
+            uint64_t zigzag = series_zigzag(change);
+            if (change == 0) {
+                series_put_bits(encoder, 0, 1);
+            } else if (zigzag < 16) {
+                series_put_bits(encoder, 0x2, 2);
+                series_put_bits(encoder, zigzag, 4);
+            } else {
+                series_put_bits(encoder, 0x3, 2);
+                series_put_bits(encoder, (uint16_t)series_field(sample, field), 16);
+            }
+        }
+    }
+
+    encoder->last = *sample;
+    encoder->count++;
+    return 0;
+}
+
+// ============================================================================
+// DECODING FUNCTIONS
+// ============================================================================
+
+void series_decoder_init(series_decoder_t* decoder, const unsigned char* data, size_t bits, uint32_t count) {
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->data = data;
+    decoder->bits = bits;
+    decoder->remaining = count;
+}
+
+// Returns 1 with sample filled, 0 after the block's last sample and -1 if
+// the stream ends early
+int series_decoder_next(series_decoder_t* decoder, series_sample_t* sample) {
+    if (!decoder || !sample) return -1;
+    if (decoder->remaining == 0) return 0;
+
+    uint64_t value;
+    series_sample_t next = decoder->last;
+    if (decoder->position == 0) {
+        uint64_t speed, battery, temperature, direction;
+        if (series_get_bits(decoder, 64, &value) != 0 || series_get_bits(decoder, 16, &speed) != 0 ||
+            series_get_bits(decoder, 8, &battery) != 0 || series_get_bits(decoder, 8, &temperature) != 0 ||
+            series_get_bits(decoder, 8, &direction) != 0) {
+            return -1;
+        }
+        next.time_ms = (int64_t)value;
+        next.speed = (int)series_signed(speed, 16);
+        next.battery = (int)battery;
+        next.temperature = (int)series_signed(temperature, 8);
+        next.direction = (int)direction;
+    } else {
+        // Count the leading ones of the prefix, at most 4
+        int ones = 0;
+        while (ones < 4) {
+            if (series_get_bits(decoder, 1, &value) != 0) return -1;
+            if (value == 0) break;
+            ones++;
+        }
+        int64_t dod = 0;
+        if (ones > 0) {
+            if (series_get_bits(decoder, series_dod_bits[ones - 1], &value) != 0) return -1;
+            dod = series_unzigzag(value);
+        }
+        decoder->last_delta += dod;
+        next.time_ms += decoder->last_delta;
+
+        for (int field = 0; field < SERIES_FIELD_COUNT; field++) {
+            if (series_get_bits(decoder, 1, &value) != 0) return -1;
+            if (value == 0) continue;
+            if (series_get_bits(decoder, 1, &value) != 0) return -1;
+            if (value == 0) {
+                if (series_get_bits(decoder, 4, &value) != 0) return -1;
+                series_set_field(&next, field, series_field(&next, field) + (int)series_unzigzag(value));
+            } else {
+                if (series_get_bits(decoder, 16, &value) != 0) return -1;
+                series_set_field(&next, field, (int)series_signed(value, 16));
+            }
+        }
+    }
+
+    decoder->last = next;
+    decoder->remaining--;
+    *sample = next;
+    return 1;
+}
@@ -0,0 +1,61 @@
+#ifndef SERIES_CODEC_H
+#define SERIES_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Gorilla-style compression of telemetry samples into a bit stream, MSB
+// first. A block starts with one sample in full:
+//
+//   <i64 time ms> <i16 speed> <u8 battery> <i8 temperature> <u8 direction>
+//
+// and every later sample stores its timestamp as the change in the interval
+// between samples (delta of delta) and each field as the change from the
+// previous sample:
+//
+//   delta of delta   '0' = 0, '10' + 7 bits, '110' + 9 bits, '1110' + 12 bits,
+//                    '1111' + 32 bits (zigzag)
+//   field            '0' = unchanged, '10' + 4 bits (zigzag delta),
+//                    '11' + 16 bits (the value itself)
+//
+// Samples taken at a fixed step with nothing changing cost 5 bits.
+
+#define SERIES_SAMPLE_MAX_BITS 108      // worst case of one sample
+#define SERIES_FIELD_COUNT 4
+
+typedef struct {
+    int64_t time_ms;        // Unix milliseconds
+    int speed;
+    int battery;
+    int temperature;
+    int direction;          // vehicle_direction_t
+} series_sample_t;
+
+// Appends to a zeroed buffer
+typedef struct {
+    unsigned char* data;
+    size_t capacity_bits;
+    size_t bits;            // written so far
+    uint32_t count;         // samples
+    series_sample_t last;
+    int64_t last_delta;
+} series_encoder_t;
+
+typedef struct {
+    const unsigned char* data;
+    size_t bits;            // valid bits in data
+    size_t position;
+    uint32_t remaining;     // samples left to decode
+    series_sample_t last;
+    int64_t last_delta;
+} series_decoder_t;
+
+// Encoding functions
+void series_encoder_init(series_encoder_t* encoder, unsigned char* data, size_t capacity);
+int series_encoder_append(series_encoder_t* encoder, const series_sample_t* sample);
+
+// Decoding functions
+void series_decoder_init(series_decoder_t* decoder, const unsigned char* data, size_t bits, uint32_t count);
+int series_decoder_next(series_decoder_t* decoder, series_sample_t* sample);
+
+#endif // SERIES_CODEC_H
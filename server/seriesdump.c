@@ -0,0 +1,104 @@
+/*
+ * Telemetry store reader
+ * Prints the samples a server started with --store <dir> recorded in a time
+ * range, one line each, or their per-step averages when a step is given.
+ *
+ * Compilation: make seriesdump
+ * Usage: ./seriesdump <dir> [from] [to] [step_ms]
+ *        from and to are Unix seconds, or seconds ago when <= 0
+ *        (default: everything stored)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "series.h"
+#include "vehicle.h"
+
+// Samples averaged into one output line
+typedef struct {
+    int64_t step_ms;
+    int64_t start_ms;
+    long speed, battery, temperature;
+    int direction;
+    long count;
+    unsigned long long samples;
+    unsigned long long lines;
+} dump_state_t;
+
+static int64_t parse_time(const char* text, int64_t now_ms) {
+    long long seconds = strtoll(text, NULL, 10);
+    return seconds <= 0 ? now_ms + seconds * 1000 : seconds * 1000;
+}
+
+static void print_line(dump_state_t* state, int64_t time_ms, long speed, long battery, long temperature,
+                       int direction) {
+    char stamp[32];
+    time_t seconds = (time_t)(time_ms / 1000);
+    struct tm tm_info;
+
+    localtime_r(&seconds, &tm_info);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+    printf("%s.%03d %3ld km/h %3ld%% %3ld C %s\n", stamp, (int)(time_ms % 1000), speed, battery, temperature,
+           vehicle_direction_to_string((vehicle_direction_t)direction));
+    state->lines++;
+}
+
+static void flush_bucket(dump_state_t* state) {
+    if (state->count == 0) return;
+
+    // Rounded like history_aggregate: half away from zero, for negative temperatures too
+    long count = state->count;
+    long temperature = state->temperature >= 0 ? (state->temperature + count / 2) / count
+                                               : (state->temperature - count / 2) / count;
+    print_line(state, state->start_ms, (state->speed + count / 2) / count, (state->battery + count / 2) / count,
+               temperature, state->direction);
+    state->speed = state->battery = state->temperature = 0;
+    state->count = 0;
+}
+
+static int visit_sample(const series_sample_t* sample, void* context) {
+    dump_state_t* state = (dump_state_t*)context;
+    state->samples++;
+
+    if (state->step_ms <= 0) {
+        print_line(state, sample->time_ms, sample->speed, sample->battery, sample->temperature, sample->direction);
+        return 0;
+    }
+
+    if (state->count > 0 && sample->time_ms >= state->start_ms + state->step_ms) flush_bucket(state);
+    if (state->count == 0) state->start_ms = sample->time_ms - sample->time_ms % state->step_ms;
+    state->speed += sample->speed;
+    state->battery += sample->battery;
+    state->temperature += sample->temperature;
+    state->direction = sample->direction;
+    state->count++;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <dir> [from] [to] [step_ms]\n", argv[0]);
+        return 1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    int64_t now_ms = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    int64_t from_ms = argc > 2 ? parse_time(argv[2], now_ms) : INT64_MIN;
+    int64_t to_ms = argc > 3 ? parse_time(argv[3], now_ms) : INT64_MAX;
+
+    dump_state_t state = {0};
+    state.step_ms = argc > 4 ? atoll(argv[4]) : 0;
+
+    int segments_read = 0;
+    int segments = series_query(argv[1], from_ms, to_ms, visit_sample, &state, &segments_read);
+    if (segments < 0) return 1;
+    flush_bucket(&state);
+
+    fprintf(stderr, "%llu samples, %llu lines, %d of %d segments read\n", state.samples, state.lines,
+            segments_read, segments);
+    return 0;
+}
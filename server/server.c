@@ -4,61 +4,513 @@
  * Modular architecture with separation of responsibilities
  * 
  * Compilation: make
- * Usage: ./server <port> <LogsFile>
+ * Usage: ./server <port> <LogsFile> [--epoll] [--reactors <N|auto>] [--pin]
+ *        [--log-policy <block|drop|sample>] [--log-flush-ms <N>] [--log-format <text|binary>]
+ *        [--max-queue-bytes <N>] [--max-queue-msgs <N>] [--no-conflate] [--evict-after-ms <N>]
+ *        [--vehicles <N>] [--sim-step-ms <N>] [--max-clients <N>] [--history-seconds <N>]
+ *        [--multicast <addr:port>] [--multicast-if <ip>] [--multicast-hz <N>]
+ *        [--shm <name>] [--shm-hz <N>]
+ *        [--store <dir>] [--store-segment-mb <N>] [--store-segment-minutes <N>]
+ *        [--snapshot <path>] [--snapshot-interval <N>] [--session-ttl <N>]
+ *        [--upgrade-socket <path>] [--takeover <path>]
  */
 
+#define _GNU_SOURCE // pthread_setaffinity_np
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <signal.h>
 #include <pthread.h>
+#include <sched.h>
 #include <time.h>
+#include <errno.h>
+#include <poll.h>
 #include <arpa/inet.h>
 
 // System modules
 #include "socket_manager.h"
-#include "vehicle.h"
+#include "fleet.h"
+#include "physics.h"
 #include "client_protocol.h"
+#include "reactor.h"
+#include "multicast.h"
+#include "shm_feed.h"
+#include "series.h"
+#include "snapshot.h"
+#include "upgrade.h"
+
+#define MEMORY_REPORT_SECONDS 30
+
+// What a thread-per-client thread is started with
+typedef struct {
+    client_handle_t handle;
+    int socket;         // owned by the thread, also after its slot is freed
+    char ip[INET_ADDRSTRLEN];   // for its logs, since the slot's copy goes with the slot
+    int port;
+} client_thread_arg_t;
 
 // Global variables for signal handling
 static int running = 1;
-static socket_manager_t socket_mgr;
-static client_manager_t client_mgr;
-static vehicle_state_t vehicle;
+static int reactor_count = 0;           // 0 = thread-per-client
+static int pin_reactors = 0;
+static int shard_count = 1;
+static socket_manager_t* socket_shards; // one listener per reactor
+static client_manager_t* client_shards; // one registry slice per reactor
+static reactor_t* reactors;
+static int reactors_ready = 0;          // reactors whose init succeeded, the only ones to stop or clean up
+static socket_manager_t* socket_mgr;    // shard 0, used by thread-per-client mode
+static client_manager_t* client_mgr;
+static fleet_t fleet;
+static int fleet_size = FLEET_DEFAULT_VEHICLES;
+static int sim_step_ms = FLEET_DEFAULT_STEP_MS;
+static int max_clients = MAX_CLIENTS;
+static int history_seconds = HISTORY_DEFAULT_SECONDS;
+static history_t history;
+static const char* multicast_target;    // NULL = no UDP telemetry
+static const char* multicast_interface;
+static int multicast_hz = SUBSCRIBE_BROADCAST_GROUP;
+static multicast_publisher_t multicast;
+static const char* shm_name;            // NULL = no shared-memory feed
+static int shm_hz = SUBSCRIBE_MAX_HZ;
+static shm_feed_t shm_feed;
+static const char* store_directory;     // NULL = no durable store
+static int store_segment_mb = SERIES_DEFAULT_SEGMENT_MB;
+static int store_segment_minutes = SERIES_DEFAULT_SEGMENT_MINUTES;
+static series_store_t store;
+static const char* snapshot_path;       // NULL = no snapshots
+static int snapshot_interval = SNAPSHOT_DEFAULT_INTERVAL;
+static snapshot_writer_t snapshot_writer;
+static int session_ttl = TOKEN_DEFAULT_TTL_SECONDS;
+static token_table_t tokens;
+static const char* upgrade_path;        // NULL = no hot upgrade
+static const char* takeover_path;       // set in a new binary taking over
+static upgrade_t upgrade;
 static logger_t logger;
+static log_overflow_policy_t log_policy = LOG_OVERFLOW_BLOCK;
+static int log_flush_ms = LOG_FLUSH_INTERVAL_MS;
+static log_format_t log_format = LOG_FORMAT_TEXT;
+static outbound_limits_t outbound_limits;
 
 // Function prototypes
 void* handle_client(void* arg);
 void* telemetry_thread(void* arg);
 void* cleanup_thread(void* arg);
+void* reactor_thread(void* arg);
 void signal_handler(int sig);
+void upgrade_signal_handler(int sig);
+static void stop_serving(void);
+static void hand_over_listeners(void);
 void cleanup_resources(void);
+void print_usage(const char* program);
+static size_t connection_memory_bytes(int* connected);
 
 // Main function
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        printf("Usage: %s <port> <LogsFile>\n", argv[0]);
+    if (argc < 3) {
+        print_usage(argv[0]);
         exit(1);
     }
 
     int port = atoi(argv[1]);
     char* log_filename = argv[2];
+    outbound_limits = *outbound_get_limits();
+
+    // Optional flags
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--epoll") == 0) {
+            if (reactor_count == 0) reactor_count = 1;
+        } else if (strcmp(argv[i], "--reactors") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "auto") == 0) {
+                reactor_count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+            } else {
+                reactor_count = atoi(argv[i]);
+            }
+            if (reactor_count <= 0) {
+                printf("Invalid reactor count: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            pin_reactors = 1;
+        } else if (strcmp(argv[i], "--log-policy") == 0 && i + 1 < argc) {
+            i++;
+            if (logger_parse_policy(argv[i], &log_policy) != 0) {
+                printf("Invalid log policy: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--log-format") == 0 && i + 1 < argc) {
+            i++;
+            if (logger_parse_format(argv[i], &log_format) != 0) {
+                printf("Invalid log format: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--log-flush-ms") == 0 && i + 1 < argc) {
+            i++;
+            log_flush_ms = atoi(argv[i]);
+            if (log_flush_ms < 0) {
+                printf("Invalid log flush interval: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--max-queue-bytes") == 0 && i + 1 < argc) {
+            i++;
+            long max_bytes = atol(argv[i]);
+            if (max_bytes <= 0) {
+                printf("Invalid queue byte limit: %s\n", argv[i]);
+                exit(1);
+            }
+            outbound_limits.max_bytes = (size_t)max_bytes;
+        } else if (strcmp(argv[i], "--max-queue-msgs") == 0 && i + 1 < argc) {
+            i++;
+            outbound_limits.max_messages = atoi(argv[i]);
+            if (outbound_limits.max_messages <= 0 || outbound_limits.max_messages > OUTBOUND_QUEUE_MAX) {
+                printf("Invalid queue message limit: %s (1 to %d)\n", argv[i], OUTBOUND_QUEUE_MAX);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--no-conflate") == 0) {
+            outbound_limits.conflate = 0;
+        } else if (strcmp(argv[i], "--evict-after-ms") == 0 && i + 1 < argc) {
+            i++;
+            outbound_limits.evict_after_ms = atoi(argv[i]);
+            if (outbound_limits.evict_after_ms < 0) {
+                printf("Invalid eviction deadline: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--vehicles") == 0 && i + 1 < argc) {
+            i++;
+            fleet_size = atoi(argv[i]);
+            if (fleet_size <= 0 || fleet_size > FLEET_MAX_VEHICLES) {
+                printf("Invalid fleet size: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--sim-step-ms") == 0 && i + 1 < argc) {
+            i++;
+            sim_step_ms = atoi(argv[i]);
+            if (sim_step_ms <= 0 || sim_step_ms > FLEET_MAX_STEP_MS) {
+                printf("Invalid simulation step: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--history-seconds") == 0 && i + 1 < argc) {
+            i++;
+            history_seconds = atoi(argv[i]);
+            if (history_seconds < 0 || history_seconds > HISTORY_MAX_SECONDS) {
+                printf("Invalid history length: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--max-clients") == 0 && i + 1 < argc) {
+            i++;
+            max_clients = atoi(argv[i]);
+            if (max_clients < 1 || max_clients > CLIENT_MAX_CAPACITY) {
+                printf("Invalid client capacity: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--multicast") == 0 && i + 1 < argc) {
+            multicast_target = argv[++i];
+        } else if (strcmp(argv[i], "--multicast-if") == 0 && i + 1 < argc) {
+            multicast_interface = argv[++i];
+        } else if (strcmp(argv[i], "--multicast-hz") == 0 && i + 1 < argc) {
+            i++;
+            if (subscription_parse_rate(argv[i], &multicast_hz) != 0) {
+                printf("Invalid multicast rate: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--shm") == 0 && i + 1 < argc) {
+            shm_name = argv[++i];
+        } else if (strcmp(argv[i], "--shm-hz") == 0 && i + 1 < argc) {
+            i++;
+            if (subscription_parse_rate(argv[i], &shm_hz) != 0) {
+                printf("Invalid shared memory feed rate: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--store") == 0 && i + 1 < argc) {
+            store_directory = argv[++i];
+        } else if (strcmp(argv[i], "--store-segment-mb") == 0 && i + 1 < argc) {
+            i++;
+            store_segment_mb = atoi(argv[i]);
+            if (store_segment_mb < 1 || store_segment_mb > SERIES_MAX_SEGMENT_MB) {
+                printf("Invalid segment size: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--store-segment-minutes") == 0 && i + 1 < argc) {
+            i++;
+            store_segment_minutes = atoi(argv[i]);
+            if (store_segment_minutes < 1) {
+                printf("Invalid segment span: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshot_path = argv[++i];
+        } else if (strcmp(argv[i], "--snapshot-interval") == 0 && i + 1 < argc) {
+            i++;
+            snapshot_interval = atoi(argv[i]);
+            if (snapshot_interval < 1) {
+                printf("Invalid snapshot interval: %s\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--upgrade-socket") == 0 && i + 1 < argc) {
+            upgrade_path = argv[++i];
+        } else if (strcmp(argv[i], "--takeover") == 0 && i + 1 < argc) {
+            takeover_path = argv[++i];
+        } else if (strcmp(argv[i], "--session-ttl") == 0 && i + 1 < argc) {
+            i++;
+            session_ttl = atoi(argv[i]);
+            if (session_ttl < 0) {
+                printf("Invalid session lifetime: %s\n", argv[i]);
+                exit(1);
+            }
+        } else {
+            printf("Unknown option: %s\n", argv[i]);
+            print_usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (store_directory && history_seconds == 0) {
+        printf("--store records from the history ring; it needs --history-seconds > 0\n");
+        exit(1);
+    }
+    shard_count = reactor_count > 0 ? reactor_count : 1;
+    multicast.socket = -1;
+    upgrade.listen_fd = -1;
+    upgrade.peer_fd = -1;
+    outbound_configure(&outbound_limits);
 
     // Configure signal handler
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGPIPE, SIG_IGN); // Peer resets surface as EPIPE instead of killing the server
+    if (upgrade_path) {
+        signal(SIGUSR2, upgrade_signal_handler);
+    }
+
+    // Initialize modules, one listener and registry slice per shard
+    socket_shards = calloc((size_t)shard_count, sizeof(socket_manager_t));
+    client_shards = calloc((size_t)shard_count, sizeof(client_manager_t));
+    if (!socket_shards || !client_shards) {
+        fprintf(stderr, "Error allocating shards\n");
+        exit(1);
+    }
+    socket_mgr = &socket_shards[0];
+    client_mgr = &client_shards[0];
+
+    // Hot upgrade: the running server's listeners instead of new ones, so
+    // connections keep queueing on them while this process starts
+    int takeover_fd = -1;
+    if (takeover_path) {
+        int* listeners = calloc((size_t)shard_count, sizeof(int));
+        takeover_fd = listeners ? upgrade_takeover(takeover_path, shard_count, listeners) : -1;
+        if (takeover_fd < 0) exit(1);
+        for (int i = 0; i < shard_count; i++) {
+            if (socket_manager_adopt(&socket_shards[i], listeners[i]) != 0) {
+                fprintf(stderr, "Error adopting listener %d from %s\n", i, takeover_path);
+                for (int j = 0; j < shard_count; j++) close(listeners[j]);
+                close(takeover_fd);
+                free(listeners);
+                exit(1);
+            }
+        }
+        free(listeners);
+        port = socket_mgr->port;
+    }
+
+    for (int i = 0; !takeover_path && i < shard_count; i++) {
+        socket_shards[i].server_socket = -1;
+        int result = shard_count > 1 ? socket_manager_init_reuseport(&socket_shards[i], port)
+                                     : socket_manager_init(&socket_shards[i], port);
+        if (result != 0) {
+            fprintf(stderr, "Error initializing socket manager\n");
+            exit(1);
+        }
+    }
+
+    // Every connection needs a descriptor, and the fd table is sized from the limit
+    int fd_limit = socket_raise_fd_limit(max_clients);
+    if (fd_limit >= 0 && fd_limit < max_clients + SOCKET_RESERVED_FDS) {
+        fprintf(stderr, "Warning: descriptor limit %d is too low for %d clients\n", fd_limit, max_clients);
+    }
+    
+    // The capacity is split evenly between the shards
+    int shard_capacity = (max_clients + shard_count - 1) / shard_count;
+    if (client_protocol_init(client_mgr, shard_capacity, &logger, log_filename) != 0) {
+        fprintf(stderr, "Error initializing client registry\n");
+        exit(1);
+    }
+    logger_configure(&logger, log_policy, log_flush_ms);
+    logger_set_format(&logger, log_format);
+    for (int i = 1; i < shard_count; i++) {
+        if (client_manager_init(&client_shards[i], shard_capacity) != 0) {
+            fprintf(stderr, "Error initializing client registry\n");
+            exit(1);
+        }
+    }
+    client_manager_link_shards(client_shards, shard_count);
+    if (fleet_init(&fleet, fleet_size) != 0) {
+        fprintf(stderr, "Error initializing fleet\n");
+        cleanup_resources();
+        exit(1);
+    }
+
+    // Session tokens, so clients can reconnect without their password
+    if (session_ttl > 0) {
+        if (token_table_init(&tokens, max_clients, session_ttl) != 0) {
+            cleanup_resources();
+            exit(1);
+        }
+        for (int i = 0; i < shard_count; i++) {
+            client_shards[i].tokens = &tokens;
+        }
+    }
+
+    // Warm restart: the fleet and sessions as of the last snapshot, or as
+    // the process taken over left them
+    snapshot_info_t restored;
+    int snapshot_result = 1;
+    if (takeover_fd >= 0) {
+        snapshot_result = upgrade_receive_state(takeover_fd, takeover_path, &fleet, tokens.entries ? &tokens : NULL,
+                                                &restored);
+    } else if (snapshot_path) {
+        snapshot_result = snapshot_load(snapshot_path, &fleet, tokens.entries ? &tokens : NULL, &restored);
+    }
 
-    // Initialize modules
-    if (socket_manager_init(&socket_mgr, port) != 0) {
-        fprintf(stderr, "Error initializing socket manager\n");
+    // GET_HISTORY ring, filled by the simulation thread from its first step
+    if (history_seconds > 0) {
+        if (history_init(&history, history_seconds, sim_step_ms) != 0) {
+            cleanup_resources();
+            exit(1);
+        }
+        fleet.history = &history;
+    }
+    if (fleet_start_simulation(&fleet, sim_step_ms) != 0) {
+        fprintf(stderr, "Error initializing fleet\n");
+        cleanup_resources();
         exit(1);
     }
 
-    client_protocol_init(&client_mgr, &logger, log_filename);
-    vehicle_init(&vehicle);
+    // Optional UDP telemetry; its rate group ticks like one more subscriber
+    if (multicast_target) {
+        struct sockaddr_in destination;
+        if (multicast_parse_address(multicast_target, &destination) != 0) {
+            fprintf(stderr, "Invalid multicast address: %s (expected <ipv4>:<port>)\n", multicast_target);
+            cleanup_resources();
+            exit(1);
+        }
+        if (multicast_publisher_init(&multicast, &destination, multicast_interface, MULTICAST_DEFAULT_TTL) != 0) {
+            cleanup_resources();
+            exit(1);
+        }
+        subscription_move(SUBSCRIBE_BROADCAST_GROUP, multicast_hz);
+    }
 
-    printf("Server started on port %d\n", port);
+    // Optional feed for consumers on this host, read straight from memory
+    if (shm_name) {
+        if (shm_feed_create(&shm_feed, shm_name, SHM_FEED_DEFAULT_SLOTS) != 0) {
+            cleanup_resources();
+            exit(1);
+        }
+        subscription_move(SUBSCRIBE_BROADCAST_GROUP, shm_hz);
+    }
+
+    if (snapshot_path && snapshot_writer_start(&snapshot_writer, snapshot_path, snapshot_interval, &fleet,
+                                               tokens.entries ? &tokens : NULL) != 0) {
+        cleanup_resources();
+        exit(1);
+    }
+
+    // Optional durable store, fed from the history ring by its own thread
+    if (store_directory) {
+        if (series_store_open(&store, store_directory, store_segment_mb, store_segment_minutes) != 0 ||
+            series_store_start(&store, &history) != 0) {
+            cleanup_resources();
+            exit(1);
+        }
+    }
+
+    if (reactor_count > 0) {
+        reactors = calloc((size_t)reactor_count, sizeof(reactor_t));
+        long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+        for (int i = 0; i < reactor_count; i++) {
+            if (!reactors || reactor_init(&reactors[i], &socket_shards[i], &client_shards[i], &fleet, &logger) != 0) {
+                fprintf(stderr, "Error initializing event loop\n");
+                cleanup_resources();
+                exit(1);
+            }
+            reactors_ready = i + 1;
+            if (pin_reactors && cpu_count > 0) {
+                reactors[i].cpu = (int)(i % cpu_count);
+            }
+        }
+    }
+
+    if (reactor_count > 0) {
+        printf("Server started on port %d (epoll mode, %d reactor%s%s)\n", port, reactor_count,
+               reactor_count > 1 ? "s" : "", pin_reactors ? ", pinned" : "");
+    } else {
+        printf("Server started on port %d (thread-per-client mode)\n", port);
+    }
+    printf("Fleet: %d vehicle%s, %zu KB, %s physics every %d ms\n", fleet.count, fleet.count > 1 ? "s" : "",
+           fleet_memory_bytes(&fleet) / 1024, physics_isa_name(physics_active_isa()), fleet.step_ms);
+    if (fleet.history) {
+        printf("History: last %d s of vehicle %d, %u steps, %zu KB\n", history_seconds, FLEET_STREAM_VEHICLE,
+               history.capacity, history_memory_bytes(&history) / 1024);
+    }
+    size_t per_client = client_mgr->client_slab.object_size + client_mgr->info_slab.object_size;
+    if (reactors) per_client += reactors[0].session_slab.object_size;
+    size_t registry_bytes = 0;
+    for (int i = 0; i < shard_count; i++) {
+        registry_bytes += client_manager_memory_bytes(&client_shards[i]);
+    }
+    printf("Clients: up to %d, %zu KB of tables, %zu bytes per idle connection%s\n", max_clients,
+           registry_bytes / 1024, per_client, reactors ? "" : " plus its thread");
+    if (multicast.socket >= 0) {
+        if (multicast_hz > 0) {
+            printf("Multicast telemetry: %s at %d Hz\n", multicast_target, multicast_hz);
+        } else {
+            printf("Multicast telemetry: %s every %d s\n", multicast_target, TELEMETRY_INTERVAL);
+        }
+    }
+    if (shm_feed.header) {
+        if (shm_hz > 0) {
+            printf("Shared memory feed: /dev/shm%s, %u frames at %d Hz\n", shm_feed.name,
+                   shm_feed.header->capacity, shm_hz);
+        } else {
+            printf("Shared memory feed: /dev/shm%s, %u frames every %d s\n", shm_feed.name,
+                   shm_feed.header->capacity, TELEMETRY_INTERVAL);
+        }
+    }
+    if (store.running) {
+        printf("Telemetry store: %s, segments of %d MB or %d min\n", store.directory, store_segment_mb,
+               store_segment_minutes);
+    }
+    if (takeover_path) {
+        printf("Upgrade: took over %d listener%s from %s", shard_count, shard_count > 1 ? "s" : "", takeover_path);
+        if (snapshot_result == 0) {
+            printf(", restored %d vehicle%s and %d session%s in %.1f ms", restored.vehicles,
+                   restored.vehicles == 1 ? "" : "s", restored.tokens, restored.tokens == 1 ? "" : "s",
+                   restored.elapsed_ms);
+        }
+        printf("\n");
+    }
+    if (snapshot_path && !takeover_path) {
+        if (snapshot_result == 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_REALTIME, &now);
+            long long age_ms = (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000 - restored.saved_ms;
+            printf("Snapshot: restored %d vehicles and %d session%s from %s in %.1f ms (saved %lld s ago)\n",
+                   restored.vehicles, restored.tokens, restored.tokens == 1 ? "" : "s", snapshot_path,
+                   restored.elapsed_ms, age_ms / 1000);
+        } else {
+            printf("Snapshot: starting fresh, saving to %s\n", snapshot_path);
+        }
+    }
+    if (snapshot_path) {
+        printf("Snapshot: every %d s and at shutdown\n", snapshot_interval);
+    }
+    if (upgrade_path) {
+        if (upgrade_listen(&upgrade, upgrade_path, shard_count, argc, argv, stop_serving) != 0) {
+            cleanup_resources();
+            exit(1);
+        }
+        printf("Upgrade: socket %s, SIGUSR2 starts %s in this process's place\n", upgrade_path, argv[0]);
+    }
     printf("Log file: %s\n", log_filename);
     logger_log(&logger, LOG_SERVER_START, "0.0.0.0", port, "Server started");
 
@@ -78,20 +530,46 @@ int main(int argc, char* argv[]) {
         exit(1);
     }
 
-    // Main loop - accept connections
-    while (running) {
-        struct sockaddr_in client_addr;
-        int client_socket = socket_manager_accept_client(&socket_mgr, &client_addr);
-        
-        if (client_socket < 0) {
-            if (running) {
-                perror("Error accepting connection");
+    // Event loop mode: one thread per reactor, shard 0 runs on the main thread
+    if (reactor_count > 0) {
+        pthread_t* reactor_tids = calloc((size_t)reactor_count, sizeof(pthread_t));
+        int started = 1;
+        for (int i = 1; reactor_tids && i < reactor_count; i++, started++) {
+            if (pthread_create(&reactor_tids[i], NULL, reactor_thread, &reactors[i]) != 0) {
+                perror("Error creating reactor thread");
+                break;
             }
-            continue;
         }
+        reactor_thread(&reactors[0]);
+
+        // One reactor stopping (signal or upgrade) stops them all
+        for (int i = 1; i < started; i++) {
+            reactor_stop(&reactors[i]);
+            pthread_join(reactor_tids[i], NULL);
+        }
+        free(reactor_tids);
+
+        hand_over_listeners();
+        cleanup_resources();
+        printf("Server closed\n");
+        return 0;
+    }
+
+    // Main loop - accept connections. Waiting in poll rather than accept
+    // lets it stop without closing the listener, whose queued connections
+    // may be another process's by then (upgrade.c). Non-blocking, since that
+    // process can take a connection poll reported.
+    socket_set_nonblocking(socket_mgr->server_socket);
+    while (running) {
+        struct pollfd pfd = {socket_mgr->server_socket, POLLIN, 0};
+        if (poll(&pfd, 1, CLIENT_POLL_INTERVAL_MS) <= 0 || !running) continue;
+
+        struct sockaddr_in client_addr;
+        int client_socket = socket_manager_accept_client(socket_mgr, &client_addr);
+        if (client_socket < 0) continue;
 
         // Check if there is space for more clients
-        if (client_mgr.client_count >= MAX_CLIENTS) {
+        if (client_mgr->client_count >= client_mgr->capacity) {
             socket_close_connection(client_socket);
             logger_log(&logger, LOG_CONNECTION_REJECTED, 
                       inet_ntoa(client_addr.sin_addr), 
@@ -101,11 +579,11 @@ int main(int argc, char* argv[]) {
         }
 
         // Add new client
-        int client_index = client_manager_add_client(&client_mgr, client_socket, 
-                                                   inet_ntoa(client_addr.sin_addr), 
-                                                   ntohs(client_addr.sin_port));
+        client_handle_t handle = client_manager_add_client(client_mgr, client_socket, 
+                                                           inet_ntoa(client_addr.sin_addr), 
+                                                           ntohs(client_addr.sin_port));
         
-        if (client_index == -1) {
+        if (handle == CLIENT_HANDLE_INVALID) {
             socket_close_connection(client_socket);
             logger_log(&logger, LOG_CONNECTION_REJECTED, 
                       inet_ntoa(client_addr.sin_addr), 
@@ -119,17 +597,29 @@ int main(int argc, char* argv[]) {
                   ntohs(client_addr.sin_port), 
                   "Client connected");
 
-        // Create thread to handle client
+        // Create thread to handle client; it gets a handle, not the slot,
+        // because the slot is reused once the client is removed
         pthread_t client_tid;
-        if (pthread_create(&client_tid, NULL, handle_client, &client_mgr.clients[client_index]) != 0) {
+        client_thread_arg_t* thread_arg = malloc(sizeof(client_thread_arg_t));
+        if (thread_arg) {
+            thread_arg->handle = handle;
+            thread_arg->socket = client_socket;
+            strncpy(thread_arg->ip, inet_ntoa(client_addr.sin_addr), INET_ADDRSTRLEN - 1);
+            thread_arg->ip[INET_ADDRSTRLEN - 1] = '\0';
+            thread_arg->port = ntohs(client_addr.sin_port);
+        }
+        if (!thread_arg || pthread_create(&client_tid, NULL, handle_client, thread_arg) != 0) {
             perror("Error creating thread for client");
-            client_manager_remove_client(&client_mgr, client_index);
-            socket_close_connection(client_socket);
+            free(thread_arg);
+            if (client_manager_remove_client(client_mgr, handle) != 0) {
+                socket_close_connection(client_socket);
+            }
         } else {
             pthread_detach(client_tid);
         }
     }
 
+    hand_over_listeners();
     cleanup_resources();
     printf("Server closed\n");
     return 0;
@@ -137,99 +627,366 @@ int main(int argc, char* argv[]) {
 
 // Thread to handle a specific client
 void* handle_client(void* arg) {
-    client_t* client = (client_t*)arg;
+    client_thread_arg_t thread_arg = *(client_thread_arg_t*)arg;
+    free(arg);
+    int socket = thread_arg.socket;
+    client_t* client;
     char buffer[BUFFER_SIZE];
     int bytes_received;
-    parsed_command_t parsed_cmd;
+    stream_input_t input;
+    stream_output_t output;
+    stream_input_init(&input);
+    stream_output_init(&output);
+
+    // All output goes through the client's outbound queue, so responses and
+    // telemetry frames never interleave and no send blocks this thread. The
+    // handle goes stale if the idle cleanup frees the slot, and the next
+    // accept may reuse that slot, so the client is resolved again after
+    // every wait and the sends check the handle under the registry lock.
+    while (running && (client = client_manager_resolve(client_mgr, thread_arg.handle)) != NULL) {
+        struct pollfd pfd = {socket, POLLIN, 0};
+        if (outbound_queue_pending(&client->outbound)) {
+            pfd.events |= POLLOUT;
+        }
+
+        int ready = poll(&pfd, 1, CLIENT_POLL_INTERVAL_MS);
+        if ((client = client_manager_resolve(client_mgr, thread_arg.handle)) == NULL) break;
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            logger_log(&logger, LOG_ERROR, thread_arg.ip, thread_arg.port, "Error polling socket");
+            break;
+        }
 
-    while (running && client->socket != -1) {
-        bytes_received = socket_receive_data(client->socket, buffer, sizeof(buffer));
+        // Slow consumer: over its outbound limit for too long
+        if (outbound_queue_expired(&client->outbound, outbound_now_ms())) {
+            outbound_count(OUTBOUND_EVENT_EVICTED);
+            logger_log(&logger, LOG_DISCONNECT, thread_arg.ip, thread_arg.port, "Evicted: outbound queue over limit");
+            break;
+        }
+        if (ready == 0) continue;
+
+        if ((pfd.revents & POLLOUT) && outbound_queue_flush(&client->outbound) < 0) {
+            logger_log(&logger, LOG_ERROR, thread_arg.ip, thread_arg.port, "Error sending data");
+            break;
+        }
+        if (!(pfd.revents & (POLLIN | POLLHUP | POLLERR))) continue;
+
+        bytes_received = socket_receive_data(socket, buffer, sizeof(buffer));
         
         if (bytes_received <= 0) {
             if (bytes_received == 0) {
-                logger_log(&logger, LOG_DISCONNECT, client->ip, client->port, "Client disconnected");
+                logger_log(&logger, LOG_DISCONNECT, thread_arg.ip, thread_arg.port, "Client disconnected");
             } else {
-                logger_log(&logger, LOG_ERROR, client->ip, client->port, "Error receiving data");
+                logger_log(&logger, LOG_ERROR, thread_arg.ip, thread_arg.port, "Error receiving data");
             }
             break;
         }
 
-        // Update client activity
-        int client_index = client_manager_find_by_socket(&client_mgr, client->socket);
-        if (client_index != -1) {
-            client_manager_update_activity(&client_mgr, client_index);
+        // Process every complete command; a partial one waits for the next read.
+        // The client closes after DISCONNECT, so later commands are still served.
+        size_t offset = 0;
+        int result = 0;
+        output.length = 0;
+        while (offset < (size_t)bytes_received && result >= 0) {
+            size_t taken = stream_input_append(&input, buffer + offset, (size_t)bytes_received - offset);
+            offset += taken;
+            result = protocol_handle_stream(&input, &output, socket, thread_arg.ip, thread_arg.port,
+                                            client_mgr, &fleet, &logger);
+            if (taken == 0) break;
         }
 
-        // Log received command
-        logger_log(&logger, LOG_COMMAND, client->ip, client->port, buffer);
+        // All responses to this read go out in one write; a protocol switch or
+        // subscription changes the broadcasts together with it
+        int sent = 0;
+        if (result >= 0 && (input.protocol != client->protocol || input.telemetry_hz != client->telemetry_hz ||
+                            input.telemetry_delta != client->telemetry_delta)) {
+            sent = client_send_switch(client_mgr, thread_arg.handle, output.data ? output.data : "", output.length,
+                                      &input);
+        } else if (result >= 0 && output.length > 0) {
+            sent = client_send(client_mgr, thread_arg.handle, output.data, output.length);
+        }
+        if (result < 0 || sent < 0) {
+            logger_log(&logger, LOG_ERROR, thread_arg.ip, thread_arg.port, "Error sending response");
+            break;
+        }
+    }
+    stream_output_cleanup(&output);
+    subscription_move(input.telemetry_hz, 0);
 
-        // Process command
-        protocol_parse_command(buffer, &parsed_cmd);
-        protocol_handle_command(&parsed_cmd, client->socket, &client_mgr, &vehicle, &logger);
+    // Remove client from list; that closes the socket unless the slot was
+    // already freed, and then it is closed here
+    if (client_manager_remove_client(client_mgr, thread_arg.handle) != 0) {
+        socket_close_connection(socket);
     }
 
-    // Remove client from list
-    int client_index = client_manager_find_by_socket(&client_mgr, client->socket);
-    if (client_index != -1) {
-        client_manager_remove_client(&client_mgr, client_index);
+    return NULL;
+}
+
+// Thread running one event loop, optionally pinned to a CPU
+void* reactor_thread(void* arg) {
+    reactor_t* reactor = (reactor_t*)arg;
+
+    if (reactor->cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(reactor->cpu, &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+            fprintf(stderr, "Warning: could not pin reactor to CPU %d\n", reactor->cpu);
+        }
     }
 
-    socket_close_connection(client->socket);
+    reactor_run(reactor);
     return NULL;
 }
 
-// Thread to send automatic telemetry every 10 seconds
+// Fixed-width frame of the shared-memory feed
+static void shm_record_from_snapshot(const vehicle_snapshot_t* snapshot, time_t timestamp,
+                                     unsigned long long tick, shm_feed_record_t* record) {
+    memset(record, 0, sizeof(*record));
+    record->timestamp = (int64_t)timestamp;
+    record->step = snapshot->step;
+    record->tick = tick;
+    record->vehicle_id = (uint32_t)snapshot->id;
+    record->speed = (int16_t)snapshot->speed;
+    record->battery = (uint8_t)snapshot->battery;
+    record->temperature = (int8_t)snapshot->temperature;
+    record->direction = (uint8_t)snapshot->direction;
+}
+
+// Thread to send telemetry: every 10 seconds to all clients, and at each
+// subscriber's own rate. One timer tick serves every rate group due on it.
 void* telemetry_thread(void* arg) {
     (void)arg; // Avoid unused parameter warning
+    outbound_stats_t reported = {0, 0, 0};
+    subscription_scheduler_t scheduler;
+    telemetry_encoder_t encoder;
+
+    if (subscription_scheduler_init(&scheduler, TELEMETRY_INTERVAL) != 0 || telemetry_encoder_init(&encoder) != 0) {
+        fprintf(stderr, "Telemetry disabled: no timer\n");
+        return NULL;
+    }
+
     while (running) {
-        sleep(TELEMETRY_INTERVAL);
-        if (running) {
-            protocol_send_telemetry_to_all(&client_mgr, &vehicle, &logger);
+        subscription_mask_t mask;
+        int due = subscription_scheduler_wait(&scheduler, &mask);
+        if (due < 0) break;
+        if (due == 0 || !running) continue;
+
+        // Sample and format once per tick, for every due group and protocol
+        vehicle_snapshot_t snapshot;
+        time_t now = fleet_sample_telemetry(&fleet, FLEET_STREAM_VEHICLE, &snapshot);
+        if (telemetry_encode_tick(&encoder, &mask, scheduler.tick, &snapshot, now) != 0) continue;
+        
+        // Observers on UDP: one datagram however many of them listen
+        if (multicast.socket >= 0 && mask.due[multicast_hz]) {
+            unsigned char frame[WIRE_TELEMETRY_FRAME_SIZE];
+            wire_encode_telemetry(&snapshot, now, frame);
+            multicast_publish(&multicast, frame, sizeof(frame));
+        }
+
+        // Local consumers: a memory write, no matter how many map the feed
+        if (shm_feed.header && mask.due[shm_hz]) {
+            shm_feed_record_t record;
+            shm_record_from_snapshot(&snapshot, now, scheduler.tick, &record);
+            shm_feed_publish(&shm_feed, &record);
+        }
+
+        if (reactor_count > 0) {
+            // Sockets belong to the event loops; hand the record to each shard
+            for (int i = 0; i < reactor_count; i++) {
+                reactor_broadcast(&reactors[i], encoder.data, encoder.length);
+            }
+            if (mask.due[SUBSCRIBE_BROADCAST_GROUP]) {
+                logger_log_simple(&logger, LOG_DATA_SENT, "Telemetry sent to all clients");
+            }
+        } else {
+            protocol_send_telemetry_to_all(client_mgr, encoder.data, encoder.length, &logger);
+        }
+        if (!mask.due[SUBSCRIBE_BROADCAST_GROUP]) continue;
+
+        // Report slow-consumer policy activity since the last broadcast
+        outbound_stats_t stats;
+        outbound_get_stats(&stats);
+        if (stats.conflated != reported.conflated || stats.dropped != reported.dropped ||
+            stats.evicted != reported.evicted) {
+            char message[160];
+            snprintf(message, sizeof(message), "Backpressure: conflated=%lu dropped=%lu evicted=%lu",
+                     stats.conflated, stats.dropped, stats.evicted);
+            logger_log_simple(&logger, LOG_ERROR, message);
+            reported = stats;
         }
     }
+
+    telemetry_encoder_cleanup(&encoder);
+    subscription_scheduler_cleanup(&scheduler);
     return NULL;
 }
 
-// Thread to clean up inactive clients
+// Registry and session memory of every shard, including slots and sessions
+// kept for reuse after their clients left
+static size_t connection_memory_bytes(int* connected) {
+    size_t bytes = 0;
+    *connected = 0;
+    for (int i = 0; i < shard_count; i++) {
+        bytes += client_manager_memory_bytes(&client_shards[i]);
+        *connected += __atomic_load_n(&client_shards[i].client_count, __ATOMIC_RELAXED);
+    }
+    for (int i = 0; reactors && i < reactor_count; i++) {
+        bytes += slab_memory_bytes(&reactors[i].session_slab);
+    }
+    return bytes;
+}
+
+// Thread to disconnect inactive clients, once a second so timeouts are
+// precise to the second; also reports connection memory every
+// MEMORY_REPORT_SECONDS whenever the number of clients changed
 void* cleanup_thread(void* arg) {
     (void)arg; // Avoid unused parameter warning
+    int reported = 0;
+    unsigned long passes = 0;
     while (running) {
-        sleep(30); // Check every 30 seconds
+        sleep(1);
         
-        client_manager_cleanup_inactive(&client_mgr);
+        int expired = 0;
+        for (int i = 0; i < shard_count; i++) {
+            expired += client_manager_cleanup_inactive(&client_shards[i]);
+        }
+        if (expired > 0) {
+            char message[80];
+            snprintf(message, sizeof(message), "%d inactive client%s disconnected", expired, expired > 1 ? "s" : "");
+            logger_log_simple(&logger, LOG_TIMEOUT, message);
+        }
         
-        // Close inactive client sockets
-        for (int i = 0; i < MAX_CLIENTS; i++) {
-            if (client_mgr.clients[i].socket == -1) {
-                // Client already marked as inactive, close socket if necessary
-                // (this is handled in the main thread)
-            }
+        if (++passes % MEMORY_REPORT_SECONDS != 0) continue;
+        int connected;
+        size_t bytes = connection_memory_bytes(&connected);
+        if (connected != reported) {
+            printf("Clients: %d connected, %zu KB of registry and sessions (%zu bytes per connection)\n",
+                   connected, bytes / 1024, connected > 0 ? bytes / (size_t)connected : 0);
+            reported = connected;
         }
     }
     return NULL;
 }
 
+// Stop accepting and serving, but leave the listeners open
+static void stop_serving(void) {
+    running = 0;
+    for (int i = 0; i < reactors_ready; i++) {
+        reactor_stop(&reactors[i]);
+    }
+}
+
 // Signal handler for clean shutdown
 void signal_handler(int sig) {
     (void)sig; // Avoid unused parameter warning
     printf("\nClosing server...\n");
-    running = 0;
-    socket_manager_close(&socket_mgr);
+    stop_serving();
+}
+
+// SIGUSR2: start the new binary, which takes over through the upgrade socket
+void upgrade_signal_handler(int sig) {
+    (void)sig; // Avoid unused parameter warning
+    upgrade_request(&upgrade);
+}
+
+// After serving stopped: a new process taking over gets every listener
+static void hand_over_listeners(void) {
+    int* listeners = calloc((size_t)shard_count, sizeof(int));
+    if (!listeners) return;
+    for (int i = 0; i < shard_count; i++) {
+        listeners[i] = socket_shards[i].server_socket;
+    }
+    upgrade_send_listeners(&upgrade, listeners, shard_count);
+    free(listeners);
 }
 
 // Clean up resources on exit
 void cleanup_resources(void) {
     running = 0;
     
+    if (reactors) {
+        for (int i = 0; i < reactors_ready; i++) {
+            reactor_cleanup(&reactors[i]);
+        }
+    }
+    
     // Close all client sockets
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (client_mgr.clients[i].socket != -1) {
-            socket_close_connection(client_mgr.clients[i].socket);
+    for (int shard = 0; shard < shard_count; shard++) {
+        client_manager_t* mgr = &client_shards[shard];
+        for (int i = 0; i < mgr->high_water; i++) {
+            client_t* client = client_manager_get_client(mgr, i);
+            if (client && client->socket != -1) {
+                socket_close_connection(client->socket);
+            }
+        }
+        socket_manager_close(&socket_shards[shard]);
+        if (shard > 0) {
+            client_manager_cleanup(mgr);
         }
     }
     
     // Clean up modules
-    socket_manager_close(&socket_mgr);
-    client_protocol_cleanup(&client_mgr, &logger);
-    vehicle_cleanup(&vehicle);
+    multicast_publisher_cleanup(&multicast);
+    shm_feed_destroy(&shm_feed);
+    client_protocol_cleanup(client_mgr, &logger);
+    snapshot_writer_stop(&snapshot_writer);
+    series_store_close(&store);
+
+    // No client is left to change the fleet: hand it over, and with it the
+    // log, store and shared memory names the new process opens next
+    upgrade_send_state(&upgrade, &fleet, tokens.entries ? &tokens : NULL);
+    upgrade_close(&upgrade);
+    fleet_cleanup(&fleet);
+    history_cleanup(&history);
+    token_table_cleanup(&tokens);
+}
+
+void print_usage(const char* program) {
+    printf("Usage: %s <port> <LogsFile> [--epoll] [--reactors <N|auto>] [--pin]\n"
+           "       [--log-policy <block|drop|sample>] [--log-flush-ms <N>] [--log-format <text|binary>]\n"
+           "       [--max-queue-bytes <N>] [--max-queue-msgs <N>] [--no-conflate] [--evict-after-ms <N>]\n"
+           "       [--vehicles <N>] [--sim-step-ms <N>] [--max-clients <N>] [--history-seconds <N>]\n"
+           "       [--multicast <addr:port>] [--multicast-if <ip>] [--multicast-hz <N>]\n"
+           "       [--shm <name>] [--shm-hz <N>]\n"
+           "       [--store <dir>] [--store-segment-mb <N>] [--store-segment-minutes <N>]\n"
+           "       [--snapshot <path>] [--snapshot-interval <N>] [--session-ttl <N>]\n"
+           "       [--upgrade-socket <path>] [--takeover <path>]\n", program);
+    printf("  --epoll             serve all clients from one epoll event loop\n");
+    printf("  --reactors <N|auto> run N event loops with SO_REUSEPORT listeners (auto = one per core)\n");
+    printf("  --pin               pin each reactor thread to its own CPU\n");
+    printf("  --log-policy <P>    when the log queue is full: block (default), drop or sample\n");
+    printf("  --log-flush-ms <N>  max delay before queued log lines are written (default %d)\n", LOG_FLUSH_INTERVAL_MS);
+    printf("  --log-format <F>    log file encoding: text (default) or binary (read it with logdump)\n");
+    printf("  --max-queue-bytes <N> outbound bytes queued per client (default %d)\n", OUTBOUND_DEFAULT_MAX_BYTES);
+    printf("  --max-queue-msgs <N>  outbound messages queued per client (default and max %d)\n", OUTBOUND_QUEUE_MAX);
+    printf("  --no-conflate       queue every telemetry frame instead of only the newest\n");
+    printf("  --evict-after-ms <N>  disconnect clients over a queue limit this long (default %d)\n", OUTBOUND_DEFAULT_EVICT_MS);
+    printf("  --vehicles <N>      fleet size; commands address vehicles 0..N-1 (default %d)\n", FLEET_DEFAULT_VEHICLES);
+    printf("  --sim-step-ms <N>   simulation timestep, 1-%d (default %d)\n", FLEET_MAX_STEP_MS, FLEET_DEFAULT_STEP_MS);
+    printf("  --history-seconds <N> steps kept for GET_HISTORY, 0-%d s; 0 disables it (default %d)\n",
+           HISTORY_MAX_SECONDS, HISTORY_DEFAULT_SECONDS);
+    printf("  --max-clients <N>   connections served at once, 1-%d (default %d)\n", CLIENT_MAX_CAPACITY, MAX_CLIENTS);
+    printf("  --multicast <addr:port> also publish telemetry as UDP datagrams to a multicast group\n"
+           "                      or broadcast address, with sequence numbers (see multicast.h)\n");
+    printf("  --multicast-if <ip> interface for multicast, e.g. 127.0.0.1 to stay on loopback\n");
+    printf("  --multicast-hz <N>  datagram rate, 1-%d; 0 = with the periodic broadcast (default)\n", SUBSCRIBE_MAX_HZ);
+    printf("  --shm <name>        also publish telemetry to a ring in /dev/shm/<name> for local readers\n"
+           "                      (shm_reader.h, ./shmtail), e.g. /vt-telemetry\n");
+    printf("  --shm-hz <N>        shared memory feed rate, 0-%d (default %d)\n", SUBSCRIBE_MAX_HZ, SUBSCRIBE_MAX_HZ);
+    printf("  --store <dir>       also keep every history step on disk in compressed segments\n"
+           "                      (read them with ./seriesdump)\n");
+    printf("  --store-segment-mb <N> segment size, 1-%d MB (default %d)\n", SERIES_MAX_SEGMENT_MB,
+           SERIES_DEFAULT_SEGMENT_MB);
+    printf("  --store-segment-minutes <N> time a segment spans at most (default %d)\n",
+           SERIES_DEFAULT_SEGMENT_MINUTES);
+    printf("  --snapshot <path>   restore the fleet and sessions from path at startup, and save\n"
+           "                      them there periodically and at shutdown\n");
+    printf("  --snapshot-interval <N> seconds between snapshots (default %d)\n", SNAPSHOT_DEFAULT_INTERVAL);
+    printf("  --session-ttl <N>   seconds an AUTH token stays valid for RESUME; 0 disables tokens\n"
+           "                      (default %d)\n", TOKEN_DEFAULT_TTL_SECONDS);
+    printf("  --upgrade-socket <path> accept a hot upgrade on this Unix socket; SIGUSR2 starts the\n"
+           "                      binary at argv[0] again, which takes over the listeners\n");
+    printf("  --takeover <path>   start by taking over the listeners, fleet and sessions of the\n"
+           "                      server on this upgrade socket (same --reactors count)\n");
 }
@@ -0,0 +1,310 @@
+#include "session.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// ============================================================================
+// SESSION FUNCTIONS
+// ============================================================================
+
+// Sessions come zeroed from the owning reactor's slab
+session_t* session_create(slab_t* slab, int socket, const char* ip, int port) {
+    session_t* session = slab_alloc(slab);
+    if (!session) return NULL;
+
+    session->socket = socket;
+    if (ip) {
+        strncpy(session->ip, ip, INET_ADDRSTRLEN - 1);
+    }
+    session->port = port;
+    session->state = SESSION_READING;
+    stream_input_init(&session->input);
+    return session;
+}
+
+void session_destroy(slab_t* slab, session_t* session) {
+    if (!session) return;
+
+    free(session->out);
+#ifdef USE_IO_URING
+    free(session->inflight);
+#endif
+    slab_free(slab, session);
+}
+
+static size_t session_queued_bytes(session_t* session) {
+    size_t queued = session->out_len - session->out_sent;
+#ifdef USE_IO_URING
+    queued += session->inflight_len - session->inflight_sent;
+#endif
+    return queued;
+}
+
+// Applies the outbound limits and conflation shared with thread-per-client mode.
+// Returns 0 if queued, 1 if refused because the client is over a limit, -1 on error.
+static int session_queue(session_t* session, const char* data, size_t length, outbound_kind_t kind) {
+    if (!session || !data) return -1;
+
+    // Reclaim the already-sent prefix before growing
+    if (session->out_sent > 0) {
+        if (session->telemetry_length > 0 && session->telemetry_offset < session->out_sent) {
+            session->telemetry_length = 0; // already on the wire
+        }
+        session->telemetry_offset -= session->telemetry_length > 0 ? session->out_sent : 0;
+        memmove(session->out, session->out + session->out_sent, session->out_len - session->out_sent);
+        session->out_len -= session->out_sent;
+        session->out_sent = 0;
+    }
+    if (session_queued_bytes(session) == 0) {
+        session->out_messages = 0;
+    }
+
+    const outbound_limits_t* limits = outbound_get_limits();
+    int conflate = kind == OUTBOUND_TELEMETRY && limits->conflate && session->telemetry_length > 0;
+    size_t replaced = conflate ? session->telemetry_length : 0;
+
+    if (outbound_over_limit(session_queued_bytes(session) - replaced,
+                            session->out_messages - (conflate ? 1 : 0), length)) {
+        if (session->over_limit_since == 0) session->over_limit_since = outbound_now_ms();
+        outbound_count(OUTBOUND_EVENT_DROPPED);
+        return 1;
+    }
+    session->over_limit_since = 0;
+
+    // Conflation: cut the stale frame out, the new one goes to the tail
+    if (conflate) {
+        memmove(session->out + session->telemetry_offset,
+                session->out + session->telemetry_offset + replaced,
+                session->out_len - session->telemetry_offset - replaced);
+        session->out_len -= replaced;
+        session->out_messages--;
+        session->telemetry_length = 0;
+        outbound_count(OUTBOUND_EVENT_CONFLATED);
+    }
+
+    if (session->out_len + length > session->out_cap) {
+        size_t new_cap = session->out_cap ? session->out_cap : SESSION_OUT_INITIAL;
+        while (new_cap < session->out_len + length) new_cap *= 2;
+        char* out = realloc(session->out, new_cap);
+        if (!out) return -1;
+        session->out = out;
+        session->out_cap = new_cap;
+    }
+
+    if (kind == OUTBOUND_TELEMETRY) {
+        session->telemetry_offset = session->out_len;
+        session->telemetry_length = length;
+    }
+    memcpy(session->out + session->out_len, data, length);
+    session->out_len += length;
+    session->out_messages++;
+    return 0;
+}
+
+int session_append(session_t* session, const char* data, size_t length) {
+    return session_queue(session, data, length, OUTBOUND_RESPONSE);
+}
+
+int session_append_telemetry(session_t* session, const char* data, size_t length) {
+    return session_queue(session, data, length, OUTBOUND_TELEMETRY);
+}
+
+// A stale frame still queued is replaced by the keyframe, see
+// outbound_queue_push_delta
+int session_append_delta(session_t* session, const char* delta, size_t delta_length,
+                         const char* keyframe, size_t keyframe_length) {
+    if (!session) return -1;
+
+    int stale = outbound_get_limits()->conflate && session->telemetry_length > 0 &&
+                session->telemetry_offset >= session->out_sent;
+    if (stale) return session_queue(session, keyframe, keyframe_length, OUTBOUND_TELEMETRY);
+    return session_queue(session, delta, delta_length, OUTBOUND_TELEMETRY);
+}
+
+// Called when out has been handed to the kernel in full
+void session_out_reset(session_t* session) {
+    if (!session) return;
+
+    session->out_len = 0;
+    session->out_sent = 0;
+    session->telemetry_length = 0;
+    if (session_queued_bytes(session) == 0) {
+        session->out_messages = 0;
+        session->over_limit_since = 0;
+    }
+}
+
+int session_expired(session_t* session, long long now_ms) {
+    return session && outbound_expired(session->over_limit_since, now_ms);
+}
+
+// Queues the frames of every tick in data (telemetry records taken from a
+// broadcast queue) that the session's rate group is due for, in its protocol
+// and delta mode. Returns -1 on error.
+int session_append_broadcasts(session_t* session, const char* data, size_t length) {
+    if (!session || !data) return -1;
+
+    telemetry_tick_t tick;
+    size_t size;
+    while ((size = telemetry_tick_read(data, length, &tick)) > 0) {
+        data += size;
+        length -= size;
+
+        const char* frame;
+        size_t frame_length;
+        stream_protocol_t protocol = session->input.protocol;
+        telemetry_kind_t kind = telemetry_tick_select(&tick, session->input.telemetry_hz, protocol,
+                                                      session->input.telemetry_delta, session->delta_resync,
+                                                      &frame, &frame_length);
+        int result = 0;
+        if (kind == TELEMETRY_DELTA) {
+            result = session_append_delta(session, frame, frame_length,
+                                          tick.keyframe[protocol], tick.keyframe_length[protocol]);
+        } else if (kind == TELEMETRY_KEYFRAME) {
+            result = session_append_telemetry(session, frame, frame_length);
+            if (result == 0) session->delta_resync = 0;
+        }
+
+        // A refused frame leaves the client behind its group's deltas
+        if (result < 0) return -1;
+        if (result > 0) session->delta_resync = 1;
+    }
+    return 0;
+}
+
+// Feeds one received chunk into the session's stream buffer, runs every
+// complete message through the protocol and queues all responses as one write.
+// Returns -1 on error, 1 when the client asked to disconnect, 0 otherwise.
+int session_handle_input(session_t* session, const char* data, size_t length,
+                         client_manager_t* client_mgr, fleet_t* fleet, logger_t* logger) {
+    if (!session || !data || !client_mgr || !fleet || !logger) return -1;
+
+    stream_output_t output;
+    stream_output_init(&output);
+
+    size_t offset = 0;
+    int result = 0;
+    stream_protocol_t protocol = session->input.protocol;
+    int telemetry_hz = session->input.telemetry_hz;
+    int telemetry_delta = session->input.telemetry_delta;
+    while (offset < length && result == 0) {
+        size_t taken = stream_input_append(&session->input, data + offset, length - offset);
+        offset += taken;
+        result = protocol_handle_stream(&session->input, &output, session->socket, session->ip,
+                                        session->port, client_mgr, fleet, logger);
+        if (taken == 0) break;
+    }
+
+    // A new group or encoding has no deltas in common with the old one
+    if (session->input.protocol != protocol || session->input.telemetry_hz != telemetry_hz ||
+        session->input.telemetry_delta != telemetry_delta) {
+        session->delta_resync = 1;
+    }
+
+    // Responses carry no request ids, so one refused batch would pair every
+    // later response with the wrong request: close the connection instead
+    if (result >= 0 && output.length > 0 && session_append(session, output.data, output.length) != 0) {
+        logger_log(logger, LOG_ERROR, session->ip, session->port, "Response refused, client too far behind");
+        result = -1;
+    }
+    stream_output_cleanup(&output);
+    return result;
+}
+
+// ============================================================================
+// RATE GROUP FUNCTIONS
+// ============================================================================
+
+// Lists the session in the group of its current rate
+void session_groups_link(session_groups_t* groups, session_t* session) {
+    if (!groups || !session) return;
+
+    session_t** head = &groups->heads[session->input.telemetry_hz];
+    session->group = session->input.telemetry_hz;
+    session->group_prev = NULL;
+    session->group_next = *head;
+    if (*head) (*head)->group_prev = session;
+    *head = session;
+}
+
+void session_groups_unlink(session_groups_t* groups, session_t* session) {
+    if (!groups || !session) return;
+
+    if (session->group_prev) session->group_prev->group_next = session->group_next;
+    else if (groups->heads[session->group] == session) groups->heads[session->group] = session->group_next;
+    if (session->group_next) session->group_next->group_prev = session->group_prev;
+    session->group_prev = NULL;
+    session->group_next = NULL;
+}
+
+// Moves the session after a SUBSCRIBE changed its rate
+void session_groups_update(session_groups_t* groups, session_t* session) {
+    if (!groups || !session || session->group == session->input.telemetry_hz) return;
+
+    session_groups_unlink(groups, session);
+    session_groups_link(groups, session);
+}
+
+// ============================================================================
+// BROADCAST QUEUE FUNCTIONS
+// ============================================================================
+
+int broadcast_queue_init(broadcast_queue_t* queue) {
+    if (!queue) return -1;
+
+    queue->data = NULL;
+    queue->length = 0;
+    queue->capacity = 0;
+
+    if (pthread_mutex_init(&queue->mutex, NULL) != 0) {
+        perror("Error initializing broadcast queue mutex");
+        return -1;
+    }
+    return 0;
+}
+
+int broadcast_queue_push(broadcast_queue_t* queue, const char* data, size_t length) {
+    if (!queue || !data || length == 0) return -1;
+
+    pthread_mutex_lock(&queue->mutex);
+
+    if (queue->length + length > queue->capacity) {
+        size_t new_cap = queue->capacity ? queue->capacity : SESSION_OUT_INITIAL;
+        while (new_cap < queue->length + length) new_cap *= 2;
+        char* buffer = realloc(queue->data, new_cap);
+        if (!buffer) {
+            pthread_mutex_unlock(&queue->mutex);
+            return -1;
+        }
+        queue->data = buffer;
+        queue->capacity = new_cap;
+    }
+    memcpy(queue->data + queue->length, data, length);
+    queue->length += length;
+
+    pthread_mutex_unlock(&queue->mutex);
+    return 0;
+}
+
+// Detach everything queued so far; the caller frees the returned buffer
+char* broadcast_queue_take(broadcast_queue_t* queue, size_t* length) {
+    if (!queue || !length) return NULL;
+
+    pthread_mutex_lock(&queue->mutex);
+    char* data = queue->data;
+    *length = queue->length;
+    queue->data = NULL;
+    queue->length = 0;
+    queue->capacity = 0;
+    pthread_mutex_unlock(&queue->mutex);
+
+    return data;
+}
+
+void broadcast_queue_cleanup(broadcast_queue_t* queue) {
+    if (!queue) return;
+
+    free(queue->data);
+    queue->data = NULL;
+    pthread_mutex_destroy(&queue->mutex);
+}
@@ -0,0 +1,92 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <pthread.h>
+#include <netinet/in.h>
+#include "client_protocol.h"
+#include "fleet.h"
+#include "telemetry.h"
+#include "slab.h"
+
+// Session constants
+#define SESSION_OUT_INITIAL 2048
+#define SESSION_SLAB_OBJECTS 16     // sessions allocated together as a reactor grows
+
+// Connection state machine shared by the event loop backends
+typedef enum {
+    SESSION_READING,    // idle, waiting for the next command
+    SESSION_WRITING,    // output pending, waiting for the socket to drain
+    SESSION_CLOSING     // flush pending output, then close
+} session_state_t;
+
+// Per-connection state owned by a reactor thread
+typedef struct session {
+    int socket;
+    client_handle_t client;     // registry entry, removed when the session closes
+    char ip[INET_ADDRSTRLEN];
+    int port;
+    session_state_t state;
+    stream_input_t input;       // partial message carried between reads
+    char* out;          // pending outbound bytes
+    size_t out_len;
+    size_t out_sent;
+    size_t out_cap;
+    size_t telemetry_offset;    // newest unsent telemetry frame in out, for conflation
+    size_t telemetry_length;    // 0 if none
+    int out_messages;           // messages queued since out was last empty
+    long long over_limit_since; // monotonic ms of the first refused message, 0 if none
+    int delta_resync;           // next telemetry must be a keyframe
+#ifdef USE_IO_URING
+    // Buffer owned by an in-flight send; out keeps accumulating meanwhile
+    char* inflight;
+    size_t inflight_len;
+    size_t inflight_sent;
+    size_t inflight_cap;
+    int pending_ops;    // submitted operations still referencing this session
+#endif
+    struct session* prev;
+    struct session* next;
+    int group;                  // rate group list it is on
+    struct session* group_prev;
+    struct session* group_next;
+} session_t;
+
+// A reactor's sessions by rate group, so a tick visits only the groups due
+// on it. Owned by the reactor thread, which is the only one to change them.
+typedef struct {
+    session_t* heads[SUBSCRIBE_GROUP_COUNT];
+} session_groups_t;
+
+// Data posted by other threads for a reactor to fan out
+typedef struct {
+    pthread_mutex_t mutex;
+    char* data;
+    size_t length;
+    size_t capacity;
+} broadcast_queue_t;
+
+// Session functions
+session_t* session_create(slab_t* slab, int socket, const char* ip, int port);
+void session_destroy(slab_t* slab, session_t* session);
+int session_append(session_t* session, const char* data, size_t length);
+int session_append_telemetry(session_t* session, const char* data, size_t length);
+int session_append_delta(session_t* session, const char* delta, size_t delta_length,
+                         const char* keyframe, size_t keyframe_length);
+void session_out_reset(session_t* session);
+int session_expired(session_t* session, long long now_ms);
+int session_append_broadcasts(session_t* session, const char* data, size_t length);
+int session_handle_input(session_t* session, const char* data, size_t length,
+                         client_manager_t* client_mgr, fleet_t* fleet, logger_t* logger);
+
+// Rate group functions
+void session_groups_link(session_groups_t* groups, session_t* session);
+void session_groups_unlink(session_groups_t* groups, session_t* session);
+void session_groups_update(session_groups_t* groups, session_t* session);
+
+// Broadcast queue functions
+int broadcast_queue_init(broadcast_queue_t* queue);
+int broadcast_queue_push(broadcast_queue_t* queue, const char* data, size_t length);
+char* broadcast_queue_take(broadcast_queue_t* queue, size_t* length);
+void broadcast_queue_cleanup(broadcast_queue_t* queue);
+
+#endif // SESSION_H
@@ -0,0 +1,105 @@
+#include "shm_feed.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+// ============================================================================
+// LAYOUT
+// ============================================================================
+
+size_t shm_feed_map_size(uint32_t capacity) {
+    return sizeof(shm_feed_header_t) + (size_t)capacity * sizeof(shm_feed_slot_t);
+}
+
+static uint32_t shm_feed_round_capacity(uint32_t capacity) {
+    if (capacity == 0) capacity = SHM_FEED_DEFAULT_SLOTS;
+    if (capacity > SHM_FEED_MAX_SLOTS) capacity = SHM_FEED_MAX_SLOTS;
+    uint32_t rounded = 1;
+    while (rounded < capacity) rounded <<= 1;
+    return rounded;
+}
+
+// ============================================================================
+// WRITER FUNCTIONS
+// ============================================================================
+
+// name is a POSIX shared memory name ("/vt-telemetry"). An object left by a
+// server that did not stop cleanly is replaced; its readers keep the old one.
+int shm_feed_create(shm_feed_t* feed, const char* name, uint32_t capacity) {
+    if (!feed || !name || name[0] != '/' || strchr(name + 1, '/') || strlen(name) >= sizeof(feed->name)) {
+        fprintf(stderr, "Invalid shared memory name: %s (expected /<name>)\n", name ? name : "(null)");
+        return -1;
+    }
+
+    memset(feed, 0, sizeof(*feed));
+    strcpy(feed->name, name);
+    capacity = shm_feed_round_capacity(capacity);
+    feed->map_size = shm_feed_map_size(capacity);
+
+    shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        perror("Error creating shared memory feed");
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)feed->map_size) != 0) {
+        perror("Error sizing shared memory feed");
+        close(fd);
+        shm_unlink(name);
+        return -1;
+    }
+
+    void* memory = mmap(NULL, feed->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        perror("Error mapping shared memory feed");
+        shm_unlink(name);
+        return -1;
+    }
+
+    // ftruncate zeroed the object: every slot reads as never written
+    feed->header = memory;
+    feed->slots = (shm_feed_slot_t*)((char*)memory + sizeof(shm_feed_header_t));
+    feed->header->version = SHM_FEED_VERSION;
+    feed->header->slot_size = SHM_FEED_SLOT_SIZE;
+    feed->header->capacity = capacity;
+    feed->header->stream_id = (uint32_t)time(NULL) ^ ((uint32_t)getpid() << 16);
+    feed->header->writer_pid = (int32_t)getpid();
+    __atomic_store_n(&feed->header->magic, SHM_FEED_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Writes the next frame over the oldest one; never blocks on readers
+void shm_feed_publish(shm_feed_t* feed, const shm_feed_record_t* record) {
+    if (!feed || !feed->header || !record) return;
+
+    uint64_t words[SHM_FEED_RECORD_WORDS];
+    memcpy(words, record, sizeof(*record));
+
+    uint64_t position = feed->header->head;
+    shm_feed_slot_t* slot = &feed->slots[position & (feed->header->capacity - 1)];
+
+    __atomic_store_n(&slot->seq, 2 * position + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (int i = 0; i < SHM_FEED_RECORD_WORDS; i++) {
+        __atomic_store_n(&slot->words[i], words[i], __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&slot->seq, 2 * position + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&feed->header->head, position + 1, __ATOMIC_RELEASE);
+}
+
+// Marks the feed closed so readers stop waiting, and removes the name; the
+// memory goes away when the last reader unmaps it
+void shm_feed_destroy(shm_feed_t* feed) {
+    if (!feed || !feed->header) return;
+
+    __atomic_store_n(&feed->header->closed, 1, __ATOMIC_RELEASE);
+    munmap(feed->header, feed->map_size);
+    shm_unlink(feed->name);
+    feed->header = NULL;
+    feed->slots = NULL;
+}
@@ -0,0 +1,78 @@
+#ifndef SHM_FEED_H
+#define SHM_FEED_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Telemetry feed in a POSIX shared memory object (/dev/shm/<name>) for
+// consumers on the same host. The server is the only writer; any number of
+// readers map the object read-only and never signal or wait for it.
+//
+//   header    one cache line: magic, version, slot size, capacity, stream
+//             id, writer pid, closed flag; then head on a line of its own
+//   slots     capacity cache lines, power of two; frame p goes to slot
+//             p % capacity and overwrites whatever was there
+//
+// Each slot is a seqlock keyed by position: seq is 2p + 1 while frame p is
+// being written and 2p + 2 once it is complete. A reader that wants frame p
+// copies the slot and keeps the copy only if seq read 2p + 2 before and after;
+// a larger value means the writer has lapped it. head counts the frames
+// published and is stored after the slot, so slot head - 1 is the latest.
+//
+// This header has no other dependencies; shm_reader.h is the reader API.
+
+#define SHM_FEED_MAGIC 0x52535456       // "VTSR"
+#define SHM_FEED_VERSION 1
+#define SHM_FEED_SLOT_SIZE 64
+#define SHM_FEED_DEFAULT_SLOTS 4096     // 40 s of frames at 100 Hz
+#define SHM_FEED_MAX_SLOTS (1 << 20)
+#define SHM_FEED_RECORD_WORDS 5
+
+// One telemetry frame as consumers see it
+typedef struct {
+    int64_t timestamp;      // Unix seconds
+    uint64_t step;          // simulation step the state is current to
+    uint64_t tick;          // telemetry scheduler tick (100 per second)
+    uint32_t vehicle_id;
+    int16_t speed;          // km/h
+    uint8_t battery;        // %
+    int8_t temperature;     // °C
+    uint8_t direction;      // 0 STRAIGHT, 1 LEFT, 2 RIGHT
+    uint8_t reserved[3];
+} shm_feed_record_t;
+
+// The record is copied in and out as whole words with relaxed atomics, so a
+// reader racing the writer reads stale words rather than a data race
+typedef struct {
+    uint64_t seq;
+    uint64_t words[SHM_FEED_RECORD_WORDS];
+} __attribute__((aligned(SHM_FEED_SLOT_SIZE))) shm_feed_slot_t;
+
+typedef struct {
+    uint32_t magic;         // stored last, once the rest is valid
+    uint16_t version;
+    uint16_t slot_size;
+    uint32_t capacity;
+    uint32_t stream_id;     // new on every server start
+    int32_t writer_pid;
+    uint32_t closed;        // set when the server stops; no frames follow
+    uint64_t head __attribute__((aligned(SHM_FEED_SLOT_SIZE))); // frames published
+} __attribute__((aligned(SHM_FEED_SLOT_SIZE))) shm_feed_header_t;
+
+// Writer side, owned by the telemetry thread
+typedef struct {
+    shm_feed_header_t* header;
+    shm_feed_slot_t* slots;
+    size_t map_size;
+    char name[256];
+} shm_feed_t;
+
+// Writer functions
+int shm_feed_create(shm_feed_t* feed, const char* name, uint32_t capacity);
+void shm_feed_publish(shm_feed_t* feed, const shm_feed_record_t* record);
+void shm_feed_destroy(shm_feed_t* feed);
+
+// Layout helpers shared with the reader
+size_t shm_feed_map_size(uint32_t capacity);
+
+#endif // SHM_FEED_H
@@ -0,0 +1,132 @@
+#include "shm_reader.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+
+// ============================================================================
+// MAPPING
+// ============================================================================
+
+// Maps the feed read-only and starts at the next frame the server publishes.
+// Returns -1 if there is no feed by that name or it has another layout.
+int shm_reader_open(shm_reader_t* reader, const char* name) {
+    if (!reader || !name) return -1;
+
+    memset(reader, 0, sizeof(*reader));
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        perror("Error opening shared memory feed");
+        return -1;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(shm_feed_header_t)) {
+        fprintf(stderr, "%s: not a telemetry feed\n", name);
+        close(fd);
+        return -1;
+    }
+
+    void* memory = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        perror("Error mapping shared memory feed");
+        return -1;
+    }
+
+    const shm_feed_header_t* header = memory;
+    uint32_t capacity = header->capacity;
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHM_FEED_MAGIC ||
+        header->version != SHM_FEED_VERSION || header->slot_size != sizeof(shm_feed_slot_t) ||
+        capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        shm_feed_map_size(capacity) > (size_t)info.st_size) {
+        fprintf(stderr, "%s: not a telemetry feed (version %d expected)\n", name, SHM_FEED_VERSION);
+        munmap(memory, (size_t)info.st_size);
+        return -1;
+    }
+
+    reader->header = header;
+    reader->slots = (const shm_feed_slot_t*)((const char*)memory + sizeof(shm_feed_header_t));
+    reader->map_size = (size_t)info.st_size;
+    reader->mask = capacity - 1;
+    reader->cursor = __atomic_load_n(&header->head, __ATOMIC_ACQUIRE);
+    return 0;
+}
+
+void shm_reader_close(shm_reader_t* reader) {
+    if (!reader || !reader->header) return;
+
+    munmap((void*)reader->header, reader->map_size);
+    reader->header = NULL;
+    reader->slots = NULL;
+}
+
+// ============================================================================
+// READING
+// ============================================================================
+
+// Copies frame position out of its slot. Returns 1 on a clean copy, 0 if
+// the writer has not finished it yet and -1 if it has been overwritten.
+static int shm_reader_copy(const shm_reader_t* reader, uint64_t position, shm_feed_record_t* record) {
+    const shm_feed_slot_t* slot = &reader->slots[position & reader->mask];
+    uint64_t complete = 2 * position + 2;
+    uint64_t words[SHM_FEED_RECORD_WORDS];
+
+    for (;;) {
+        uint64_t start = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (start > complete) return -1;
+        if (start < complete - 1) return 0;
+        if (start == complete - 1) continue; // writer mid-frame, done in nanoseconds
+
+        for (int i = 0; i < SHM_FEED_RECORD_WORDS; i++) {
+            words[i] = __atomic_load_n(&slot->words[i], __ATOMIC_RELAXED);
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == start) break;
+    }
+    memcpy(record, words, sizeof(*record));
+    return 1;
+}
+
+// The next frame in order. Returns 1 with record filled, 0 if there is no
+// new frame yet, and -1 once the server has stopped and every frame has been
+// read. A reader that fell a whole ring behind skips to the oldest frame still
+// there and adds the skipped ones to missed.
+int shm_reader_next(shm_reader_t* reader, shm_feed_record_t* record) {
+    if (!reader || !reader->header || !record) return -1;
+
+    for (;;) {
+        uint64_t head = __atomic_load_n(&reader->header->head, __ATOMIC_ACQUIRE);
+        if (reader->cursor >= head) {
+            return __atomic_load_n(&reader->header->closed, __ATOMIC_ACQUIRE) ? -1 : 0;
+        }
+
+        uint64_t oldest = head > reader->mask ? head - reader->mask : 0;
+        if (reader->cursor < oldest) {
+            reader->missed += oldest - reader->cursor;
+            reader->cursor = oldest;
+        }
+
+        int copied = shm_reader_copy(reader, reader->cursor, record);
+        if (copied > 0) {
+            reader->cursor++;
+            return 1;
+        }
+        if (copied == 0) return 0;
+        // Lapped between loading head and copying; recompute from a new head
+    }
+}
+
+// The most recent frame, without moving the cursor. Returns 1 with record
+// filled, 0 if nothing was published yet.
+int shm_reader_latest(shm_reader_t* reader, shm_feed_record_t* record) {
+    if (!reader || !reader->header || !record) return -1;
+
+    for (;;) {
+        uint64_t head = __atomic_load_n(&reader->header->head, __ATOMIC_ACQUIRE);
+        if (head == 0) return 0;
+        if (shm_reader_copy(reader, head - 1, record) > 0) return 1;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef SHM_READER_H
+#define SHM_READER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "shm_feed.h"
+
+// Reader library for the server's shared-memory telemetry feed (--shm).
+// Link with libshmreader.a (make shmreader). Reads are plain loads from a
+// read-only mapping: no system calls after shm_reader_open and nothing the
+// server waits on, so a slow or stopped reader never affects it or the
+// other readers.
+//
+//   shm_reader_t reader;
+//   shm_feed_record_t record;
+//   shm_reader_open(&reader, "/vt-telemetry");
+//   while (shm_reader_next(&reader, &record) >= 0) { ... }
+//   shm_reader_close(&reader);
+//
+// shm_reader_next returns 0 when no new frame is there yet; the caller picks
+// how to wait (spin, sleep, or poll at its own rate).
+
+typedef struct {
+    const shm_feed_header_t* header;
+    const shm_feed_slot_t* slots;
+    size_t map_size;
+    uint32_t mask;              // capacity - 1
+    uint64_t cursor;            // position of the next frame to read
+    uint64_t missed;            // frames overwritten before this reader got to them
+} shm_reader_t;
+
+// Reader functions
+int shm_reader_open(shm_reader_t* reader, const char* name);
+int shm_reader_next(shm_reader_t* reader, shm_feed_record_t* record);
+int shm_reader_latest(shm_reader_t* reader, shm_feed_record_t* record);
+void shm_reader_close(shm_reader_t* reader);
+
+#endif // SHM_READER_H
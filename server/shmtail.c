@@ -0,0 +1,87 @@
+/*
+ * Shared-memory feed follower
+ * Prints the telemetry frames the server publishes with --shm, as they
+ * arrive, using the reader library (shm_reader.h). An example consumer as
+ * much as a debugging tool.
+ *
+ * Compilation: make shmtail
+ * Usage: ./shmtail [name] [--latest]   (default name /vt-telemetry)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+
+#include "shm_reader.h"
+
+#define SHMTAIL_DEFAULT_NAME "/vt-telemetry"
+#define SHMTAIL_IDLE_NS 1000000         // poll interval when no frame is waiting
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+static const char* direction_name(uint8_t direction) {
+    static const char* names[] = {"STRAIGHT", "LEFT", "RIGHT"};
+    return direction < 3 ? names[direction] : "?";
+}
+
+static void print_record(const shm_feed_record_t* record) {
+    printf("tick=%llu step=%llu vehicle=%u speed=%d battery=%u temperature=%d direction=%s timestamp=%lld\n",
+           (unsigned long long)record->tick, (unsigned long long)record->step, record->vehicle_id,
+           record->speed, record->battery, record->temperature, direction_name(record->direction),
+           (long long)record->timestamp);
+}
+
+int main(int argc, char* argv[]) {
+    const char* name = SHMTAIL_DEFAULT_NAME;
+    int latest_only = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--latest") == 0) {
+            latest_only = 1;
+        } else {
+            name = argv[i];
+        }
+    }
+
+    shm_reader_t reader;
+    if (shm_reader_open(&reader, name) != 0) return 1;
+
+    shm_feed_record_t record;
+    if (latest_only) {
+        int found = shm_reader_latest(&reader, &record);
+        if (found > 0) print_record(&record);
+        shm_reader_close(&reader);
+        return found > 0 ? 0 : 1;
+    }
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    printf("Following %s (stream %08x, %u slots)\n", name, reader.header->stream_id, reader.header->capacity);
+    fflush(stdout);
+
+    unsigned long long frames = 0;
+    struct timespec idle = {0, SHMTAIL_IDLE_NS};
+    while (running) {
+        int status = shm_reader_next(&reader, &record);
+        if (status < 0) {
+            printf("Feed closed by the server\n");
+            break;
+        }
+        if (status == 0) {
+            nanosleep(&idle, NULL);
+            continue;
+        }
+        print_record(&record);
+        fflush(stdout);
+        frames++;
+    }
+
+    fprintf(stderr, "%llu frames, %llu missed\n", frames, (unsigned long long)reader.missed);
+    shm_reader_close(&reader);
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include "slab.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// SLAB ALLOCATOR
+// ============================================================================
+
+static size_t slab_round_up(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+// alignment must be a power of two no smaller than a pointer
+int slab_init(slab_t* slab, size_t object_size, size_t alignment, int per_chunk) {
+    if (!slab || object_size == 0 || per_chunk <= 0 || alignment < sizeof(void*) ||
+        (alignment & (alignment - 1)) != 0) {
+        return -1;
+    }
+
+    memset(slab, 0, sizeof(*slab));
+    slab->alignment = alignment;
+    slab->object_size = slab_round_up(object_size < sizeof(void*) ? sizeof(void*) : object_size, alignment);
+    slab->header_size = slab_round_up(sizeof(slab_chunk_t), alignment);
+    slab->per_chunk = per_chunk;
+    return 0;
+}
+
+// Carves a new chunk into objects and puts them all on the free list, lowest
+// address first
+static int slab_grow(slab_t* slab) {
+    void* memory;
+    size_t size = slab->header_size + slab->object_size * (size_t)slab->per_chunk;
+    if (posix_memalign(&memory, slab->alignment, size) != 0) {
+        perror("Error allocating slab chunk");
+        return -1;
+    }
+
+    slab_chunk_t* chunk = memory;
+    chunk->next = slab->chunks;
+    slab->chunks = chunk;
+
+    char* objects = (char*)memory + slab->header_size;
+    for (int i = slab->per_chunk - 1; i >= 0; i--) {
+        void* object = objects + (size_t)i * slab->object_size;
+        *(void**)object = slab->free_list;
+        slab->free_list = object;
+    }
+    __atomic_store_n(&slab->chunk_count, slab->chunk_count + 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+// A zeroed object, or NULL when out of memory
+void* slab_alloc(slab_t* slab) {
+    if (!slab) return NULL;
+    if (!slab->free_list && slab_grow(slab) != 0) return NULL;
+
+    void* object = slab->free_list;
+    slab->free_list = *(void**)object;
+    memset(object, 0, slab->object_size);
+    __atomic_store_n(&slab->in_use, slab->in_use + 1, __ATOMIC_RELAXED);
+    return object;
+}
+
+void slab_free(slab_t* slab, void* object) {
+    if (!slab || !object) return;
+
+    *(void**)object = slab->free_list;
+    slab->free_list = object;
+    __atomic_store_n(&slab->in_use, slab->in_use - 1, __ATOMIC_RELAXED);
+}
+
+void slab_cleanup(slab_t* slab) {
+    if (!slab) return;
+
+    while (slab->chunks) {
+        slab_chunk_t* chunk = slab->chunks;
+        slab->chunks = chunk->next;
+        free(chunk);
+    }
+    slab->free_list = NULL;
+    slab->chunk_count = 0;
+    slab->in_use = 0;
+}
+
+// Bytes held in chunks, live objects or not
+size_t slab_memory_bytes(const slab_t* slab) {
+    if (!slab) return 0;
+    size_t chunks = __atomic_load_n(&slab->chunk_count, __ATOMIC_RELAXED);
+    return chunks * (slab->header_size + slab->object_size * (size_t)slab->per_chunk);
+}
+
+size_t slab_in_use(const slab_t* slab) {
+    return slab ? __atomic_load_n(&slab->in_use, __ATOMIC_RELAXED) : 0;
+}
@@ -0,0 +1,37 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>
+
+// Slab constants
+#define SLAB_CACHE_LINE 64
+
+// Fixed-size objects carved out of large aligned chunks, so thousands of
+// connections cost a handful of allocations instead of one each. Freed
+// objects go on a free list for the next allocation; chunks are only handed
+// back to the system by slab_cleanup. Not thread-safe: the owner serializes
+// alloc and free, only the memory counters may be read from other threads.
+typedef struct slab_chunk {
+    struct slab_chunk* next;
+} slab_chunk_t;
+
+typedef struct {
+    size_t object_size;     // rounded up to the alignment
+    size_t alignment;
+    size_t header_size;     // chunk link, padded so the first object is aligned
+    int per_chunk;
+    void* free_list;        // freed objects, linked through their first bytes
+    slab_chunk_t* chunks;
+    size_t chunk_count;
+    size_t in_use;
+} slab_t;
+
+// Slab functions
+int slab_init(slab_t* slab, size_t object_size, size_t alignment, int per_chunk);
+void* slab_alloc(slab_t* slab);
+void slab_free(slab_t* slab, void* object);
+void slab_cleanup(slab_t* slab);
+size_t slab_memory_bytes(const slab_t* slab);
+size_t slab_in_use(const slab_t* slab);
+
+#endif // SLAB_H
@@ -0,0 +1,252 @@
+#include "snapshot.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+// FNV-1a over 64-bit words rather than bytes, so checking a large fleet
+// costs a fraction of reading it
+static uint64_t snapshot_hash(uint64_t hash, const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ULL;
+    }
+    for (; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+#define SNAPSHOT_HASH_SEED 14695981039346656037ULL
+
+static double snapshot_elapsed_ms(const struct timespec* start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) * 1000.0 + (double)(now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+// Makes the rename itself durable
+static void snapshot_sync_directory(const char* path) {
+    char directory[512];
+    snprintf(directory, sizeof(directory), "%s", path);
+    char* slash = strrchr(directory, '/');
+    if (slash == directory) {
+        slash[1] = '\0';
+    } else if (slash) {
+        *slash = '\0';
+    } else {
+        strcpy(directory, ".");
+    }
+
+    int fd = open(directory, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+// ============================================================================
+// FILES
+// ============================================================================
+
+// Copies the fleet shard by shard while the simulation and commands keep
+// running, then the live session tokens, and replaces path atomically
+int snapshot_save(const char* path, fleet_t* fleet, token_table_t* tokens, snapshot_info_t* info) {
+    if (!path || !fleet || !fleet->shards) return -1;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    char temporary[512];
+    if ((size_t)snprintf(temporary, sizeof(temporary), "%s.tmp", path) >= sizeof(temporary)) return -1;
+    FILE* file = fopen(temporary, "wb");
+    if (!file) {
+        perror("Error creating snapshot");
+        return -1;
+    }
+    setvbuf(file, NULL, _IOFBF, SNAPSHOT_BUFFER);
+
+    snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+    uint64_t hash = SNAPSHOT_HASH_SEED;
+    fleet_shard_image_t image;
+    for (int shard = 0; ok && shard < fleet->shard_count; shard++) {
+        fleet_export_shard(fleet, shard, &image);
+        hash = snapshot_hash(hash, &image, sizeof(image));
+        ok = fwrite(&image, sizeof(image), 1, file) == 1;
+    }
+
+    int token_count = 0;
+    int capacity = token_table_capacity(tokens);
+    if (ok && capacity > 0) {
+        token_entry_t* entries = malloc((size_t)capacity * sizeof(token_entry_t));
+        if (entries) {
+            token_count = token_table_export(tokens, entries, capacity);
+            hash = snapshot_hash(hash, entries, (size_t)token_count * sizeof(token_entry_t));
+            ok = fwrite(entries, sizeof(token_entry_t), (size_t)token_count, file) == (size_t)token_count;
+            free(entries);
+        }
+    }
+
+    // The header goes in last, once the checksum is known
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.shard_size = FLEET_SHARD_SIZE;
+    header.vehicle_count = (uint32_t)fleet->count;
+    header.shard_count = (uint32_t)fleet->shard_count;
+    header.token_count = (uint32_t)token_count;
+    header.saved_ms = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    header.checksum = hash;
+    if (ok) {
+        ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fflush(file) == 0 && fsync(fileno(file)) == 0;
+    }
+    if (fclose(file) != 0) ok = 0;
+    if (!ok || rename(temporary, path) != 0) {
+        perror("Error writing snapshot");
+        unlink(temporary);
+        return -1;
+    }
+    snapshot_sync_directory(path);
+
+    if (info) {
+        info->vehicles = fleet->count;
+        info->tokens = token_count;
+        info->saved_ms = header.saved_ms;
+        info->bytes = sizeof(header) + (size_t)fleet->shard_count * sizeof(fleet_shard_image_t) +
+                      (size_t)token_count * sizeof(token_entry_t);
+        info->elapsed_ms = snapshot_elapsed_ms(&start);
+    }
+    return 0;
+}
+
+// Restores a snapshot into a fleet that has not started its simulation.
+// A snapshot of a different fleet size restores the vehicles both have.
+// Returns 1 if there is no snapshot, -1 if it is not a valid one; the fleet
+// is untouched in both cases.
+int snapshot_load(const char* path, fleet_t* fleet, token_table_t* tokens, snapshot_info_t* info) {
+    if (!path || !fleet || !fleet->shards) return -1;
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) return 1;
+        perror("Error opening snapshot");
+        return -1;
+    }
+    struct stat file_info;
+    if (fstat(fd, &file_info) != 0 || (size_t)file_info.st_size < sizeof(snapshot_header_t)) {
+        fprintf(stderr, "Snapshot %s is truncated\n", path);
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)file_info.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Error mapping snapshot");
+        return -1;
+    }
+
+    const snapshot_header_t* header = (const snapshot_header_t*)map;
+    const unsigned char* body = (const unsigned char*)map + sizeof(snapshot_header_t);
+    size_t expected = sizeof(snapshot_header_t) + (size_t)header->shard_count * sizeof(fleet_shard_image_t) +
+                      (size_t)header->token_count * sizeof(token_entry_t);
+    if (header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION ||
+        header->shard_size != FLEET_SHARD_SIZE || expected != size ||
+        header->vehicle_count > (uint64_t)header->shard_count * FLEET_SHARD_SIZE ||
+        snapshot_hash(SNAPSHOT_HASH_SEED, body, size - sizeof(snapshot_header_t)) != header->checksum) {
+        fprintf(stderr, "Snapshot %s is not valid (version %d expected)\n", path, SNAPSHOT_VERSION);
+        munmap(map, size);
+        return -1;
+    }
+
+    const fleet_shard_image_t* images = (const fleet_shard_image_t*)body;
+    int vehicles = (int)header->vehicle_count < fleet->count ? (int)header->vehicle_count : fleet->count;
+    for (int shard = 0; shard * FLEET_SHARD_SIZE < vehicles; shard++) {
+        fleet_import_shard(fleet, shard, &images[shard], vehicles - shard * FLEET_SHARD_SIZE);
+    }
+
+    const token_entry_t* entries =
+        (const token_entry_t*)(body + (size_t)header->shard_count * sizeof(fleet_shard_image_t));
+    int kept = tokens ? token_table_import(tokens, entries, (int)header->token_count) : 0;
+
+    if (info) {
+        info->vehicles = vehicles;
+        info->tokens = kept;
+        info->saved_ms = header->saved_ms;
+        info->bytes = size;
+        info->elapsed_ms = snapshot_elapsed_ms(&start);
+    }
+    munmap(map, size);
+    return 0;
+}
+
+// ============================================================================
+// PERIODIC WRITER
+// ============================================================================
+
+static void* snapshot_writer_thread(void* arg) {
+    snapshot_writer_t* writer = (snapshot_writer_t*)arg;
+    struct timespec poll = {0, SNAPSHOT_POLL_MS * 1000000L};
+    long waited_ms = 0;
+
+    while (__atomic_load_n(&writer->running, __ATOMIC_ACQUIRE)) {
+        nanosleep(&poll, NULL);
+        waited_ms += SNAPSHOT_POLL_MS;
+        if (waited_ms < (long)writer->interval * 1000) continue;
+
+        waited_ms = 0;
+        if (snapshot_save(writer->path, writer->fleet, writer->tokens, &writer->last) == 0) writer->saves++;
+    }
+    return NULL;
+}
+
+int snapshot_writer_start(snapshot_writer_t* writer, const char* path, int interval, fleet_t* fleet,
+                          token_table_t* tokens) {
+    if (!writer || !path || !fleet || interval <= 0) return -1;
+
+    memset(writer, 0, sizeof(snapshot_writer_t));
+    if (strlen(path) >= sizeof(writer->path)) {
+        fprintf(stderr, "Snapshot path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(writer->path, path);
+    writer->interval = interval;
+    writer->fleet = fleet;
+    writer->tokens = tokens;
+    writer->running = 1;
+    if (pthread_create(&writer->thread, NULL, snapshot_writer_thread, writer) != 0) {
+        perror("Error creating snapshot thread");
+        writer->running = 0;
+        return -1;
+    }
+    return 0;
+}
+
+// A clean shutdown leaves a snapshot of the final state
+void snapshot_writer_stop(snapshot_writer_t* writer) {
+    if (!writer || !writer->running) return;
+
+    __atomic_store_n(&writer->running, 0, __ATOMIC_RELEASE);
+    pthread_join(writer->thread, NULL);
+    if (snapshot_save(writer->path, writer->fleet, writer->tokens, &writer->last) == 0) writer->saves++;
+}
@@ -0,0 +1,69 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "fleet.h"
+#include "token.h"
+
+// Snapshot constants
+#define SNAPSHOT_MAGIC 0x4e535456       // "VTSN"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_DEFAULT_INTERVAL 30    // seconds between periodic snapshots
+#define SNAPSHOT_POLL_MS 100            // writer thread: recheck for shutdown
+#define SNAPSHOT_BUFFER (1 << 20)       // stdio buffer while writing
+
+// A snapshot file is
+//
+//   header   snapshot_header_t
+//   fleet    shard_count x fleet_shard_image_t
+//   tokens   token_count x token_entry_t
+//
+// It is written to <path>.tmp, synced and renamed over <path>, so <path> is
+// always a whole snapshot: the previous one or the new one. The checksum
+// covers everything after the header and is checked before anything is
+// restored.
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t shard_size;        // FLEET_SHARD_SIZE of the writer
+    uint32_t vehicle_count;
+    uint32_t shard_count;
+    uint32_t token_count;
+    uint32_t reserved;
+    int64_t saved_ms;           // Unix time
+    uint64_t checksum;          // FNV-1a
+} snapshot_header_t;
+
+// What a save or load covered
+typedef struct {
+    int vehicles;
+    int tokens;
+    long long saved_ms;
+    size_t bytes;
+    double elapsed_ms;
+} snapshot_info_t;
+
+// Saves every snapshot interval seconds, and once more when stopped
+typedef struct {
+    char path[256];
+    int interval;
+    fleet_t* fleet;
+    token_table_t* tokens;
+    pthread_t thread;
+    volatile int running;
+    unsigned long long saves;
+    snapshot_info_t last;
+} snapshot_writer_t;
+
+// Files
+int snapshot_save(const char* path, fleet_t* fleet, token_table_t* tokens, snapshot_info_t* info);
+int snapshot_load(const char* path, fleet_t* fleet, token_table_t* tokens, snapshot_info_t* info);
+
+// Periodic writer
+int snapshot_writer_start(snapshot_writer_t* writer, const char* path, int interval, fleet_t* fleet,
+                          token_table_t* tokens);
+void snapshot_writer_stop(snapshot_writer_t* writer);
+
+#endif // SNAPSHOT_H
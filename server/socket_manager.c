@@ -1,11 +1,14 @@
+#define _DEFAULT_SOURCE // SO_REUSEPORT
 #include "socket_manager.h"
 #include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/resource.h>
 
-int socket_manager_init(socket_manager_t* manager, int port) {
+static int socket_manager_open(socket_manager_t* manager, int port, int reuse_port) {
     if (!manager) return -1;
     
     // Create server socket
@@ -23,6 +26,13 @@ int socket_manager_init(socket_manager_t* manager, int port) {
         return -1;
     }
     
+    // Let several listeners share the port; the kernel balances accepts across them
+    if (reuse_port && setsockopt(manager->server_socket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        perror("Error configuring SO_REUSEPORT");
+        close(manager->server_socket);
+        return -1;
+    }
+    
     // Configure server address
     manager->server_addr.sin_family = AF_INET;
     manager->server_addr.sin_addr.s_addr = INADDR_ANY;
@@ -37,7 +47,7 @@ int socket_manager_init(socket_manager_t* manager, int port) {
     }
     
     // Listen for connections
-    if (listen(manager->server_socket, MAX_CLIENTS) < 0) {
+    if (listen(manager->server_socket, SOCKET_LISTEN_BACKLOG) < 0) {
         perror("Error listening for connections");
         close(manager->server_socket);
         return -1;
@@ -46,6 +56,29 @@ int socket_manager_init(socket_manager_t* manager, int port) {
     return 0;
 }
 
+int socket_manager_init(socket_manager_t* manager, int port) {
+    return socket_manager_open(manager, port, 0);
+}
+
+int socket_manager_init_reuseport(socket_manager_t* manager, int port) {
+    return socket_manager_open(manager, port, 1);
+}
+
+// Takes over a listener another process bound and handed over (upgrade.c)
+int socket_manager_adopt(socket_manager_t* manager, int server_socket) {
+    if (!manager || server_socket < 0) return -1;
+    
+    socklen_t length = sizeof(manager->server_addr);
+    if (getsockname(server_socket, (struct sockaddr*)&manager->server_addr, &length) != 0) {
+        perror("Error inspecting inherited listener");
+        return -1;
+    }
+    manager->server_socket = server_socket;
+    manager->port = ntohs(manager->server_addr.sin_port);
+    
+    return 0;
+}
+
 int socket_manager_accept_client(socket_manager_t* manager, struct sockaddr_in* client_addr) {
     if (!manager || !client_addr) return -1;
     
@@ -53,7 +86,7 @@ int socket_manager_accept_client(socket_manager_t* manager, struct sockaddr_in*
     int client_socket = accept(manager->server_socket, (struct sockaddr*)client_addr, &client_len);
     
     if (client_socket < 0) {
-        if (errno != EINTR) {
+        if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK) {
             perror("Error accepting connection");
         }
         return -1;
@@ -74,7 +107,10 @@ int socket_send_data(int socket, const char* data, size_t length) {
     
     ssize_t bytes_sent = send(socket, data, length, 0);
     if (bytes_sent < 0) {
-        perror("Error sending data");
+        // Non-blocking sockets report a full buffer through errno; not an error
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            perror("Error sending data");
+        }
         return -1;
     }
     
@@ -86,7 +122,9 @@ int socket_receive_data(int socket, char* buffer, size_t buffer_size) {
     
     ssize_t bytes_received = recv(socket, buffer, buffer_size - 1, 0);
     if (bytes_received < 0) {
-        perror("Error receiving data");
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            perror("Error receiving data");
+        }
         return -1;
     }
     
@@ -94,8 +132,39 @@ int socket_receive_data(int socket, char* buffer, size_t buffer_size) {
     return (int)bytes_received;
 }
 
+int socket_set_nonblocking(int socket) {
+    if (socket < 0) return -1;
+    
+    int flags = fcntl(socket, F_GETFL, 0);
+    if (flags < 0 || fcntl(socket, F_SETFL, flags | O_NONBLOCK) < 0) {
+        perror("Error setting socket non-blocking");
+        return -1;
+    }
+    
+    return 0;
+}
+
 void socket_close_connection(int socket) {
     if (socket >= 0) {
         close(socket);
     }
 }
+
+// Raises the soft descriptor limit toward what this many connections need,
+// up to the hard limit. Returns the limit now in effect, -1 if unknown.
+int socket_raise_fd_limit(int connections) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) return -1;
+    
+    rlim_t wanted = (rlim_t)connections + SOCKET_RESERVED_FDS;
+    if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < wanted) {
+        limit.rlim_cur = limit.rlim_max == RLIM_INFINITY || limit.rlim_max > wanted ? wanted : limit.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &limit) != 0) {
+            perror("Error raising descriptor limit");
+            getrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+    
+    if (limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur > (rlim_t)0x7FFFFFFF) return 0x7FFFFFFF;
+    return (int)limit.rlim_cur;
+}
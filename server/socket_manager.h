@@ -4,8 +4,12 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 
-// Network constants
+// Network constants (MAX_CLIENTS is the default registry capacity, see --max-clients)
+#ifndef MAX_CLIENTS
 #define MAX_CLIENTS 50
+#endif
+#define SOCKET_LISTEN_BACKLOG SOMAXCONN    // the kernel caps it at net.core.somaxconn
+#define SOCKET_RESERVED_FDS 64             // listeners, log file, epoll and eventfds
 #define BUFFER_SIZE 1024
 
 // Structure for socket information
@@ -17,10 +21,14 @@ typedef struct {
 
 // Socket management functions
 int socket_manager_init(socket_manager_t* manager, int port);
+int socket_manager_init_reuseport(socket_manager_t* manager, int port);
+int socket_manager_adopt(socket_manager_t* manager, int server_socket);
 int socket_manager_accept_client(socket_manager_t* manager, struct sockaddr_in* client_addr);
 void socket_manager_close(socket_manager_t* manager);
 int socket_send_data(int socket, const char* data, size_t length);
 int socket_receive_data(int socket, char* buffer, size_t buffer_size);
+int socket_set_nonblocking(int socket);
 void socket_close_connection(int socket);
+int socket_raise_fd_limit(int connections);
 
 #endif // SOCKET_MANAGER_H
@@ -0,0 +1,128 @@
+#include "stream.h"
+#include "wire.h"
+#include <string.h>
+#include <stdlib.h>
+
+// ============================================================================
+// INPUT FUNCTIONS
+// ============================================================================
+
+void stream_input_init(stream_input_t* input) {
+    if (!input) return;
+
+    input->start = 0;
+    input->length = 0;
+    input->protocol = STREAM_TEXT;
+    input->telemetry_hz = 0;
+    input->telemetry_delta = 0;
+}
+
+// Copies as much of data as fits; returns the number of bytes taken. Callers
+// drain complete messages with stream_input_next and append the rest.
+size_t stream_input_append(stream_input_t* input, const char* data, size_t length) {
+    if (!input || !data) return 0;
+
+    // Move the partial tail to the front before filling
+    if (input->start > 0) {
+        memmove(input->data, input->data + input->start, input->length - input->start);
+        input->length -= input->start;
+        input->start = 0;
+    }
+
+    size_t space = STREAM_INPUT_SIZE - 1 - input->length; // room for the NUL
+    size_t taken = length < space ? length : space;
+    memcpy(input->data + input->length, data, taken);
+    input->length += taken;
+    return taken;
+}
+
+// Binary mode: the next whole frame, header included. A frame too large to
+// ever fit is handed over truncated so the caller can reject it.
+static char* stream_input_next_frame(stream_input_t* input, size_t* length) {
+    char* frame = input->data + input->start;
+    size_t available = input->length - input->start;
+    if (available < WIRE_HEADER_SIZE) return NULL;
+
+    size_t size = WIRE_HEADER_SIZE + wire_payload_length((const unsigned char*)frame);
+    if (size > STREAM_INPUT_SIZE - 1) size = available;
+    else if (available < size) return NULL;
+
+    input->start += size;
+    if (length) *length = size;
+    return frame;
+}
+
+// Returns the next complete message, NUL-terminated in place without its
+// terminator, or NULL if only a partial message is buffered. In binary mode
+// the message is a whole frame and is not NUL-terminated. The pointer stays
+// valid until the next append.
+char* stream_input_next(stream_input_t* input, size_t* length) {
+    if (!input) return NULL;
+    if (input->protocol == STREAM_BINARY) return stream_input_next_frame(input, length);
+
+    // Line breaks between messages (e.g. from println) are not part of either
+    while (input->start < input->length &&
+           (input->data[input->start] == '\r' || input->data[input->start] == '\n')) {
+        input->start++;
+    }
+
+    char* message = input->data + input->start;
+    size_t available = input->length - input->start;
+    if (available == 0) return NULL;
+
+    for (size_t i = 0; i + STREAM_TERMINATOR_LEN <= available; i++) {
+        if (message[i] == '\r' && memcmp(message + i, STREAM_TERMINATOR, STREAM_TERMINATOR_LEN) == 0) {
+            message[i] = '\0';
+            input->start += i + STREAM_TERMINATOR_LEN;
+            if (length) *length = i;
+            return message;
+        }
+    }
+
+    // A message that fills the whole buffer can never complete: hand it over as is
+    if (available == STREAM_INPUT_SIZE - 1) {
+        message[available] = '\0';
+        input->start = input->length;
+        if (length) *length = available;
+        return message;
+    }
+    return NULL;
+}
+
+// ============================================================================
+// OUTPUT FUNCTIONS
+// ============================================================================
+
+void stream_output_init(stream_output_t* output) {
+    if (!output) return;
+
+    output->data = NULL;
+    output->length = 0;
+    output->capacity = 0;
+}
+
+int stream_output_append(stream_output_t* output, const char* data, size_t length) {
+    if (!output || !data) return -1;
+
+    if (output->length + length > output->capacity) {
+        size_t new_cap = output->capacity ? output->capacity : STREAM_OUTPUT_INITIAL;
+        while (new_cap < output->length + length) new_cap *= 2;
+        char* buffer = realloc(output->data, new_cap);
+        if (!buffer) return -1;
+        output->data = buffer;
+        output->capacity = new_cap;
+    }
+
+    memcpy(output->data + output->length, data, length);
+    output->length += length;
+    return 0;
+}
+
+void stream_output_cleanup(stream_output_t* output) {
+    if (!output) return;
+
+    free(output->data);
+    output->data = NULL;
+    output->length = 0;
+    output->capacity = 0;
+}
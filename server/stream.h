@@ -0,0 +1,47 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stddef.h>
+#include "socket_manager.h"
+
+// Stream constants
+#define STREAM_TERMINATOR "\r\n\r\n"    // ends every protocol message
+#define STREAM_TERMINATOR_LEN 4
+#define STREAM_INPUT_SIZE (4 * BUFFER_SIZE)
+#define STREAM_OUTPUT_INITIAL 2048
+
+// How the stream is framed; clients start in text and may switch with PROTOCOL:
+typedef enum {
+    STREAM_TEXT,        // messages end with STREAM_TERMINATOR
+    STREAM_BINARY       // length-prefixed frames, see wire.h
+} stream_protocol_t;
+#define STREAM_PROTOCOL_COUNT 2
+
+// Per-connection receive buffer that splits the byte stream into messages
+typedef struct {
+    char data[STREAM_INPUT_SIZE];
+    size_t start;       // first unconsumed byte
+    size_t length;      // end of buffered bytes
+    stream_protocol_t protocol;
+    int telemetry_hz;   // SUBSCRIBE rate, 0 = periodic broadcast only
+    int telemetry_delta; // SUBSCRIBE ... DELTA: changed fields only
+} stream_input_t;
+
+// Responses produced from one read, written out together
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} stream_output_t;
+
+// Input functions
+void stream_input_init(stream_input_t* input);
+size_t stream_input_append(stream_input_t* input, const char* data, size_t length);
+char* stream_input_next(stream_input_t* input, size_t* length);
+
+// Output functions
+void stream_output_init(stream_output_t* output);
+int stream_output_append(stream_output_t* output, const char* data, size_t length);
+void stream_output_cleanup(stream_output_t* output);
+
+#endif // STREAM_H
@@ -0,0 +1,115 @@
+#include "subscription.h"
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// Clients per rate group, updated by whichever thread runs the SUBSCRIBE
+static int group_members[SUBSCRIBE_GROUP_COUNT];
+
+// ============================================================================
+// SCHEDULER FUNCTIONS
+// ============================================================================
+
+int subscription_scheduler_init(subscription_scheduler_t* scheduler, int broadcast_interval_seconds) {
+    if (!scheduler || broadcast_interval_seconds <= 0) return -1;
+
+    scheduler->tick = 0;
+    scheduler->broadcast_ticks = (unsigned)broadcast_interval_seconds * SUBSCRIBE_TICK_HZ;
+
+    scheduler->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (scheduler->timer_fd < 0) {
+        perror("Error creating telemetry timer");
+        return -1;
+    }
+
+    struct itimerspec period;
+    period.it_interval.tv_sec = 0;
+    period.it_interval.tv_nsec = 1000000000L / SUBSCRIBE_TICK_HZ;
+    period.it_value = period.it_interval;
+    if (timerfd_settime(scheduler->timer_fd, 0, &period, NULL) != 0) {
+        perror("Error arming telemetry timer");
+        close(scheduler->timer_fd);
+        scheduler->timer_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+// Blocks until the next tick and marks the groups due on it. A group is due
+// when its rate crosses a period boundary between the previous tick and this
+// one, which spreads e.g. 30 Hz evenly over the 100 ticks of a second; ticks
+// missed while the thread was busy fold into one frame. Empty subscription
+// groups are never due. Returns the number of groups due, -1 on error.
+int subscription_scheduler_wait(subscription_scheduler_t* scheduler, subscription_mask_t* mask) {
+    if (!scheduler || !mask) return -1;
+
+    memset(mask, 0, sizeof(*mask));
+    uint64_t expirations;
+    if (read(scheduler->timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        if (errno == EINTR) return 0;
+        perror("Error reading telemetry timer");
+        return -1;
+    }
+
+    unsigned long long previous = scheduler->tick;
+    unsigned long long now = previous + expirations;
+    scheduler->tick = now;
+
+    int due = 0;
+    if (now / scheduler->broadcast_ticks != previous / scheduler->broadcast_ticks) {
+        mask->due[SUBSCRIBE_BROADCAST_GROUP] = 1;
+        due++;
+    }
+    for (int hz = SUBSCRIBE_MIN_HZ; hz <= SUBSCRIBE_MAX_HZ; hz++) {
+        if (__atomic_load_n(&group_members[hz], __ATOMIC_RELAXED) == 0) continue;
+        if (now * hz / SUBSCRIBE_TICK_HZ != previous * hz / SUBSCRIBE_TICK_HZ) {
+            mask->due[hz] = 1;
+            due++;
+        }
+    }
+    return due;
+}
+
+void subscription_scheduler_cleanup(subscription_scheduler_t* scheduler) {
+    if (!scheduler) return;
+
+    if (scheduler->timer_fd >= 0) close(scheduler->timer_fd);
+    scheduler->timer_fd = -1;
+}
+
+// ============================================================================
+// GROUP MEMBERSHIP
+// ============================================================================
+
+// Moves one client between groups; 0 stands for no subscription
+void subscription_move(int from_hz, int to_hz) {
+    if (from_hz == to_hz) return;
+
+    if (from_hz >= SUBSCRIBE_MIN_HZ && from_hz <= SUBSCRIBE_MAX_HZ) {
+        __atomic_fetch_sub(&group_members[from_hz], 1, __ATOMIC_RELAXED);
+    }
+    if (to_hz >= SUBSCRIBE_MIN_HZ && to_hz <= SUBSCRIBE_MAX_HZ) {
+        __atomic_fetch_add(&group_members[to_hz], 1, __ATOMIC_RELAXED);
+    }
+}
+
+int subscription_members(int hz) {
+    if (hz < SUBSCRIBE_MIN_HZ || hz > SUBSCRIBE_MAX_HZ) return 0;
+    return __atomic_load_n(&group_members[hz], __ATOMIC_RELAXED);
+}
+
+// Accepts a whole number of Hz in range, or 0 to unsubscribe
+int subscription_parse_rate(const char* text, int* hz) {
+    if (!text || !hz || *text == '\0') return -1;
+
+    char* end;
+    long value = strtol(text, &end, 10);
+    if (*end != '\0' || value < 0 || value > SUBSCRIBE_MAX_HZ) return -1;
+
+    *hz = (int)value;
+    return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef SUBSCRIPTION_H
+#define SUBSCRIPTION_H
+
+// Subscription constants
+#define SUBSCRIBE_MIN_HZ 1
+#define SUBSCRIBE_MAX_HZ 100
+#define SUBSCRIBE_TICK_HZ SUBSCRIBE_MAX_HZ          // scheduler resolution
+#define SUBSCRIBE_GROUP_COUNT (SUBSCRIBE_MAX_HZ + 1)
+#define SUBSCRIBE_BROADCAST_GROUP 0                 // unsubscribed: periodic broadcast only
+
+// Rate groups that get the frame of one tick, indexed by rate in Hz
+// (SUBSCRIBE_BROADCAST_GROUP for clients that never subscribed)
+typedef struct {
+    unsigned char due[SUBSCRIBE_GROUP_COUNT];
+} subscription_mask_t;
+
+// One timerfd drives every subscription: each tick wakes the telemetry thread
+// once, and all groups whose rate falls on that tick share one formatted frame
+typedef struct {
+    int timer_fd;
+    unsigned long long tick;    // ticks elapsed since init
+    unsigned broadcast_ticks;   // ticks between periodic broadcasts
+} subscription_scheduler_t;
+
+// Scheduler functions
+int subscription_scheduler_init(subscription_scheduler_t* scheduler, int broadcast_interval_seconds);
+int subscription_scheduler_wait(subscription_scheduler_t* scheduler, subscription_mask_t* mask);
+void subscription_scheduler_cleanup(subscription_scheduler_t* scheduler);
+
+// Group membership, server-wide
+void subscription_move(int from_hz, int to_hz);
+int subscription_members(int hz);
+int subscription_parse_rate(const char* text, int* hz);
+
+#endif // SUBSCRIPTION_H
@@ -0,0 +1,224 @@
+#include "telemetry.h"
+#include "wire.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Worst case: every group due with a delta entry
+#define TELEMETRY_RECORD_MAX (2 + SUBSCRIBE_GROUP_COUNT + 4 + BUFFER_SIZE + WIRE_TELEMETRY_FRAME_SIZE + 1 + \
+                              SUBSCRIBE_GROUP_COUNT * (3 + TELEMETRY_DELTA_TEXT_MAX + WIRE_DELTA_FRAME_MAX))
+
+// ============================================================================
+// RECORD HELPERS
+// ============================================================================
+
+static void put_u16(unsigned char* out, size_t value) {
+    out[0] = (unsigned char)(value & 0xFF);
+    out[1] = (unsigned char)((value >> 8) & 0xFF);
+}
+
+static size_t get_u16(const unsigned char* in) {
+    return (size_t)in[0] | ((size_t)in[1] << 8);
+}
+
+// Fields that differ between two frames, as WIRE_DELTA_* bits
+static unsigned telemetry_changed_fields(const vehicle_snapshot_t* last, const vehicle_snapshot_t* now) {
+    unsigned fields = 0;
+    if (last->speed != now->speed) fields |= WIRE_DELTA_SPEED;
+    if (last->battery != now->battery) fields |= WIRE_DELTA_BATTERY;
+    if (last->temperature != now->temperature) fields |= WIRE_DELTA_TEMPERATURE;
+    if (last->direction != now->direction) fields |= WIRE_DELTA_DIRECTION;
+    return fields;
+}
+
+// "DELTA: speed=10 direction=LEFT", or "DELTA:" for a heartbeat
+static size_t telemetry_format_delta(unsigned fields, const vehicle_snapshot_t* snapshot, char* out, size_t size) {
+    int length = snprintf(out, size, "DELTA:");
+    if (fields & WIRE_DELTA_SPEED) {
+        length += snprintf(out + length, size - (size_t)length, " speed=%d", snapshot->speed);
+    }
+    if (fields & WIRE_DELTA_BATTERY) {
+        length += snprintf(out + length, size - (size_t)length, " battery=%d", snapshot->battery);
+    }
+    if (fields & WIRE_DELTA_TEMPERATURE) {
+        length += snprintf(out + length, size - (size_t)length, " temperature=%d", snapshot->temperature);
+    }
+    if (fields & WIRE_DELTA_DIRECTION) {
+        length += snprintf(out + length, size - (size_t)length, " direction=%s",
+                           vehicle_direction_to_string(snapshot->direction));
+    }
+    length += snprintf(out + length, size - (size_t)length, STREAM_TERMINATOR);
+    return (size_t)length;
+}
+
+// Decides what a due group's delta clients get and moves its state forward
+static telemetry_kind_t telemetry_group_step(telemetry_group_t* group, unsigned long long tick,
+                                             const vehicle_snapshot_t* snapshot, unsigned* fields) {
+    const unsigned long long keyframe_ticks = (unsigned long long)TELEMETRY_KEYFRAME_SECONDS * SUBSCRIBE_TICK_HZ;
+    const unsigned long long heartbeat_ticks = (unsigned long long)TELEMETRY_HEARTBEAT_SECONDS * SUBSCRIBE_TICK_HZ;
+
+    if (!group->has_last || tick - group->last_keyframe >= keyframe_ticks) {
+        group->last = *snapshot;
+        group->has_last = 1;
+        group->last_keyframe = tick;
+        group->last_sent = tick;
+        return TELEMETRY_KEYFRAME;
+    }
+
+    *fields = telemetry_changed_fields(&group->last, snapshot);
+    if (*fields == 0 && tick - group->last_sent < heartbeat_ticks) {
+        return TELEMETRY_SKIP;
+    }
+    group->last = *snapshot;
+    group->last_sent = tick;
+    return TELEMETRY_DELTA;
+}
+
+// ============================================================================
+// ENCODER FUNCTIONS
+// ============================================================================
+
+int telemetry_encoder_init(telemetry_encoder_t* encoder) {
+    if (!encoder) return -1;
+
+    memset(encoder, 0, sizeof(telemetry_encoder_t));
+    encoder->data = malloc(TELEMETRY_RECORD_MAX);
+    if (!encoder->data) {
+        perror("Error allocating telemetry encoder");
+        return -1;
+    }
+    encoder->capacity = TELEMETRY_RECORD_MAX;
+    return 0;
+}
+
+// Builds the record for one tick in encoder->data: the keyframe in both
+// protocols, formatted once, and one delta per due group that has changes
+int telemetry_encode_tick(telemetry_encoder_t* encoder, const subscription_mask_t* mask, unsigned long long tick,
+                          const vehicle_snapshot_t* snapshot, time_t timestamp) {
+    if (!encoder || !encoder->data || !mask || !snapshot) return -1;
+
+    unsigned char* out = (unsigned char*)encoder->data;
+    unsigned char* groups = out + 2;
+    size_t length = 2 + SUBSCRIBE_GROUP_COUNT;
+
+    // Keyframe
+    char text[BUFFER_SIZE];
+    vehicle_format_snapshot(snapshot, timestamp, text, sizeof(text));
+    size_t text_length = strlen(text);
+    put_u16(out + length, text_length);
+    put_u16(out + length + 2, WIRE_TELEMETRY_FRAME_SIZE);
+    length += 4;
+    memcpy(out + length, text, text_length);
+    length += text_length;
+    length += wire_encode_telemetry(snapshot, timestamp, out + length);
+
+    // Deltas, each against what its group was sent last
+    unsigned char* delta_count = out + length++;
+    *delta_count = 0;
+    for (int group = 0; group < SUBSCRIBE_GROUP_COUNT; group++) {
+        if (!mask->due[group]) {
+            groups[group] = 0;
+            continue;
+        }
+
+        unsigned fields = 0;
+        telemetry_kind_t kind = telemetry_group_step(&encoder->groups[group], tick, snapshot, &fields);
+        groups[group] = (unsigned char)(1 + kind);
+        if (kind != TELEMETRY_DELTA) continue;
+
+        unsigned char* entry = out + length;
+        entry[0] = (unsigned char)group;
+        size_t delta_text = telemetry_format_delta(fields, snapshot, (char*)entry + 3, TELEMETRY_DELTA_TEXT_MAX);
+        size_t delta_binary = wire_encode_delta(fields, snapshot, entry + 3 + delta_text);
+        entry[1] = (unsigned char)delta_text;
+        entry[2] = (unsigned char)delta_binary;
+        length += 3 + delta_text + delta_binary;
+        (*delta_count)++;
+    }
+
+    put_u16(out, length);
+    encoder->length = length;
+    return 0;
+}
+
+void telemetry_encoder_cleanup(telemetry_encoder_t* encoder) {
+    if (!encoder) return;
+
+    free(encoder->data);
+    encoder->data = NULL;
+    encoder->length = 0;
+    encoder->capacity = 0;
+}
+
+// ============================================================================
+// RECORD FUNCTIONS
+// ============================================================================
+
+// Maps the record at the start of data. Returns its size, 0 if data does not
+// hold a whole record.
+size_t telemetry_tick_read(const char* data, size_t length, telemetry_tick_t* tick) {
+    if (!data || !tick || length < 2) return 0;
+
+    const unsigned char* in = (const unsigned char*)data;
+    size_t size = get_u16(in);
+    if (size > length || size < 2 + SUBSCRIBE_GROUP_COUNT + 5) return 0;
+
+    tick->groups = in + 2;
+    const unsigned char* p = tick->groups + SUBSCRIBE_GROUP_COUNT;
+    tick->keyframe_length[STREAM_TEXT] = get_u16(p);
+    tick->keyframe_length[STREAM_BINARY] = get_u16(p + 2);
+    tick->keyframe[STREAM_TEXT] = (const char*)p + 4;
+    tick->keyframe[STREAM_BINARY] = tick->keyframe[STREAM_TEXT] + tick->keyframe_length[STREAM_TEXT];
+    p += 4 + tick->keyframe_length[STREAM_TEXT] + tick->keyframe_length[STREAM_BINARY];
+    tick->delta_count = *p;
+    tick->deltas = p + 1;
+    return size;
+}
+
+// Marks every group due on any of the concatenated records in data
+void telemetry_ticks_due(const char* data, size_t length, subscription_mask_t* mask) {
+    if (!mask) return;
+
+    memset(mask, 0, sizeof(*mask));
+    telemetry_tick_t tick;
+    size_t size;
+    while ((size = telemetry_tick_read(data, length, &tick)) > 0) {
+        data += size;
+        length -= size;
+        for (int group = 0; group < SUBSCRIBE_GROUP_COUNT; group++) {
+            if (tick.groups[group]) mask->due[group] = 1;
+        }
+    }
+}
+
+// Picks the frame a client of group gets on this tick. Clients without delta
+// get the keyframe whenever their group is due; delta clients get what their
+// group's entry says, or the keyframe when resync is set (just subscribed, or
+// a frame was lost). Returns TELEMETRY_SKIP if nothing goes out.
+telemetry_kind_t telemetry_tick_select(const telemetry_tick_t* tick, int group, stream_protocol_t protocol,
+                                       int delta, int resync, const char** data, size_t* length) {
+    if (!tick || !data || !length || group < 0 || group >= SUBSCRIBE_GROUP_COUNT) return TELEMETRY_SKIP;
+    if (tick->groups[group] == 0) return TELEMETRY_SKIP;
+
+    telemetry_kind_t kind = (telemetry_kind_t)(tick->groups[group] - 1);
+    if (!delta || resync) kind = TELEMETRY_KEYFRAME;
+
+    if (kind == TELEMETRY_KEYFRAME) {
+        *data = tick->keyframe[protocol];
+        *length = tick->keyframe_length[protocol];
+        return kind;
+    }
+    if (kind == TELEMETRY_SKIP) return kind;
+
+    const unsigned char* entry = tick->deltas;
+    for (int i = 0; i < tick->delta_count; i++) {
+        const char* text = (const char*)entry + 3;
+        if (entry[0] == group) {
+            *data = protocol == STREAM_BINARY ? text + entry[1] : text;
+            *length = protocol == STREAM_BINARY ? entry[2] : entry[1];
+            return TELEMETRY_DELTA;
+        }
+        entry += 3 + entry[1] + entry[2];
+    }
+    return TELEMETRY_SKIP;
+}
@@ -0,0 +1,67 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stddef.h>
+#include <time.h>
+#include "vehicle.h"
+#include "stream.h"
+#include "subscription.h"
+
+// Telemetry constants
+#define TELEMETRY_KEYFRAME_SECONDS 10   // delta clients get a full frame at least this often
+#define TELEMETRY_HEARTBEAT_SECONDS 1   // empty delta after this long without changes
+#define TELEMETRY_DELTA_TEXT_MAX 96
+
+// What the delta clients of a due group get on a tick
+typedef enum {
+    TELEMETRY_SKIP,         // nothing changed and no heartbeat due
+    TELEMETRY_DELTA,        // the changed fields, or an empty heartbeat
+    TELEMETRY_KEYFRAME      // the full frame
+} telemetry_kind_t;
+
+// One tick as posted to the fan-out, built once by the telemetry thread:
+//   <u16 record size> <group byte * SUBSCRIBE_GROUP_COUNT>
+//   <u16 text length> <u16 binary length> <text keyframe> <binary keyframe>
+//   <u8 delta count> { <u8 group> <u8 text length> <u8 binary length> <text> <binary> }
+// A group byte is 0 if the group is not due, else 1 + its telemetry_kind_t;
+// only TELEMETRY_DELTA groups have an entry. Records are concatenated in
+// broadcast queues, so nothing in them is aligned.
+
+// Delta state of one rate group, against the last frame the group was sent
+typedef struct {
+    vehicle_snapshot_t last;
+    int has_last;
+    unsigned long long last_sent;       // ticks
+    unsigned long long last_keyframe;
+} telemetry_group_t;
+
+// Owned by the telemetry thread
+typedef struct {
+    telemetry_group_t groups[SUBSCRIBE_GROUP_COUNT];
+    char* data;         // the record of the last tick
+    size_t length;
+    size_t capacity;
+} telemetry_encoder_t;
+
+// Read-only view of one record
+typedef struct {
+    const unsigned char* groups;
+    const char* keyframe[STREAM_PROTOCOL_COUNT];
+    size_t keyframe_length[STREAM_PROTOCOL_COUNT];
+    const unsigned char* deltas;
+    int delta_count;
+} telemetry_tick_t;
+
+// Encoder functions
+int telemetry_encoder_init(telemetry_encoder_t* encoder);
+int telemetry_encode_tick(telemetry_encoder_t* encoder, const subscription_mask_t* mask, unsigned long long tick,
+                          const vehicle_snapshot_t* snapshot, time_t timestamp);
+void telemetry_encoder_cleanup(telemetry_encoder_t* encoder);
+
+// Record functions
+size_t telemetry_tick_read(const char* data, size_t length, telemetry_tick_t* tick);
+void telemetry_ticks_due(const char* data, size_t length, subscription_mask_t* mask);
+telemetry_kind_t telemetry_tick_select(const telemetry_tick_t* tick, int group, stream_protocol_t protocol,
+                                       int delta, int resync, const char** data, size_t* length);
+
+#endif // TELEMETRY_H
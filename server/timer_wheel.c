@@ -0,0 +1,115 @@
+#include "timer_wheel.h"
+#include <string.h>
+
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_SPAN (1ULL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS))
+
+// ============================================================================
+// SLOT LISTS
+// ============================================================================
+
+static void timer_link(timer_entry_t** head, timer_entry_t* entry) {
+    entry->next = *head;
+    if (entry->next) entry->next->pprev = &entry->next;
+    entry->pprev = head;
+    *head = entry;
+}
+
+static void timer_unlink(timer_entry_t* entry) {
+    *entry->pprev = entry->next;
+    if (entry->next) entry->next->pprev = entry->pprev;
+    entry->next = NULL;
+    entry->pprev = NULL;
+}
+
+// Lowest level whose span reaches the deadline. An entry at level n is at
+// least 64^n ticks away, so its slot there is never the one being emptied.
+static void timer_place(timer_wheel_t* wheel, timer_entry_t* entry) {
+    unsigned long long delta = entry->expires - wheel->now;
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= 1ULL << (TIMER_WHEEL_BITS * (level + 1))) {
+        level++;
+    }
+    int slot = (int)((entry->expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+    timer_link(&wheel->slots[level][slot], entry);
+}
+
+// ============================================================================
+// TIMER WHEEL FUNCTIONS
+// ============================================================================
+
+void timer_wheel_init(timer_wheel_t* wheel, unsigned long long now) {
+    if (!wheel) return;
+
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->now = now;
+}
+
+// Past deadlines fire on the next advance; ones beyond the wheel's span are
+// pulled in to its edge
+void timer_wheel_schedule(timer_wheel_t* wheel, timer_entry_t* entry, unsigned long long expires) {
+    if (!wheel || !entry) return;
+
+    if (entry->pprev) {
+        timer_unlink(entry);
+        wheel->count--;
+    }
+    if (expires < wheel->now) expires = wheel->now;
+    if (expires - wheel->now >= TIMER_WHEEL_SPAN) expires = wheel->now + TIMER_WHEEL_SPAN - 1;
+
+    entry->expires = expires;
+    timer_place(wheel, entry);
+    wheel->count++;
+}
+
+void timer_wheel_cancel(timer_wheel_t* wheel, timer_entry_t* entry) {
+    if (!wheel || !entry || !entry->pprev) return;
+
+    timer_unlink(entry);
+    wheel->count--;
+}
+
+// Moves one slot of a higher level down, now that the level below wrapped
+static void timer_cascade(timer_wheel_t* wheel, int level) {
+    int slot = (int)((wheel->now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK);
+    timer_entry_t* entry = wheel->slots[level][slot];
+    wheel->slots[level][slot] = NULL;
+
+    while (entry) {
+        timer_entry_t* next = entry->next;
+        entry->next = NULL;
+        entry->pprev = NULL;
+        timer_place(wheel, entry);
+        entry = next;
+    }
+}
+
+// Processes every tick up to and including now. Returns the entries that
+// fired, unlinked from the wheel and chained through next.
+timer_entry_t* timer_wheel_advance(timer_wheel_t* wheel, unsigned long long now) {
+    if (!wheel) return NULL;
+
+    timer_entry_t* expired = NULL;
+    while (wheel->now <= now) {
+        // Higher levels first, so entries they hand down can cascade again
+        int level = 1;
+        while (level < TIMER_WHEEL_LEVELS &&
+               (wheel->now & ((1ULL << (TIMER_WHEEL_BITS * level)) - 1)) == 0) {
+            level++;
+        }
+        while (--level > 0) {
+            timer_cascade(wheel, level);
+        }
+
+        timer_entry_t** slot = &wheel->slots[0][wheel->now & TIMER_WHEEL_MASK];
+        while (*slot) {
+            timer_entry_t* entry = *slot;
+            timer_unlink(entry);
+            wheel->count--;
+            entry->next = expired;
+            expired = entry;
+        }
+        wheel->now++;
+    }
+    return expired;
+}
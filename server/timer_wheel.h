@@ -0,0 +1,33 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+// Timer wheel constants
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)  // slots per level
+#define TIMER_WHEEL_LEVELS 4                        // 64^4 ticks (194 days of seconds) ahead
+
+// Timer embedded in the object it belongs to; not linked while pprev is NULL
+typedef struct timer_entry {
+    struct timer_entry* next;
+    struct timer_entry** pprev;     // the pointer that points here
+    unsigned long long expires;     // tick it fires on
+} timer_entry_t;
+
+// Hierarchical timing wheel. Level 0 has one slot per tick for the next 64
+// ticks; each level above covers 64 times the span of the one below, and its
+// slots are redistributed downwards when the level below wraps. Scheduling
+// and cancelling are O(1); advancing costs the expired entries plus, once
+// per 64 ticks, the entries moved down a level. Not thread-safe.
+typedef struct {
+    unsigned long long now;         // next tick to process; earlier ones have fired
+    timer_entry_t* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    int count;                      // entries scheduled
+} timer_wheel_t;
+
+// Timer wheel functions
+void timer_wheel_init(timer_wheel_t* wheel, unsigned long long now);
+void timer_wheel_schedule(timer_wheel_t* wheel, timer_entry_t* entry, unsigned long long expires);
+void timer_wheel_cancel(timer_wheel_t* wheel, timer_entry_t* entry);
+timer_entry_t* timer_wheel_advance(timer_wheel_t* wheel, unsigned long long now);
+
+#endif // TIMER_WHEEL_H
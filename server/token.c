@@ -0,0 +1,215 @@
+#include "token.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+
+static int64_t token_now(void) {
+    return (int64_t)time(NULL);
+}
+
+static uint32_t token_slot(const token_table_t* table, const uint8_t* token) {
+    uint32_t hash;
+    memcpy(&hash, token, sizeof(hash));
+    return hash & table->mask;
+}
+
+static void token_format(const uint8_t* token, char* text) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < TOKEN_BYTES; i++) {
+        text[i * 2] = digits[token[i] >> 4];
+        text[i * 2 + 1] = digits[token[i] & 0xf];
+    }
+    text[TOKEN_BYTES * 2] = '\0';
+}
+
+static int token_hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static int token_parse(const char* text, size_t length, uint8_t* token) {
+    if (!text || length != TOKEN_BYTES * 2) return -1;
+
+    for (int i = 0; i < TOKEN_BYTES; i++) {
+        int high = token_hex_digit(text[i * 2]);
+        int low = token_hex_digit(text[i * 2 + 1]);
+        if (high < 0 || low < 0) return -1;
+        token[i] = (uint8_t)(high << 4 | low);
+    }
+    return 0;
+}
+
+// Caller holds the mutex. Returns the slot to store a token in: a free or
+// expired one if the run has it, else the one closest to expiry.
+static token_entry_t* token_victim(token_table_t* table, const uint8_t* token, int64_t now) {
+    uint32_t slot = token_slot(table, token);
+    token_entry_t* victim = &table->entries[slot];
+    for (int i = 0; i < TOKEN_PROBE; i++) {
+        token_entry_t* entry = &table->entries[(slot + (uint32_t)i) & table->mask];
+        if (entry->expires <= now) return entry;
+        if (entry->expires < victim->expires) victim = entry;
+    }
+    return victim;
+}
+
+// Caller holds the mutex
+static token_entry_t* token_find(token_table_t* table, const uint8_t* token, int64_t now) {
+    uint32_t slot = token_slot(table, token);
+    for (int i = 0; i < TOKEN_PROBE; i++) {
+        token_entry_t* entry = &table->entries[(slot + (uint32_t)i) & table->mask];
+        if (entry->expires > now && memcmp(entry->token, token, TOKEN_BYTES) == 0) return entry;
+    }
+    return NULL;
+}
+
+// ============================================================================
+// TABLE LIFECYCLE
+// ============================================================================
+
+// Room for twice capacity sessions, rounded up to a power of two
+int token_table_init(token_table_t* table, int capacity, int ttl_seconds) {
+    if (!table) return -1;
+
+    memset(table, 0, sizeof(token_table_t));
+    table->random_fd = -1;
+    if (capacity <= 0 || ttl_seconds <= 0) return -1;
+
+    uint32_t slots = TOKEN_PROBE;
+    while (slots < (uint32_t)capacity * 2) slots <<= 1;
+
+    table->entries = calloc(slots, sizeof(token_entry_t));
+    if (!table->entries) {
+        perror("Error allocating session tokens");
+        return -1;
+    }
+    table->mask = slots - 1;
+    table->ttl = ttl_seconds;
+
+    table->random_fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (table->random_fd < 0) {
+        perror("Error opening /dev/urandom");
+        token_table_cleanup(table);
+        return -1;
+    }
+    if (pthread_mutex_init(&table->mutex, NULL) != 0) {
+        perror("Error initializing token mutex");
+        close(table->random_fd);
+        free(table->entries);
+        memset(table, 0, sizeof(token_table_t));
+        table->random_fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void token_table_cleanup(token_table_t* table) {
+    if (!table || !table->entries) return;
+
+    if (table->random_fd >= 0) {
+        close(table->random_fd);
+        pthread_mutex_destroy(&table->mutex);
+    }
+    free(table->entries);
+    memset(table, 0, sizeof(token_table_t));
+    table->random_fd = -1;
+}
+
+int token_table_capacity(const token_table_t* table) {
+    return table && table->entries ? (int)table->mask + 1 : 0;
+}
+
+// ============================================================================
+// SESSIONS
+// ============================================================================
+
+// New token for an authenticated client, written to text as
+// TOKEN_TEXT_SIZE bytes of hex. Returns -1 if the table is disabled.
+int token_issue(token_table_t* table, const char* username, unsigned flags, char* text) {
+    if (!table || !table->entries || !username || !text) return -1;
+
+    uint8_t token[TOKEN_BYTES];
+    if (read(table->random_fd, token, sizeof(token)) != (ssize_t)sizeof(token)) {
+        perror("Error reading /dev/urandom");
+        return -1;
+    }
+
+    int64_t now = token_now();
+    pthread_mutex_lock(&table->mutex);
+    token_entry_t* entry = token_victim(table, token, now);
+    memcpy(entry->token, token, TOKEN_BYTES);
+    entry->expires = now + table->ttl;
+    entry->flags = flags;
+    strncpy(entry->username, username, TOKEN_USERNAME_SIZE - 1);
+    entry->username[TOKEN_USERNAME_SIZE - 1] = '\0';
+    pthread_mutex_unlock(&table->mutex);
+
+    token_format(token, text);
+    return 0;
+}
+
+// Looks up a token given as hex and renews it. Returns -1 if it is unknown
+// or expired.
+int token_resume(token_table_t* table, const char* text, size_t length, char* username, size_t username_size,
+                 unsigned* flags) {
+    if (!table || !table->entries || !username || username_size == 0 || !flags) return -1;
+
+    uint8_t token[TOKEN_BYTES];
+    if (token_parse(text, length, token) != 0) return -1;
+
+    int64_t now = token_now();
+    pthread_mutex_lock(&table->mutex);
+    token_entry_t* entry = token_find(table, token, now);
+    if (entry) {
+        entry->expires = now + table->ttl;
+        *flags = entry->flags;
+        strncpy(username, entry->username, username_size - 1);
+        username[username_size - 1] = '\0';
+    }
+    pthread_mutex_unlock(&table->mutex);
+    return entry ? 0 : -1;
+}
+
+// ============================================================================
+// PERSISTENCE
+// ============================================================================
+
+// Copies the live entries, at most max_entries. Returns the number copied.
+int token_table_export(token_table_t* table, token_entry_t* entries, int max_entries) {
+    if (!table || !table->entries || !entries) return 0;
+
+    int count = 0;
+    int64_t now = token_now();
+    pthread_mutex_lock(&table->mutex);
+    for (uint32_t i = 0; i <= table->mask && count < max_entries; i++) {
+        if (table->entries[i].expires > now) entries[count++] = table->entries[i];
+    }
+    pthread_mutex_unlock(&table->mutex);
+    return count;
+}
+
+// Adds saved entries that have not expired. Returns the number kept.
+int token_table_import(token_table_t* table, const token_entry_t* entries, int count) {
+    if (!table || !table->entries || !entries) return 0;
+
+    int kept = 0;
+    int64_t now = token_now();
+    pthread_mutex_lock(&table->mutex);
+    for (int i = 0; i < count; i++) {
+        if (entries[i].expires <= now) continue;
+        token_entry_t* entry = token_victim(table, entries[i].token, now);
+        *entry = entries[i];
+        entry->username[TOKEN_USERNAME_SIZE - 1] = '\0';
+        kept++;
+    }
+    pthread_mutex_unlock(&table->mutex);
+    return kept;
+}
@@ -0,0 +1,52 @@
+#ifndef TOKEN_H
+#define TOKEN_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Token constants
+#define TOKEN_BYTES 16
+#define TOKEN_TEXT_SIZE (TOKEN_BYTES * 2 + 1)   // hex and the terminator
+#define TOKEN_USERNAME_SIZE 64                  // holds MAX_USERNAME
+#define TOKEN_DEFAULT_TTL_SECONDS 3600          // since issue or last resume
+#define TOKEN_PROBE 8                           // slots searched per token
+
+// One resumable session: who authenticated, with which client flags.
+// Expiry is wall-clock time so it still means something after a restart.
+typedef struct {
+    uint8_t token[TOKEN_BYTES];
+    int64_t expires;            // Unix seconds; 0 = free slot
+    uint32_t flags;
+    uint32_t reserved;
+    char username[TOKEN_USERNAME_SIZE];
+} token_entry_t;
+
+// Tokens issued on AUTH, shared by every shard. Tokens are random, so their
+// first bytes pick the slot; a token lives in one of the TOKEN_PROBE slots
+// after it. Issuing into a full run replaces the entry closest to expiry, so
+// the table never grows and the oldest sessions are the first to need AUTH
+// again.
+typedef struct token_table {
+    token_entry_t* entries;
+    uint32_t mask;
+    int ttl;
+    int random_fd;
+    pthread_mutex_t mutex;
+} token_table_t;
+
+// Table lifecycle
+int token_table_init(token_table_t* table, int capacity, int ttl_seconds);
+void token_table_cleanup(token_table_t* table);
+int token_table_capacity(const token_table_t* table);
+
+// Sessions
+int token_issue(token_table_t* table, const char* username, unsigned flags, char* text);
+int token_resume(token_table_t* table, const char* text, size_t length, char* username, size_t username_size,
+                 unsigned* flags);
+
+// Persistence (snapshot.c)
+int token_table_export(token_table_t* table, token_entry_t* entries, int max_entries);
+int token_table_import(token_table_t* table, const token_entry_t* entries, int count);
+
+#endif // TOKEN_H
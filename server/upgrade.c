@@ -0,0 +1,403 @@
+#include "upgrade.h"
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UPGRADE_MAX_FDS (1 << 20)       // closed before exec, whatever the limit says
+
+// ============================================================================
+// MESSAGES
+// ============================================================================
+
+// SOCK_SEQPACKET keeps each message whole, with its descriptor attached
+static int upgrade_socket(const char* path, struct sockaddr_un* address) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address->sun_path)) {
+        fprintf(stderr, "Upgrade socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(address->sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (fd < 0) perror("Error creating upgrade socket");
+    return fd;
+}
+
+// Neither side waits forever on a process that hung
+static void upgrade_set_timeout(int fd) {
+    struct timeval timeout = {UPGRADE_TIMEOUT_SECONDS, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+// descriptor < 0 sends the message alone
+static int upgrade_send(int fd, upgrade_type_t type, uint32_t count, int descriptor) {
+    upgrade_message_t message = {UPGRADE_MAGIC, UPGRADE_VERSION, (uint16_t)type, count, 0};
+    struct iovec iov = {&message, sizeof(message)};
+    struct msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+
+    union {
+        struct cmsghdr align;
+        char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    if (descriptor >= 0) {
+        memset(&control, 0, sizeof(control));
+        header.msg_control = control.buffer;
+        header.msg_controllen = sizeof(control.buffer);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&header);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &descriptor, sizeof(int));
+    }
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(fd, &header, 0);
+    } while (sent < 0 && errno == EINTR);
+    return sent == (ssize_t)sizeof(message) ? 0 : -1;
+}
+
+// A descriptor that arrives is stored in *descriptor, or closed if the
+// caller expects none
+static int upgrade_receive(int fd, upgrade_message_t* message, int* descriptor) {
+    struct iovec iov = {message, sizeof(*message)};
+    struct msghdr header;
+    memset(&header, 0, sizeof(header));
+    header.msg_iov = &iov;
+    header.msg_iovlen = 1;
+
+    union {
+        struct cmsghdr align;
+        char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    header.msg_control = control.buffer;
+    header.msg_controllen = sizeof(control.buffer);
+
+    ssize_t received;
+    do {
+        received = recvmsg(fd, &header, 0);
+    } while (received < 0 && errno == EINTR);
+
+    int passed = -1;
+    for (struct cmsghdr* cmsg = received > 0 ? CMSG_FIRSTHDR(&header) : NULL; cmsg;
+         cmsg = CMSG_NXTHDR(&header, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            memcpy(&passed, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+
+    int valid = received == (ssize_t)sizeof(*message) && message->magic == UPGRADE_MAGIC &&
+                message->version == UPGRADE_VERSION;
+    if ((!valid || !descriptor) && passed >= 0) {
+        close(passed);
+        passed = -1;
+    }
+    if (descriptor) *descriptor = passed;
+    return valid ? 0 : -1;
+}
+
+static void upgrade_state_path(const char* path, char* state, size_t size) {
+    snprintf(state, size, "%s%s", path, UPGRADE_STATE_SUFFIX);
+}
+
+// ============================================================================
+// RUNNING SERVER
+// ============================================================================
+
+// Only the standard streams cross over; the listeners come through the
+// control socket like for any other new process
+static void upgrade_spawn(upgrade_t* upgrade) {
+    long max_fd = sysconf(_SC_OPEN_MAX);
+    if (max_fd < 0 || max_fd > UPGRADE_MAX_FDS) max_fd = UPGRADE_MAX_FDS;
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("Error starting the new binary");
+        return;
+    }
+    if (pid == 0) {
+        for (int fd = 3; fd < (int)max_fd; fd++) {
+            close(fd);
+        }
+        execvp(upgrade->argv[0], upgrade->argv);
+        _exit(127);
+    }
+    upgrade->child = pid;
+    printf("Upgrade: started %s as pid %d\n", upgrade->argv[0], (int)pid);
+}
+
+// One takeover at a time; a mismatched one is refused and this server
+// carries on. Returns 1 once a new process is taking over.
+static int upgrade_accept(upgrade_t* upgrade) {
+    int peer = accept(upgrade->listen_fd, NULL, NULL);
+    if (peer < 0) return 0;
+    upgrade_set_timeout(peer);
+
+    upgrade_message_t hello;
+    if (upgrade_receive(peer, &hello, NULL) != 0 || hello.type != UPGRADE_HELLO) {
+        close(peer);
+        return 0;
+    }
+    if ((int)hello.count != upgrade->shard_count) {
+        fprintf(stderr, "Upgrade refused: the new process runs %u shard%s, this one %d\n", hello.count,
+                hello.count == 1 ? "" : "s", upgrade->shard_count);
+        upgrade_send(peer, UPGRADE_REFUSE, (uint32_t)upgrade->shard_count, -1);
+        close(peer);
+        return 0;
+    }
+    if (upgrade_send(peer, UPGRADE_ACCEPT, (uint32_t)upgrade->shard_count, -1) != 0) {
+        close(peer);
+        return 0;
+    }
+
+    printf("Upgrade: new process connected, handing over %d listener%s\n", upgrade->shard_count,
+           upgrade->shard_count > 1 ? "s" : "");
+    upgrade->peer_fd = peer;
+
+    // The path is the new process's to listen on once it has taken over
+    close(upgrade->listen_fd);
+    upgrade->listen_fd = -1;
+    unlink(upgrade->path);
+    return 1;
+}
+
+static void* upgrade_thread(void* arg) {
+    upgrade_t* upgrade = (upgrade_t*)arg;
+
+    while (__atomic_load_n(&upgrade->running, __ATOMIC_ACQUIRE)) {
+        if (upgrade->requested) {
+            upgrade->requested = 0;
+            upgrade_spawn(upgrade);
+        }
+
+        int status;
+        if (upgrade->child > 0 && waitpid(upgrade->child, &status, WNOHANG) == upgrade->child) {
+            fprintf(stderr, "Upgrade: pid %d exited before taking over (status %d)\n", (int)upgrade->child,
+                    WIFEXITED(status) ? WEXITSTATUS(status) : -1);
+            upgrade->child = 0;
+        }
+
+        struct pollfd pfd = {upgrade->listen_fd, POLLIN, 0};
+        if (poll(&pfd, 1, UPGRADE_POLL_MS) <= 0 || !(pfd.revents & POLLIN)) continue;
+        if (upgrade_accept(upgrade)) {
+            upgrade->stop();
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void upgrade_stop_thread(upgrade_t* upgrade) {
+    if (!__atomic_load_n(&upgrade->running, __ATOMIC_ACQUIRE)) return;
+
+    __atomic_store_n(&upgrade->running, 0, __ATOMIC_RELEASE);
+    pthread_join(upgrade->thread, NULL);
+}
+
+// Listens on path for a new binary taking over. A socket file left by a
+// server that is gone is replaced; one a server still answers on is not.
+int upgrade_listen(upgrade_t* upgrade, const char* path, int shard_count, int argc, char* argv[],
+                   void (*stop)(void)) {
+    if (!upgrade || !path || !argv || !stop) return -1;
+
+    memset(upgrade, 0, sizeof(upgrade_t));
+    upgrade->listen_fd = -1;
+    upgrade->peer_fd = -1;
+    struct sockaddr_un address;
+    int fd = upgrade_socket(path, &address);
+    if (fd < 0) return -1;
+    strcpy(upgrade->path, path);
+    upgrade->shard_count = shard_count;
+    upgrade->stop = stop;
+
+    int bound = bind(fd, (struct sockaddr*)&address, sizeof(address)) == 0;
+    if (!bound && errno == EADDRINUSE) {
+        int probe = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+        int live = probe >= 0 && connect(probe, (struct sockaddr*)&address, sizeof(address)) == 0;
+        if (probe >= 0) close(probe);
+        if (live) {
+            fprintf(stderr, "Upgrade socket %s belongs to a running server\n", path);
+            close(fd);
+            return -1;
+        }
+        unlink(path);
+        bound = bind(fd, (struct sockaddr*)&address, sizeof(address)) == 0;
+    }
+    if (!bound || listen(fd, 1) != 0) {
+        perror("Error listening on upgrade socket");
+        close(fd);
+        return -1;
+    }
+    upgrade->listen_fd = fd;
+
+    // The same command line, any earlier --takeover replaced by this one
+    upgrade->argv = calloc((size_t)argc + 3, sizeof(char*));
+    if (!upgrade->argv) {
+        upgrade_close(upgrade);
+        return -1;
+    }
+    int n = 0;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--takeover") == 0 && i + 1 < argc) {
+            i++;
+            continue;
+        }
+        upgrade->argv[n++] = argv[i];
+    }
+    upgrade->argv[n++] = (char*)"--takeover";
+    upgrade->argv[n] = upgrade->path;
+
+    upgrade->running = 1;
+    if (pthread_create(&upgrade->thread, NULL, upgrade_thread, upgrade) != 0) {
+        perror("Error creating upgrade thread");
+        upgrade->running = 0;
+        upgrade_close(upgrade);
+        return -1;
+    }
+    return 0;
+}
+
+// SIGUSR2: async-signal-safe, the control thread does the rest
+void upgrade_request(upgrade_t* upgrade) {
+    if (upgrade) upgrade->requested = 1;
+}
+
+// Once serving has stopped: hands every listener to the new process if one
+// is taking over. The caller still closes its own copies.
+int upgrade_send_listeners(upgrade_t* upgrade, const int* listeners, int count) {
+    if (!upgrade) return 0;
+
+    upgrade_stop_thread(upgrade);
+    if (upgrade->peer_fd < 0) return 0;
+
+    for (int i = 0; i < count; i++) {
+        if (upgrade_send(upgrade->peer_fd, UPGRADE_LISTENER, (uint32_t)i, listeners[i]) != 0) {
+            perror("Error handing over listener");
+            close(upgrade->peer_fd);
+            upgrade->peer_fd = -1;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Last step, once no client is left to change the fleet: the new process
+// waits for this before it starts its simulation
+void upgrade_send_state(upgrade_t* upgrade, fleet_t* fleet, token_table_t* tokens) {
+    if (!upgrade || upgrade->peer_fd < 0) return;
+
+    char state[sizeof(upgrade->path) + sizeof(UPGRADE_STATE_SUFFIX)];
+    upgrade_state_path(upgrade->path, state, sizeof(state));
+    snapshot_info_t info;
+    int saved = fleet && fleet->shards && snapshot_save(state, fleet, tokens, &info) == 0;
+
+    if (upgrade_send(upgrade->peer_fd, UPGRADE_STATE, saved ? 1 : 0, -1) != 0) {
+        perror("Error handing over state");
+        if (saved) unlink(state);
+    } else if (saved) {
+        printf("Upgrade: handed over %d vehicle%s and %d session%s\n", info.vehicles, info.vehicles == 1 ? "" : "s",
+               info.tokens, info.tokens == 1 ? "" : "s");
+    }
+    close(upgrade->peer_fd);
+    upgrade->peer_fd = -1;
+}
+
+void upgrade_close(upgrade_t* upgrade) {
+    if (!upgrade) return;
+
+    upgrade_stop_thread(upgrade);
+    if (upgrade->listen_fd >= 0) {
+        close(upgrade->listen_fd);
+        unlink(upgrade->path);
+        upgrade->listen_fd = -1;
+    }
+    if (upgrade->peer_fd >= 0) {
+        close(upgrade->peer_fd);
+        upgrade->peer_fd = -1;
+    }
+    free(upgrade->argv);
+    upgrade->argv = NULL;
+}
+
+// ============================================================================
+// NEW BINARY
+// ============================================================================
+
+// Receives the running server's listeners, one per shard. Returns the
+// connection the state comes on once the old process has closed its
+// clients, or -1 if it refused; it keeps serving then.
+int upgrade_takeover(const char* path, int shard_count, int* listeners) {
+    if (!path || !listeners || shard_count <= 0) return -1;
+
+    struct sockaddr_un address;
+    int connection = upgrade_socket(path, &address);
+    if (connection < 0) return -1;
+    if (connect(connection, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "Error connecting to upgrade socket %s: %s\n", path, strerror(errno));
+        close(connection);
+        return -1;
+    }
+    upgrade_set_timeout(connection);
+
+    upgrade_message_t message;
+    if (upgrade_send(connection, UPGRADE_HELLO, (uint32_t)shard_count, -1) != 0 ||
+        upgrade_receive(connection, &message, NULL) != 0) {
+        fprintf(stderr, "Upgrade: no answer from the running server\n");
+        close(connection);
+        return -1;
+    }
+    if (message.type != UPGRADE_ACCEPT) {
+        fprintf(stderr, "Upgrade refused: the running server has %u shard%s, this one %d\n", message.count,
+                message.count == 1 ? "" : "s", shard_count);
+        close(connection);
+        return -1;
+    }
+
+    for (int i = 0; i < shard_count; i++) {
+        listeners[i] = -1;
+    }
+    for (int i = 0; i < shard_count; i++) {
+        if (upgrade_receive(connection, &message, &listeners[i]) != 0 || message.type != UPGRADE_LISTENER ||
+            message.count != (uint32_t)i || listeners[i] < 0) {
+            fprintf(stderr, "Upgrade: listener %d did not arrive\n", i);
+            for (int j = 0; j <= i; j++) {
+                if (listeners[j] >= 0) close(listeners[j]);
+            }
+            close(connection);
+            return -1;
+        }
+    }
+    return connection;
+}
+
+// Waits for the old process to finish and loads what it handed over into a
+// fleet that has not started its simulation. Returns like snapshot_load.
+int upgrade_receive_state(int connection, const char* path, fleet_t* fleet, token_table_t* tokens,
+                          snapshot_info_t* info) {
+    upgrade_message_t message;
+    int received = upgrade_receive(connection, &message, NULL);
+    close(connection);
+    if (received != 0 || message.type != UPGRADE_STATE) {
+        fprintf(stderr, "Upgrade: no state from the old process, starting fresh\n");
+        return -1;
+    }
+    if (message.count == 0) return 1;
+
+    char state[sizeof(((struct sockaddr_un*)0)->sun_path) + sizeof(UPGRADE_STATE_SUFFIX)];
+    upgrade_state_path(path, state, sizeof(state));
+    int result = snapshot_load(state, fleet, tokens, info);
+    unlink(state);
+    return result;
+}
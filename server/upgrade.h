@@ -0,0 +1,76 @@
+#ifndef UPGRADE_H
+#define UPGRADE_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include "fleet.h"
+#include "snapshot.h"
+#include "token.h"
+
+// Upgrade constants
+#define UPGRADE_MAGIC 0x50555456        // "VTUP"
+#define UPGRADE_VERSION 1
+#define UPGRADE_POLL_MS 100             // control thread: recheck for SIGUSR2 and shutdown
+#define UPGRADE_TIMEOUT_SECONDS 30      // longest wait on the other process
+#define UPGRADE_STATE_SUFFIX ".state"   // snapshot handed over, next to the socket
+
+// Hot upgrade: a new binary takes the listening sockets of the running
+// server over a Unix socket, so the kernel keeps queueing connections on
+// them the whole time and none is refused.
+//
+//   new -> old   HELLO     count = shard count, which must match
+//   old -> new   ACCEPT    old stops accepting and serving
+//   old -> new   LISTENER  once per shard, count = shard, SCM_RIGHTS fd
+//   old -> new   STATE     once its clients are closed; count = 1 if
+//                          <path>.state holds the fleet and sessions
+//
+// The old process then exits. Its clients see the connection close,
+// reconnect and RESUME their session on the new process.
+typedef enum {
+    UPGRADE_HELLO = 1,
+    UPGRADE_ACCEPT,
+    UPGRADE_REFUSE,         // count = the shard count the old process runs
+    UPGRADE_LISTENER,
+    UPGRADE_STATE
+} upgrade_type_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t type;
+    uint32_t count;
+    uint32_t reserved;
+} upgrade_message_t;
+
+// The running server's side: a control socket and a thread waiting on it.
+// SIGUSR2 makes that thread start the new binary itself, argv[0] with the
+// same options plus --takeover.
+typedef struct {
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    int listen_fd;
+    int peer_fd;                // the new process, once accepted
+    int shard_count;
+    char** argv;                // NULL-terminated, for SIGUSR2
+    void (*stop)(void);         // stop serving, leaving the listeners open
+    pthread_t thread;
+    pid_t child;                // last binary started by SIGUSR2
+    volatile int running;
+    volatile int requested;     // SIGUSR2 seen
+} upgrade_t;
+
+// Running server
+int upgrade_listen(upgrade_t* upgrade, const char* path, int shard_count, int argc, char* argv[],
+                   void (*stop)(void));
+void upgrade_request(upgrade_t* upgrade);
+int upgrade_send_listeners(upgrade_t* upgrade, const int* listeners, int count);
+void upgrade_send_state(upgrade_t* upgrade, fleet_t* fleet, token_table_t* tokens);
+void upgrade_close(upgrade_t* upgrade);
+
+// New binary
+int upgrade_takeover(const char* path, int shard_count, int* listeners);
+int upgrade_receive_state(int connection, const char* path, fleet_t* fleet, token_table_t* tokens,
+                          snapshot_info_t* info);
+
+#endif // UPGRADE_H
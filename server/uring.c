@@ -0,0 +1,208 @@
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS
+#include "uring.h"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// ============================================================================
+// RING SETUP
+// ============================================================================
+
+// Failed setup: leaves the ring looking never initialized, so a later
+// uring_cleanup neither unmaps MAP_FAILED nor closes a reused descriptor
+static void uring_abort(uring_t* ring) {
+    close(ring->fd);
+    memset(ring, 0, sizeof(uring_t));
+    ring->fd = -1;
+}
+
+int uring_init(uring_t* ring, unsigned entries) {
+    if (!ring) return -1;
+
+    memset(ring, 0, sizeof(uring_t));
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        perror("Error creating io_uring");
+        ring->fd = -1;
+        return -1;
+    }
+
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) {
+        fprintf(stderr, "Error: kernel io_uring lacks SINGLE_MMAP/NODROP support\n");
+        uring_abort(ring);
+        return -1;
+    }
+
+    // SQ and CQ rings share one mapping
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->ring_size = sq_size > cq_size ? sq_size : cq_size;
+    ring->ring_ptr = mmap(NULL, ring->ring_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                          ring->fd, IORING_OFF_SQ_RING);
+    if (ring->ring_ptr == MAP_FAILED) {
+        perror("Error mapping io_uring rings");
+        uring_abort(ring);
+        return -1;
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes_ptr = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                          ring->fd, IORING_OFF_SQES);
+    if (ring->sqes_ptr == MAP_FAILED) {
+        perror("Error mapping io_uring SQEs");
+        munmap(ring->ring_ptr, ring->ring_size);
+        uring_abort(ring);
+        return -1;
+    }
+
+    char* base = ring->ring_ptr;
+    ring->sq_head = (unsigned*)(base + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(base + params.sq_off.tail);
+    ring->sq_array = (unsigned*)(base + params.sq_off.array);
+    ring->sq_mask = *(unsigned*)(base + params.sq_off.ring_mask);
+    ring->sq_entries = params.sq_entries;
+    ring->sqes = ring->sqes_ptr;
+    ring->cq_head = (unsigned*)(base + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(base + params.cq_off.tail);
+    ring->cq_mask = *(unsigned*)(base + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(base + params.cq_off.cqes);
+
+    return 0;
+}
+
+void uring_cleanup(uring_t* ring) {
+    if (!ring || ring->fd < 0) return;
+
+    munmap(ring->sqes_ptr, ring->sqes_size);
+    munmap(ring->ring_ptr, ring->ring_size);
+    close(ring->fd);
+    ring->fd = -1;
+}
+
+// ============================================================================
+// SUBMISSION AND COMPLETION
+// ============================================================================
+
+// Returns a zeroed SQE, or NULL when the submission queue is full
+struct io_uring_sqe* uring_get_sqe(uring_t* ring) {
+    unsigned tail = *ring->sq_tail;
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (tail - head >= ring->sq_entries) return NULL;
+
+    unsigned index = tail & ring->sq_mask;
+    struct io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+
+    // The kernel only reads the SQE on io_uring_enter, after the caller fills it
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->sq_pending++;
+    return sqe;
+}
+
+// Submit every queued SQE in one syscall, optionally waiting for completions
+int uring_submit(uring_t* ring, unsigned wait_nr) {
+    if (ring->sq_pending == 0 && wait_nr == 0) return 0;
+
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+    int submitted = (int)syscall(__NR_io_uring_enter, ring->fd, ring->sq_pending, wait_nr, flags, NULL, 0);
+    if (submitted < 0) return -errno;
+
+    ring->sq_pending -= (unsigned)submitted;
+    return submitted;
+}
+
+struct io_uring_cqe* uring_peek_cqe(uring_t* ring) {
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail) return NULL;
+    return &ring->cqes[head & ring->cq_mask];
+}
+
+void uring_cqe_seen(uring_t* ring) {
+    __atomic_store_n(ring->cq_head, *ring->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+// ============================================================================
+// PROVIDED BUFFERS
+// ============================================================================
+
+int uring_buf_pool_init(uring_t* ring, uring_buf_pool_t* pool, unsigned count, uint16_t group) {
+    if (!ring || !pool || count == 0 || (count & (count - 1)) != 0) return -1;
+
+    memset(pool, 0, sizeof(uring_buf_pool_t));
+    pool->count = count;
+    pool->mask = count - 1;
+
+    // The kernel requires a page-aligned ring
+    pool->ring_size = count * sizeof(struct io_uring_buf);
+    pool->ring = mmap(NULL, pool->ring_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pool->ring == MAP_FAILED) {
+        perror("Error allocating buffer ring");
+        return -1;
+    }
+
+    pool->buffers = malloc((size_t)count * URING_BUF_SIZE);
+    if (!pool->buffers) {
+        munmap(pool->ring, pool->ring_size);
+        return -1;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)pool->ring;
+    reg.ring_entries = count;
+    reg.bgid = group;
+    if (syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        perror("Error registering buffer ring");
+        free(pool->buffers);
+        munmap(pool->ring, pool->ring_size);
+        return -1;
+    }
+
+    for (unsigned i = 0; i < count; i++) {
+        struct io_uring_buf* buf = &pool->ring->bufs[i];
+        buf->addr = (uint64_t)(uintptr_t)(pool->buffers + (size_t)i * URING_BUF_SIZE);
+        buf->len = URING_BUF_SIZE;
+        buf->bid = (uint16_t)i;
+    }
+    pool->tail = (uint16_t)count;
+    __atomic_store_n(&pool->ring->tail, pool->tail, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+void uring_buf_pool_cleanup(uring_t* ring, uring_buf_pool_t* pool, uint16_t group) {
+    if (!ring || !pool || !pool->buffers) return;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.bgid = group;
+    syscall(__NR_io_uring_register, ring->fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+
+    free(pool->buffers);
+    munmap(pool->ring, pool->ring_size);
+    pool->buffers = NULL;
+}
+
+char* uring_buf_pool_get(uring_buf_pool_t* pool, uint16_t bid) {
+    return pool->buffers + (size_t)bid * URING_BUF_SIZE;
+}
+
+// Hand a consumed buffer back to the kernel
+void uring_buf_pool_recycle(uring_buf_pool_t* pool, uint16_t bid) {
+    struct io_uring_buf* buf = &pool->ring->bufs[pool->tail & pool->mask];
+    buf->addr = (uint64_t)(uintptr_t)uring_buf_pool_get(pool, bid);
+    buf->len = URING_BUF_SIZE;
+    buf->bid = bid;
+    pool->tail++;
+    __atomic_store_n(&pool->ring->tail, pool->tail, __ATOMIC_RELEASE);
+}
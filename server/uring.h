@@ -0,0 +1,60 @@
+#ifndef URING_H
+#define URING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <linux/io_uring.h>
+
+// Minimal io_uring wrapper over the raw syscalls (no liburing dependency)
+
+// Ring constants
+#define URING_ENTRIES 4096
+#define URING_BUF_COUNT 4096     // provided receive buffers per ring (power of two)
+#define URING_BUF_SIZE 2048
+#define URING_BUF_GROUP 0
+
+// Submission and completion rings mapped from the kernel
+typedef struct {
+    int fd;
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_array;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned sq_pending;     // SQEs queued since the last io_uring_enter
+    struct io_uring_sqe* sqes;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe* cqes;
+    void* ring_ptr;
+    size_t ring_size;
+    void* sqes_ptr;
+    size_t sqes_size;
+} uring_t;
+
+// Provided buffer ring registered with the kernel for multishot receives
+typedef struct {
+    struct io_uring_buf_ring* ring;
+    size_t ring_size;
+    char* buffers;
+    unsigned count;
+    unsigned mask;
+    uint16_t tail;
+} uring_buf_pool_t;
+
+// Ring functions
+int uring_init(uring_t* ring, unsigned entries);
+void uring_cleanup(uring_t* ring);
+struct io_uring_sqe* uring_get_sqe(uring_t* ring);
+int uring_submit(uring_t* ring, unsigned wait_nr);
+struct io_uring_cqe* uring_peek_cqe(uring_t* ring);
+void uring_cqe_seen(uring_t* ring);
+
+// Provided buffer functions
+int uring_buf_pool_init(uring_t* ring, uring_buf_pool_t* pool, unsigned count, uint16_t group);
+void uring_buf_pool_cleanup(uring_t* ring, uring_buf_pool_t* pool, uint16_t group);
+char* uring_buf_pool_get(uring_buf_pool_t* pool, uint16_t bid);
+void uring_buf_pool_recycle(uring_buf_pool_t* pool, uint16_t bid);
+
+#endif // URING_H
@@ -1,28 +1,28 @@
 #ifndef VEHICLE_H
 #define VEHICLE_H
 
-#include <pthread.h>
+#include <time.h>
+#include <stddef.h>
 
-// Structure for vehicle state
+// Vehicle heading
+typedef enum {
+    DIRECTION_STRAIGHT,
+    DIRECTION_LEFT,
+    DIRECTION_RIGHT
+} vehicle_direction_t;
+
+// Consistent copy of one vehicle's state returned to readers
 typedef struct {
-    int speed;          // km/h (0-100)
-    int battery;        // percentage (0-100)
-    int temperature;    // celsius degrees
-    char direction[20]; // LEFT, RIGHT, STRAIGHT
-    time_t last_update; // timestamp of last battery update
-    pthread_mutex_t mutex;
-} vehicle_state_t;
+    int id;             // fleet index
+    int speed;
+    int battery;
+    int temperature;
+    vehicle_direction_t direction;
+    unsigned long long step;    // simulation step the state is current to
+} vehicle_snapshot_t;
 
-// Vehicle management functions
-void vehicle_init(vehicle_state_t* vehicle);
-void vehicle_cleanup(vehicle_state_t* vehicle);
-void vehicle_get_state(vehicle_state_t* vehicle, int* speed, int* battery, int* temperature, char* direction);
-void vehicle_set_speed(vehicle_state_t* vehicle, int speed);
-void vehicle_set_direction(vehicle_state_t* vehicle, const char* direction);
-int vehicle_speed_up(vehicle_state_t* vehicle);
-int vehicle_slow_down(vehicle_state_t* vehicle);
-void vehicle_update_battery(vehicle_state_t* vehicle);
-void vehicle_recharge_battery(vehicle_state_t* vehicle);
-void vehicle_format_telemetry(vehicle_state_t* vehicle, char* buffer, size_t buffer_size);
+// Formatting functions
+void vehicle_format_snapshot(const vehicle_snapshot_t* snapshot, time_t timestamp, char* buffer, size_t buffer_size);
+const char* vehicle_direction_to_string(vehicle_direction_t direction);
 
 #endif // VEHICLE_H
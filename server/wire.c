@@ -0,0 +1,168 @@
+#include "wire.h"
+#include <string.h>
+
+// ============================================================================
+// LITTLE-ENDIAN HELPERS
+// ============================================================================
+
+static void wire_put_u16(unsigned char* out, unsigned value) {
+    out[0] = (unsigned char)(value & 0xFF);
+    out[1] = (unsigned char)((value >> 8) & 0xFF);
+}
+
+static void wire_put_u32(unsigned char* out, unsigned long value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+static void wire_put_i64(unsigned char* out, long long value) {
+    unsigned long long bits = (unsigned long long)value;
+    for (int i = 0; i < 8; i++) {
+        out[i] = (unsigned char)(bits >> (8 * i));
+    }
+}
+
+// ============================================================================
+// ENCODING FUNCTIONS
+// ============================================================================
+
+size_t wire_encode_header(unsigned char* out, wire_frame_type_t type, unsigned tag, size_t length) {
+    if (!out) return 0;
+
+    out[0] = (unsigned char)type;
+    out[1] = (unsigned char)tag;
+    wire_put_u16(out + 2, (unsigned)length);
+    return WIRE_HEADER_SIZE;
+}
+
+// Fills out with WIRE_TELEMETRY_FRAME_SIZE bytes
+size_t wire_encode_telemetry(const vehicle_snapshot_t* snapshot, time_t timestamp, unsigned char* out) {
+    if (!snapshot || !out) return 0;
+
+    unsigned char* payload = out + wire_encode_header(out, WIRE_FRAME_TELEMETRY, 0, WIRE_TELEMETRY_PAYLOAD);
+    wire_put_u16(payload, (unsigned)snapshot->speed);
+    payload[2] = (unsigned char)snapshot->battery;
+    payload[3] = (unsigned char)(signed char)snapshot->temperature;
+    payload[4] = (unsigned char)snapshot->direction;
+    payload[5] = (unsigned char)(snapshot->id & 0xFF);
+    payload[6] = (unsigned char)((snapshot->id >> 8) & 0xFF);
+    payload[7] = (unsigned char)((snapshot->id >> 16) & 0xFF);
+    wire_put_i64(payload + 8, (long long)timestamp);
+    return WIRE_TELEMETRY_FRAME_SIZE;
+}
+
+// Fills out with at most WIRE_DELTA_FRAME_MAX bytes
+size_t wire_encode_delta(unsigned fields, const vehicle_snapshot_t* snapshot, unsigned char* out) {
+    if (!snapshot || !out) return 0;
+
+    unsigned char* payload = out + WIRE_HEADER_SIZE;
+    size_t length = 0;
+    if (fields & WIRE_DELTA_SPEED) {
+        wire_put_u16(payload, (unsigned)snapshot->speed);
+        length += 2;
+    }
+    if (fields & WIRE_DELTA_BATTERY) payload[length++] = (unsigned char)snapshot->battery;
+    if (fields & WIRE_DELTA_TEMPERATURE) payload[length++] = (unsigned char)(signed char)snapshot->temperature;
+    if (fields & WIRE_DELTA_DIRECTION) payload[length++] = (unsigned char)snapshot->direction;
+
+    wire_encode_header(out, WIRE_FRAME_DELTA, fields, length);
+    return WIRE_HEADER_SIZE + length;
+}
+
+// Text is truncated to fit size. Returns the frame length.
+size_t wire_encode_response(unsigned tag, const char* text, size_t length, unsigned char* out, size_t size) {
+    if (!text || !out || size < WIRE_HEADER_SIZE) return 0;
+
+    if (length > size - WIRE_HEADER_SIZE) length = size - WIRE_HEADER_SIZE;
+    if (length > 0xFFFF) length = 0xFFFF;
+    wire_encode_header(out, WIRE_FRAME_RESPONSE, tag, length);
+    memcpy(out + WIRE_HEADER_SIZE, text, length);
+    return WIRE_HEADER_SIZE + length;
+}
+
+// Columns rather than points, so each field compresses and scans on its own.
+// Returns the frame length, 0 if it does not fit size.
+size_t wire_encode_history(const history_range_t* range, const history_point_t* points, unsigned char* out,
+                           size_t size) {
+    if (!range || !out || range->count < 0 || (range->count > 0 && !points)) return 0;
+
+    size_t count = (size_t)range->count;
+    size_t length = WIRE_HISTORY_HEADER + count * WIRE_HISTORY_POINT_SIZE;
+    if (length > 0xFFFF || WIRE_HEADER_SIZE + length > size) return 0;
+
+    unsigned char* payload = out + wire_encode_header(out, WIRE_FRAME_HISTORY, 0, length);
+    wire_put_i64(payload, range->from_ms);
+    wire_put_u32(payload + 8, (unsigned long)range->step_ms);
+    wire_put_u16(payload + 12, (unsigned)count);
+
+    unsigned char* speed = payload + WIRE_HISTORY_HEADER;
+    unsigned char* battery = speed + 2 * count;
+    unsigned char* temperature = battery + count;
+    unsigned char* direction = temperature + count;
+    for (size_t i = 0; i < count; i++) {
+        wire_put_u16(speed + 2 * i, (unsigned)points[i].speed);
+        battery[i] = (unsigned char)points[i].battery;
+        temperature[i] = (unsigned char)(signed char)points[i].temperature;
+        direction[i] = (unsigned char)points[i].direction;
+    }
+    return WIRE_HEADER_SIZE + length;
+}
+
+// ============================================================================
+// DECODING FUNCTIONS
+// ============================================================================
+
+size_t wire_payload_length(const unsigned char* header) {
+    if (!header) return 0;
+    return (size_t)header[2] | ((size_t)header[3] << 8);
+}
+
+// Params are views into frame. Returns -1 if the frame is not a whole COMMAND
+// frame; an unknown opcode parses as CMD_UNKNOWN.
+int wire_decode_command(const unsigned char* frame, size_t length, parsed_command_t* parsed) {
+    if (!frame || !parsed || length < WIRE_HEADER_SIZE) return -1;
+    if (frame[0] != WIRE_FRAME_COMMAND || length != WIRE_HEADER_SIZE + wire_payload_length(frame)) {
+        return -1;
+    }
+
+    protocol_parse_args(parsed, wire_opcode_to_command(frame[1]),
+                        (const char*)frame + WIRE_HEADER_SIZE, length - WIRE_HEADER_SIZE);
+    return 0;
+}
+
+// ============================================================================
+// OPCODE MAPPING
+// ============================================================================
+
+wire_opcode_t wire_command_to_opcode(command_type_t type) {
+    switch (type) {
+        case CMD_AUTH: return WIRE_OP_AUTH;
+        case CMD_GET_DATA: return WIRE_OP_GET_DATA;
+        case CMD_SEND_CMD: return WIRE_OP_SEND_CMD;
+        case CMD_LIST_USERS: return WIRE_OP_LIST_USERS;
+        case CMD_RECHARGE: return WIRE_OP_RECHARGE;
+        case CMD_DISCONNECT: return WIRE_OP_DISCONNECT;
+        case CMD_PROTOCOL: return WIRE_OP_PROTOCOL;
+        case CMD_SUBSCRIBE: return WIRE_OP_SUBSCRIBE;
+        case CMD_GET_HISTORY: return WIRE_OP_GET_HISTORY;
+        case CMD_RESUME: return WIRE_OP_RESUME;
+        default: return WIRE_OP_NONE;
+    }
+}
+
+command_type_t wire_opcode_to_command(unsigned opcode) {
+    switch (opcode) {
+        case WIRE_OP_AUTH: return CMD_AUTH;
+        case WIRE_OP_GET_DATA: return CMD_GET_DATA;
+        case WIRE_OP_SEND_CMD: return CMD_SEND_CMD;
+        case WIRE_OP_LIST_USERS: return CMD_LIST_USERS;
+        case WIRE_OP_RECHARGE: return CMD_RECHARGE;
+        case WIRE_OP_DISCONNECT: return CMD_DISCONNECT;
+        case WIRE_OP_PROTOCOL: return CMD_PROTOCOL;
+        case WIRE_OP_SUBSCRIBE: return CMD_SUBSCRIBE;
+        case WIRE_OP_GET_HISTORY: return CMD_GET_HISTORY;
+        case WIRE_OP_RESUME: return CMD_RESUME;
+        default: return CMD_UNKNOWN;
+    }
+}
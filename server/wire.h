@@ -0,0 +1,86 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <stddef.h>
+#include <time.h>
+#include "vehicle.h"
+#include "history.h"
+#include "protocol_parser.h"
+
+// Binary wire protocol, entered with "PROTOCOL: BINARY 1" on a text connection
+// and left with a PROTOCOL frame carrying "TEXT". All integers little-endian.
+//
+//   frame header  <u8 type> <u8 tag> <u16 payload length>
+//   COMMAND       tag = opcode, payload = the params of the text command
+//                 ("admin admin123", "SPEED_UP", empty for GET_DATA)
+//   RESPONSE      tag = opcode answered, payload = the text response without
+//                 its terminator ("OK: Speed increased to 10 km/h")
+//   TELEMETRY     tag = 0, fixed 16-byte payload:
+//                 <u16 speed> <u8 battery> <i8 temperature> <u8 direction>
+//                 <u24 vehicle id> <i64 unix timestamp>
+//   DELTA         tag = mask of the fields that changed since the previous
+//                 frame (WIRE_DELTA_*); payload = those fields, in TELEMETRY
+//                 order and sizes. An empty DELTA is a heartbeat.
+//   HISTORY       tag = 0, answers GET_HISTORY: <i64 unix ms of the first
+//                 point> <u32 ms between points> <u16 count>, then one
+//                 column per field: count x u16 speed, u8 battery,
+//                 i8 temperature, u8 direction
+//
+// GET_DATA is answered with a TELEMETRY frame. Delta subscribers (SUBSCRIBE:
+// <hz> DELTA) get a TELEMETRY keyframe first and DELTA frames after it.
+
+#define WIRE_VERSION 1
+#define WIRE_HEADER_SIZE 4
+#define WIRE_TELEMETRY_PAYLOAD 16
+#define WIRE_TELEMETRY_FRAME_SIZE (WIRE_HEADER_SIZE + WIRE_TELEMETRY_PAYLOAD)
+#define WIRE_DELTA_FRAME_MAX (WIRE_HEADER_SIZE + 5)
+#define WIRE_HISTORY_HEADER 14
+#define WIRE_HISTORY_POINT_SIZE 5
+
+// DELTA frame tag bits
+#define WIRE_DELTA_SPEED 0x01
+#define WIRE_DELTA_BATTERY 0x02
+#define WIRE_DELTA_TEMPERATURE 0x04
+#define WIRE_DELTA_DIRECTION 0x08
+
+// Frame types
+typedef enum {
+    WIRE_FRAME_COMMAND = 1,
+    WIRE_FRAME_RESPONSE = 2,
+    WIRE_FRAME_TELEMETRY = 3,
+    WIRE_FRAME_DELTA = 4,
+    WIRE_FRAME_HISTORY = 5
+} wire_frame_type_t;
+
+// Command opcodes (frame tag); stable on the wire, unlike command_type_t
+typedef enum {
+    WIRE_OP_NONE = 0,
+    WIRE_OP_AUTH = 1,
+    WIRE_OP_GET_DATA = 2,
+    WIRE_OP_SEND_CMD = 3,
+    WIRE_OP_LIST_USERS = 4,
+    WIRE_OP_RECHARGE = 5,
+    WIRE_OP_DISCONNECT = 6,
+    WIRE_OP_PROTOCOL = 7,
+    WIRE_OP_SUBSCRIBE = 8,
+    WIRE_OP_GET_HISTORY = 9,
+    WIRE_OP_RESUME = 10
+} wire_opcode_t;
+
+// Encoding functions
+size_t wire_encode_header(unsigned char* out, wire_frame_type_t type, unsigned tag, size_t length);
+size_t wire_encode_telemetry(const vehicle_snapshot_t* snapshot, time_t timestamp, unsigned char* out);
+size_t wire_encode_delta(unsigned fields, const vehicle_snapshot_t* snapshot, unsigned char* out);
+size_t wire_encode_response(unsigned tag, const char* text, size_t length, unsigned char* out, size_t size);
+size_t wire_encode_history(const history_range_t* range, const history_point_t* points, unsigned char* out,
+                           size_t size);
+
+// Decoding functions
+size_t wire_payload_length(const unsigned char* header);
+int wire_decode_command(const unsigned char* frame, size_t length, parsed_command_t* parsed);
+
+// Opcode mapping
+wire_opcode_t wire_command_to_opcode(command_type_t type);
+command_type_t wire_opcode_to_command(unsigned opcode);
+
+#endif // WIRE_H